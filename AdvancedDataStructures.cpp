@@ -2,72 +2,392 @@
 #include <cstdint>
 #include <vector>
 #include <string>
-#include <fstream>
 #include <utility>
 #include <chrono>
+#include <cstdlib>
+#include <climits>
+#include <functional>
+#include <memory>
 #include "RMQ/CartesianRMQ.h"
+#include "RMQ/SuccinctRMQ.h"
+#include "RMQ/HierarchicalRMQ.h"
+#include "RMQ/StreamingRMQ.h"
 #include "Predecessor/YTrie.h"
+#include "Predecessor/StaticPredecessor.h"
+#include "Predecessor/ShardedYTrie.h"
+#include "Util/Parallel.h"
+#include "Util/Profile.h"
+#include "Util/QueryCache.h"
+#include "IO/InputParser.h"
+#include "IO/AnswerWriter.h"
+#include "IO/QueryServer.h"
 #include "malloc_count/malloc_count.h" // Use of external library was allowed via mail on the 3. of june.
 
-void readInPredecessorFile(std::string path, std::vector<uint64_t>* values, std::vector<uint64_t>* queries) {
-	std::ifstream file(path);
-	uint64_t length, readValue;
-	file >> length;
-	// Read in all the values on which the data structure is built,
-	for (uint64_t i = 0; i < length; i++) {
-		file >> readValue;
-		values->push_back(readValue);
-	}
-	// Read in all the queries.
-	while (file >> readValue) {
-		queries->push_back(readValue);
+// Largest "--block-size" of the CartesianRMQ and the StreamingRMQ, and of the macro blocks of the HierarchicalRMQ (256 micro blocks of 64 numbers).
+const uint64_t MAX_BLOCK_SIZE = 32;
+const uint64_t MAX_MACRO_SIZE = 256 * 64;
+
+/**
+* Prints the error and how the program is called to the error output. Returns the exit code for a wrong call.
+*/
+int usageError(std::string error) {
+	std::cerr << "ads_programm: " << error << std::endl;
+	std::cerr << "Usage: ads_programm [pd|pd-static|pd-sharded|rmq] input_file output_file [options], the options are listed in README.md." << std::endl;
+	return 1;
+}
+
+/**
+* Parses a whole argument as unsigned decimal number. Returns false, if it is empty or contains anything else.
+*/
+bool parseNumber(const char* argument, uint64_t* number) {
+	char* end;
+	*number = std::strtoull(argument, &end, 10);
+	return *end == '\0' && argument[0] != '\0';
+}
+
+/**
+* Reads the optional arguments following the three positional ones.
+* Returns false, if an unknown or malformed option is found.
+*
+* Supported options:
+* --threads N  Parses the input, builds the rmq data structure, answers the queries and formats the answers on N threads. 0 uses all hardware threads. Default is 1.
+* --save PATH  Writes a snapshot of the built data structure to PATH.
+* --load PATH  Loads the data structure from the snapshot at PATH instead of building it. The values in the input file are ignored then.
+* --succinct   Uses the SuccinctRMQ with 2n + o(n) bits for "rmq", which does not keep the numbers. Snapshots are written and loaded for it then.
+* --scan-threshold N  "rmq" queries over at most N numbers scan the numbers directly. 0 never scans. The default is measured for random queries (see CartesianRMQ).
+* --hierarchical  Uses the HierarchicalRMQ with micro and macro blocks for "rmq". Snapshots are written and loaded for it then.
+* --block-size N  Builds "rmq" with N numbers per block, at most MAX_BLOCK_SIZE. For the HierarchicalRMQ, this is the size of the macro blocks, at most MAX_MACRO_SIZE. 0 keeps the default.
+* --linear-blocks  Answers the queries over whole blocks of the default "rmq" data structure with a LinearRMQ instead of the larger LogRMQ.
+* --lazy-blocks  Computes the in-block answers of the default "rmq" data structure the first time a query touches a block, instead of for all blocks during construction.
+* --streaming  Builds "rmq" as a StreamingRMQ by appending the numbers, which can grow at the end without a rebuild. Snapshots are written and loaded for it then.
+* --serve PATH  After answering the queries of the input file, keeps the data structure and answers requests on the Unix domain socket at PATH until SIGINT or SIGTERM (see IO/QueryServer.h).
+*               The answers to the input file are written when the server stops, and the reported time includes the time serving.
+* --cache N  Looks the queries up in a QueryCache with N entries in front of the data structure, which all threads and server requests share (see Util/QueryCache.h). 0 uses none. Default is 0.
+* --dedup  Sorts each batch of queries (a chunk per thread, or a server request) and answers every distinct query in it only once.
+* --profile PATH  Writes the time and heap memory of every phase of the run as JSON to PATH (see Util/Profile.h).
+* --packed-buckets  Stores the buckets of the tries of "pd" and "pd-sharded" as bit packed deltas instead of binary search trees, which takes less memory for dense keys.
+* --shards N  Splits the trie of "pd-sharded" into N shards, rounded up to a power of two. 0 uses one per thread, but at least one per NUMA node. Default is 0.
+*/
+bool readOptions(int argc, const char** argv, uint64_t* threads, std::string* savePath, std::string* loadPath, bool* succinct, uint64_t* scanThreshold, bool* hierarchical, uint64_t* blockSize,
+	bool* linearBlocks, std::string* profilePath, uint64_t* shards, bool* packedBuckets, bool* lazyBlocks, bool* streaming, std::string* servePath, uint64_t* cacheSize, bool* deduplicate) {
+	for (int i = 4; i < argc; i++) {
+		std::string option = std::string(argv[i]);
+		if (option == "--threads" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], threads)) {
+				return false;
+			}
+		}
+		else if (option == "--scan-threshold" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], scanThreshold)) {
+				return false;
+			}
+		}
+		else if (option == "--shards" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], shards)) {
+				return false;
+			}
+		}
+		else if (option == "--cache" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], cacheSize)) {
+				return false;
+			}
+		}
+		else if (option == "--block-size" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], blockSize)) {
+				return false;
+			}
+		}
+		else if (option == "--save" && i + 1 < argc) {
+			*savePath = std::string(argv[++i]);
+		}
+		else if (option == "--load" && i + 1 < argc) {
+			*loadPath = std::string(argv[++i]);
+		}
+		else if (option == "--serve" && i + 1 < argc) {
+			*servePath = std::string(argv[++i]);
+		}
+		else if (option == "--profile" && i + 1 < argc) {
+			*profilePath = std::string(argv[++i]);
+		}
+		else if (option == "--succinct") {
+			*succinct = true;
+		}
+		else if (option == "--hierarchical") {
+			*hierarchical = true;
+		}
+		else if (option == "--linear-blocks") {
+			*linearBlocks = true;
+		}
+		else if (option == "--packed-buckets") {
+			*packedBuckets = true;
+		}
+		else if (option == "--lazy-blocks") {
+			*lazyBlocks = true;
+		}
+		else if (option == "--streaming") {
+			*streaming = true;
+		}
+		else if (option == "--dedup") {
+			*deduplicate = true;
+		}
+		else {
+			return false;
+		}
 	}
+	return true;
+}
+
+/**
+* Builds a predecessor data structure from the sorted values. The tries below also take the packed buckets option, the ShardedYTrie is also built on the given threads.
+*/
+template <typename Predecessor, typename Key>
+Predecessor* buildPredecessor(const std::vector<Key>& values, uint64_t /*threads*/, uint64_t /*shards*/, bool /*packedBuckets*/, const Predecessor*) {
+	return new Predecessor(values);
+}
+
+template <typename Key>
+YTrie<Key>* buildPredecessor(const std::vector<Key>& values, uint64_t /*threads*/, uint64_t /*shards*/, bool packedBuckets, const YTrie<Key>*) {
+	return new YTrie<Key>(values, packedBuckets);
+}
+
+template <typename Key>
+ShardedYTrie<Key>* buildPredecessor(const std::vector<Key>& values, uint64_t threads, uint64_t shards, bool packedBuckets, const ShardedYTrie<Key>*) {
+	return new ShardedYTrie<Key>(values, threads, shards, packedBuckets);
 }
 
-void readInRMQFile(std::string path, std::vector<uint64_t>* values, std::vector<std::pair<uint64_t, uint64_t>>* queries) {
-	std::ifstream file(path);
-	uint64_t length, readValue;
-	std::pair<uint64_t, uint64_t> readPair;
-	file >> length;
-	// Read in all the values on which the data structure is built,
-	for (uint64_t i = 0; i < length; i++) {
-		file >> readValue;
-		values->push_back(readValue);
-	}
-	// Read in all the queries.
-	std::string line;
-	while (file >> line ) {
-		size_t splitpoint = line.find(",");
-		std::string tokenOne = line.substr(0, splitpoint);
-		std::string tokenTwo = line.substr(splitpoint + 1, line.length());
-		queries->push_back({ std::stoull(tokenOne), std::stoull(tokenTwo) });
+/**
+* Answers a batch of queries with answer, the batch query of a data structure.
+* If deduplicate is set, every distinct query of the batch is answered only once, and if there is a cache, the queries are looked up in it first.
+* Query is not deduced from answer, so it has to be given explicitly when answer is a lambda.
+*/
+template <typename Query>
+void answerBatch(const Query* queries, size_t n, uint64_t* out, bool deduplicate, QueryCache<Query>* cache, const std::function<void(const Query*, size_t, uint64_t*)>& answer) {
+	std::function<void(const Query*, size_t, uint64_t*)> cachedAnswer = answer;
+	if (cache != nullptr) {
+		cachedAnswer = [cache, &answer](const Query* batch, size_t length, uint64_t* batchOut) {
+			cache->answerQueries(batch, length, batchOut, answer);
+		};
+	}
+	if (deduplicate) {
+		answerUnique(queries, n, out, cachedAnswer);
+	}
+	else {
+		cachedAnswer(queries, n, out);
 	}
 }
 
-void writeAnswerFile(std::string path, std::vector<uint64_t>* answers) {
-	std::ofstream file(path);
-	for (uint64_t i = 0; i < answers->size(); i++) {
-		file << answers->at(i) << std::endl;
+/**
+* Answers all predecessor queries on the given threads.
+* Every thread answers a contiguous chunk, so the finger search of the YTrie still works within the chunk.
+*/
+template <typename Predecessor>
+void getAllPredecessors(const Predecessor* predecessor, const std::vector<uint64_t>& queries, std::vector<uint64_t>* answers, uint64_t threads, bool deduplicate,
+	QueryCache<uint64_t>* cache) {
+	parallelFor(queries.size(), threads, [&](uint64_t begin, uint64_t end) {
+		answerBatch<uint64_t>(queries.data() + begin, end - begin, answers->data() + begin, deduplicate, cache, [predecessor](const uint64_t* batch, size_t n, uint64_t* out) {
+			predecessor->getPredecessors(batch, n, out);
+		});
+	});
+}
+
+/**
+* The ShardedYTrie groups the queries by shard instead, so every shard is only queried from its own NUMA node.
+* The cache and the deduplication hand the misses over in small parts, too small to spread over the threads again.
+* So with them every thread answers a chunk as above, and the misses of a part are answered by one sequential batch query.
+*/
+template <typename Key>
+void getAllPredecessors(const ShardedYTrie<Key>* predecessor, const std::vector<uint64_t>& queries, std::vector<uint64_t>* answers, uint64_t threads, bool deduplicate,
+	QueryCache<uint64_t>* cache) {
+	if (cache == nullptr && !deduplicate) {
+		predecessor->getPredecessorsLocal(queries.data(), queries.size(), answers->data(), threads);
+		return;
 	}
-	file.close();
+	parallelFor(queries.size(), threads, [&](uint64_t begin, uint64_t end) {
+		answerBatch<uint64_t>(queries.data() + begin, end - begin, answers->data() + begin, deduplicate, cache, [predecessor](const uint64_t* batch, size_t n, uint64_t* out) {
+			predecessor->getPredecessors(batch, n, out);
+		});
+	});
+}
+
+/**
+* Saves the predecessor data structure if requested, answers all predecessor queries on it and then serves requests on servePath, if given.
+* With a cacheSize, the file queries and the server requests share one QueryCache.
+* Returns false, if the data structure could not be saved or the server could not be started.
+*/
+template <typename Predecessor>
+bool answerPredecessorQueries(const Predecessor* predecessor, const std::vector<uint64_t>& queries, std::vector<uint64_t>* answers, uint64_t threads, std::string savePath, std::string servePath,
+	uint64_t cacheSize, bool deduplicate) {
+	if (!savePath.empty()) {
+		beginPhase("save");
+		bool saved = predecessor->save(savePath);
+		endPhase();
+		if (!saved) {
+			return false;
+		}
+	}
+	std::unique_ptr<QueryCache<uint64_t>> cache(cacheSize == 0 ? nullptr : new QueryCache<uint64_t>(cacheSize));
+	beginPhase("query");
+	answers->resize(queries.size());
+	getAllPredecessors(predecessor, queries, answers, threads, deduplicate, cache.get());
+	endPhase();
+	if (!servePath.empty()) {
+		// Every request is answered by one worker, so the finger search works within the request.
+		QueryCache<uint64_t>* sharedCache = cache.get();
+		QueryServer<uint64_t> server(servePath, threads, [predecessor, deduplicate, sharedCache](const uint64_t* requestQueries, size_t n, uint64_t* out) {
+			answerBatch<uint64_t>(requestQueries, n, out, deduplicate, sharedCache, [predecessor](const uint64_t* batch, size_t length, uint64_t* batchOut) {
+				predecessor->getPredecessors(batch, length, batchOut);
+			});
+		});
+		return server.run();
+	}
+	return true;
+}
+
+/**
+* Builds the predecessor data structure, or loads it if loadPath is given, answers all queries on it and serves requests on servePath, if given.
+* 32 bit keys are used whenever all values fit, UINT32_MAX itself is reserved for missing answers. Loading tries 32 bit keys first.
+* Returns false, if the data structure could not be loaded or saved, or the server could not be started.
+*/
+template <template <typename> class Predecessor>
+bool buildAndAnswerPredecessors(const std::vector<uint64_t>& values, const std::vector<uint64_t>& queries, std::vector<uint64_t>* answers, uint64_t threads, std::string savePath,
+	std::string loadPath, uint64_t shards, bool packedBuckets, std::string servePath, uint64_t cacheSize, bool deduplicate) {
+	Predecessor<uint32_t> *narrowPredecessor = nullptr;
+	Predecessor<uint64_t> *widePredecessor = nullptr;
+	beginPhase(loadPath.empty() ? "build" : "load");
+	if (!loadPath.empty()) {
+		narrowPredecessor = Predecessor<uint32_t>::load(loadPath);
+		if (narrowPredecessor == nullptr) {
+			widePredecessor = Predecessor<uint64_t>::load(loadPath);
+		}
+	}
+	else if (values.empty() || values.back() < UINT32_MAX) {
+		narrowPredecessor = buildPredecessor(std::vector<uint32_t>(values.begin(), values.end()), threads, shards, packedBuckets, narrowPredecessor);
+	}
+	else {
+		widePredecessor = buildPredecessor(values, threads, shards, packedBuckets, widePredecessor);
+	}
+	endPhase();
+	return narrowPredecessor != nullptr ? answerPredecessorQueries(narrowPredecessor, queries, answers, threads, savePath, servePath, cacheSize, deduplicate)
+		: widePredecessor != nullptr && answerPredecessorQueries(widePredecessor, queries, answers, threads, savePath, servePath, cacheSize, deduplicate);
+}
+
+/**
+* Saves the rmq data structure if requested, answers all range minimum queries on it and then serves requests on servePath, if given.
+* With a cacheSize, the file queries and the server requests share one QueryCache.
+* Returns false, if the data structure is missing, could not be saved or the server could not be started.
+*/
+template <typename RMQ>
+bool answerRangeMinimumQueries(const RMQ* rmq, const std::vector<std::pair<uint64_t, uint64_t>>& queries, std::vector<uint64_t>* answers, uint64_t threads, std::string savePath,
+	std::string servePath, uint64_t cacheSize, bool deduplicate) {
+	if (rmq == nullptr) {
+		return false;
+	}
+	if (!savePath.empty()) {
+		beginPhase("save");
+		bool saved = rmq->save(savePath);
+		endPhase();
+		if (!saved) {
+			return false;
+		}
+	}
+	typedef std::pair<uint64_t, uint64_t> Range;
+	std::unique_ptr<QueryCache<Range>> cache(cacheSize == 0 ? nullptr : new QueryCache<Range>(cacheSize));
+	QueryCache<Range>* sharedCache = cache.get();
+	std::function<void(const Range*, size_t, uint64_t*)> answer = [rmq](const Range* batch, size_t n, uint64_t* out) {
+		rmq->rangeMinimumQueries(batch, n, out);
+	};
+	beginPhase("query");
+	answers->resize(queries.size());
+	parallelFor(queries.size(), threads, [&](uint64_t begin, uint64_t end) {
+		answerBatch(queries.data() + begin, end - begin, answers->data() + begin, deduplicate, sharedCache, answer);
+	});
+	endPhase();
+	if (!servePath.empty()) {
+		QueryServer<Range> server(servePath, threads, [deduplicate, sharedCache, answer](const Range* requestQueries, size_t n, uint64_t* out) {
+			answerBatch(requestQueries, n, out, deduplicate, sharedCache, answer);
+		});
+		return server.run();
+	}
+	return true;
 }
 
 int runProgram(int argc, const char** argv) {
+	if (argc < 4) {
+		return 1;
+	}
 	std::string selection = std::string(argv[1]);
 	std::string inputFile = std::string(argv[2]);
 	std::string outputFile = std::string(argv[3]);
+	uint64_t threads = 1;
+	std::string savePath;
+	std::string loadPath;
+	bool succinct = false;
+	uint64_t scanThreshold = ULLONG_MAX; // Keeps the default.
+	bool hierarchical = false;
+	uint64_t blockSize = 0;
+	bool linearBlocks = false;
+	std::string profilePath;
+	uint64_t shards = 0;
+	bool packedBuckets = false;
+	bool lazyBlocks = false;
+	bool streaming = false;
+	std::string servePath;
+	uint64_t cacheSize = 0;
+	bool deduplicate = false;
+	if (!readOptions(argc, argv, &threads, &savePath, &loadPath, &succinct, &scanThreshold, &hierarchical, &blockSize, &linearBlocks, &profilePath, &shards, &packedBuckets, &lazyBlocks, &streaming,
+		&servePath, &cacheSize, &deduplicate)) {
+		return usageError("unknown or malformed option");
+	}
+	if (selection != "rmq" && (succinct || hierarchical || streaming || blockSize != 0 || linearBlocks || lazyBlocks || scanThreshold != ULLONG_MAX)) {
+		return usageError("--succinct, --hierarchical, --streaming, --block-size, --linear-blocks, --lazy-blocks and --scan-threshold are only used by rmq");
+	}
+	if (shards != 0 && selection != "pd-sharded") {
+		return usageError("--shards is only used by pd-sharded");
+	}
+	if (packedBuckets && selection != "pd" && selection != "pd-sharded") {
+		return usageError("--packed-buckets is only used by pd and pd-sharded");
+	}
+	if ((int)succinct + (int)hierarchical + (int)streaming > 1) {
+		return usageError("only one of --succinct, --hierarchical and --streaming can be given");
+	}
+	if (succinct && (blockSize != 0 || linearBlocks || lazyBlocks || scanThreshold != ULLONG_MAX)) {
+		return usageError("--succinct has no blocks and never scans, so it takes no --block-size, --linear-blocks, --lazy-blocks or --scan-threshold");
+	}
+	if ((hierarchical || streaming) && (linearBlocks || lazyBlocks)) {
+		return usageError("--linear-blocks and --lazy-blocks are only used by the default rmq data structure");
+	}
+	if (hierarchical && scanThreshold != ULLONG_MAX) {
+		return usageError("--hierarchical never scans, so it takes no --scan-threshold");
+	}
+	if (blockSize > (hierarchical ? MAX_MACRO_SIZE : MAX_BLOCK_SIZE)) {
+		return usageError("--block-size must be at most " + std::to_string(hierarchical ? MAX_MACRO_SIZE : MAX_BLOCK_SIZE) + (hierarchical ? " with --hierarchical" : ""));
+	}
+	if (!profilePath.empty()) {
+		enableProfile();
+	}
+	uint64_t queryCount;
 	std::chrono::milliseconds duration;
 	size_t memory;
 	std::vector<uint64_t> values;
 	std::vector<uint64_t> *answers = new std::vector<uint64_t>();
-	if (selection == "pd") {
+	if (selection == "pd" || selection == "pd-static" || selection == "pd-sharded") {
 		std::vector<uint64_t> queries;
-		readInPredecessorFile(inputFile, &values, &queries);
+		beginPhase("parse");
+		bool parsed = readPredecessorInput(inputFile, &values, &queries, threads);
+		endPhase();
+		if (!parsed) {
+			return 1;
+		}
+		queryCount = queries.size();
 		auto startTiming = std::chrono::high_resolution_clock::now();
-		// Now build the datastructure and answer all queries.
-		YTrie *predecessor = new YTrie(values);
-		for (uint64_t i = 0; i < queries.size(); i++) {
-			answers->push_back(predecessor->getPredecessor(queries[i]));
+		// Now build or load the datastructure and answer all queries.
+		// "pd-static" uses the StaticPredecessor, which can't be updated, but searches without hash tables.
+		// "pd-sharded" splits the YTrie into shards by key range, which are built and queried on the NUMA node they belong to.
+		bool answered = selection == "pd" ? buildAndAnswerPredecessors<YTrie>(values, queries, answers, threads, savePath, loadPath, shards, packedBuckets, servePath, cacheSize, deduplicate)
+			: selection == "pd-static" ? buildAndAnswerPredecessors<StaticPredecessor>(values, queries, answers, threads, savePath, loadPath, shards, packedBuckets, servePath, cacheSize, deduplicate)
+			: buildAndAnswerPredecessors<ShardedYTrie>(values, queries, answers, threads, savePath, loadPath, shards, packedBuckets, servePath, cacheSize, deduplicate);
+		if (!answered) {
+			return 1;
 		}
 		auto endTiming = std::chrono::high_resolution_clock::now();
 		duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTiming- startTiming);
@@ -75,12 +395,49 @@ int runProgram(int argc, const char** argv) {
 	}
 	else if (selection == "rmq") {
 		std::vector<std::pair<uint64_t, uint64_t>> queries;
-		readInRMQFile(inputFile, &values, &queries);
+		beginPhase("parse");
+		bool parsed = readRMQInput(inputFile, &values, &queries, threads);
+		endPhase();
+		if (!parsed) {
+			return 1;
+		}
+		queryCount = queries.size();
 		auto startTiming = std::chrono::high_resolution_clock::now();
-		// Now build the datastructure and answer all queries.
-		CartesianRMQ *rmq = new CartesianRMQ(values);
-		for (uint64_t i = 0; i < queries.size(); i++) {
-			answers->push_back(rmq->rangeMinimumQuery(queries[i].first, queries[i].second));
+		// Now build or load the datastructure and answer all queries.
+		bool answered;
+		beginPhase(loadPath.empty() ? "build" : "load");
+		if (succinct) {
+			SuccinctRMQ *rmq = loadPath.empty() ? new SuccinctRMQ(values.data(), values.size(), threads) : SuccinctRMQ::load(loadPath);
+			std::vector<uint64_t>().swap(values); // The numbers are not needed for the queries, so they are freed before answering.
+			endPhase();
+			answered = answerRangeMinimumQueries(rmq, queries, answers, threads, savePath, servePath, cacheSize, deduplicate);
+		}
+		else if (hierarchical) {
+			HierarchicalRMQ<uint64_t> *rmq = loadPath.empty() ? new HierarchicalRMQ<uint64_t>(std::move(values), threads, blockSize) : HierarchicalRMQ<uint64_t>::load(loadPath);
+			endPhase();
+			answered = answerRangeMinimumQueries(rmq, queries, answers, threads, savePath, servePath, cacheSize, deduplicate);
+		}
+		else if (streaming) {
+			StreamingRMQ<uint64_t> *rmq = loadPath.empty() ? new StreamingRMQ<uint64_t>(blockSize) : StreamingRMQ<uint64_t>::load(loadPath);
+			if (rmq != nullptr && loadPath.empty()) {
+				rmq->appendBatch(values.data(), values.size());
+			}
+			if (rmq != nullptr && scanThreshold != ULLONG_MAX) {
+				rmq->setScanThreshold(scanThreshold);
+			}
+			endPhase();
+			answered = answerRangeMinimumQueries(rmq, queries, answers, threads, savePath, servePath, cacheSize, deduplicate);
+		}
+		else {
+			CartesianRMQ<uint64_t> *rmq = loadPath.empty() ? new CartesianRMQ<uint64_t>(std::move(values), threads, blockSize, linearBlocks, lazyBlocks) : CartesianRMQ<uint64_t>::load(loadPath);
+			if (rmq != nullptr && scanThreshold != ULLONG_MAX) {
+				rmq->setScanThreshold(scanThreshold);
+			}
+			endPhase();
+			answered = answerRangeMinimumQueries(rmq, queries, answers, threads, savePath, servePath, cacheSize, deduplicate);
+		}
+		if (!answered) {
+			return 1;
 		}
 		auto endTiming = std::chrono::high_resolution_clock::now();
 		duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTiming- startTiming);
@@ -90,7 +447,12 @@ int runProgram(int argc, const char** argv) {
 		return 1;
 	}
 	memory = memory * 8; // Cast from bytes to bits
-	writeAnswerFile(outputFile, answers);
+	beginPhase("write");
+	bool written = writeAnswers(outputFile, answers, threads);
+	endPhase();
+	if (!written || (!profilePath.empty() && !writeProfile(profilePath, selection, queryCount))) {
+		return 1;
+	}
 	std::cout << "RESULT " << "algo=" << selection << " name=simon_bothe" << " time=" << duration.count() << " space=" << memory << std::endl;
 	return 0;
 }
@@ -0,0 +1,341 @@
+#include <iostream>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <utility>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include "Workloads.h"
+#include "HardwareCounters.h"
+#include "../RMQ/CartesianRMQ.h"
+#include "../RMQ/HierarchicalRMQ.h"
+#include "../RMQ/SuccinctRMQ.h"
+#include "../RMQ/StreamingRMQ.h"
+#include "../Predecessor/YTrie.h"
+#include "../Predecessor/StaticPredecessor.h"
+#include "../Predecessor/ShardedYTrie.h"
+#include "../Util/QueryCache.h"
+#include "../malloc_count/malloc_count.h"
+
+/**
+* Benchmarks all data structures and their variants on synthetic workloads and prints one line per structure and workload, in the key=value format of the RESULT line:
+* BENCH algo=rmq structure=cartesian data=random ranges=short n=... queries=... build_ms=... bytes_per_key=... peak_bytes_per_key=... queries_per_s=... p50_ns=... p99_ns=...
+*   cycles=... instructions=... cache_misses=... branch_misses=... checksum=...
+* The hardware counts are per query of the batched run, they are replaced by counters=unavailable, if the perf events can not be opened.
+* The checksum combines all answers, so all structures have to print the same checksum for the same workload.
+*/
+
+// Number of queries timed one by one for the latency percentiles.
+const uint64_t LATENCY_SAMPLES = 100000;
+
+// Entries of the query cache, and the distinct queries of the hot workloads, which all fit into it.
+const uint64_t CACHE_ENTRIES = 65536;
+const uint64_t HOT_QUERIES = 4096;
+
+struct BuildResult {
+	double milliseconds;
+	// Heap bytes held by the data structure after construction, per key.
+	double bytesPerKey;
+	// Highest heap bytes during construction, including everything freed again, per key.
+	double peakBytesPerKey;
+};
+
+struct QueryResult {
+	double queriesPerSecond;
+	double p50Nanoseconds;
+	double p99Nanoseconds;
+	bool countersAvailable;
+	uint64_t counts[HardwareCounters::EVENTS];
+	uint64_t checksum;
+};
+
+/**
+* Parses a whole argument as unsigned decimal number. Returns false, if it is empty or contains anything else.
+*/
+bool parseNumber(const char* argument, uint64_t* number) {
+	char* end;
+	*number = std::strtoull(argument, &end, 10);
+	return *end == '\0' && argument[0] != '\0';
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+* Measures the time of reading the clock twice, which is subtracted from the latency of every single query.
+*/
+double clockOverhead() {
+	std::vector<double> overheads(1000);
+	for (double& overhead : overheads) {
+		auto start = std::chrono::steady_clock::now();
+		overhead = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+	std::sort(overheads.begin(), overheads.end());
+	return overheads[overheads.size() / 2];
+}
+
+/**
+* Builds a data structure with build() and measures its time and memory.
+*/
+template <typename Build>
+auto measureBuild(Build build, uint64_t n, BuildResult* result) -> decltype(build()) {
+	size_t before = malloc_count_current();
+	malloc_count_reset_peak();
+	auto start = std::chrono::steady_clock::now();
+	auto structure = build();
+	result->milliseconds = millisecondsSince(start);
+	result->bytesPerKey = (double)(malloc_count_current() - before) / n;
+	result->peakBytesPerKey = (double)(malloc_count_peak() - before) / n;
+	return structure;
+}
+
+/**
+* Answers all count queries once with answerAll(out), the way the program does, to measure the throughput and the hardware counts.
+* Then the first LATENCY_SAMPLES queries are timed one by one with answerOne(i) for the latency percentiles.
+*/
+template <typename AnswerAll, typename AnswerOne>
+QueryResult measureQueries(uint64_t count, AnswerAll answerAll, AnswerOne answerOne, HardwareCounters* counters, double overhead) {
+	QueryResult result;
+	std::vector<uint64_t> answers(count);
+	counters->start();
+	auto start = std::chrono::steady_clock::now();
+	answerAll(answers.data());
+	double milliseconds = millisecondsSince(start);
+	counters->stop(result.counts);
+	result.countersAvailable = counters->available();
+	result.queriesPerSecond = count * 1000.0 / milliseconds;
+	result.checksum = 0;
+	for (uint64_t i = 0; i < count; i++) {
+		result.checksum = result.checksum * 31 + answers[i];
+	}
+	std::vector<double> latencies(std::min(count, LATENCY_SAMPLES));
+	uint64_t sink = 0;
+	for (uint64_t i = 0; i < latencies.size(); i++) {
+		auto queryStart = std::chrono::steady_clock::now();
+		sink += answerOne(i);
+		latencies[i] = std::max(0.0, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - queryStart).count() - overhead);
+	}
+	if (sink == 1) { // Keeps the single queries from being optimized away.
+		std::cerr << "";
+	}
+	std::sort(latencies.begin(), latencies.end());
+	result.p50Nanoseconds = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+	result.p99Nanoseconds = latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100];
+	return result;
+}
+
+void printResult(std::string algo, std::string structure, std::string data, std::string ranges, uint64_t n, uint64_t count, const BuildResult& build, const QueryResult& query) {
+	std::cout << "BENCH algo=" << algo << " structure=" << structure << " data=" << data;
+	if (!ranges.empty()) {
+		std::cout << " ranges=" << ranges;
+	}
+	std::cout << " n=" << n << " queries=" << count << " build_ms=" << build.milliseconds << " bytes_per_key=" << build.bytesPerKey << " peak_bytes_per_key=" << build.peakBytesPerKey
+		<< " queries_per_s=" << (uint64_t)query.queriesPerSecond << " p50_ns=" << query.p50Nanoseconds << " p99_ns=" << query.p99Nanoseconds;
+	if (query.countersAvailable) {
+		for (int i = 0; i < HardwareCounters::EVENTS; i++) {
+			std::cout << " " << HardwareCounters::NAMES[i] << "=" << (double)query.counts[i] / count;
+		}
+	}
+	else {
+		std::cout << " counters=unavailable";
+	}
+	std::cout << " checksum=" << query.checksum << std::endl;
+}
+
+/**
+* Answers every query set on the built rmq data structure and deletes it afterwards.
+*/
+template <typename RMQ>
+void benchmarkRangeMinimum(std::string structure, RMQ* rmq, const BuildResult& build, ArrayShape shape, uint64_t n,
+	const std::vector<std::vector<std::pair<uint64_t, uint64_t>>>& querySets, const std::vector<RangeLength>& lengths, HardwareCounters* counters, double overhead) {
+	for (uint64_t s = 0; s < querySets.size(); s++) {
+		const std::vector<std::pair<uint64_t, uint64_t>>& queries = querySets[s];
+		QueryResult result = measureQueries(queries.size(),
+			[&](uint64_t* out) { rmq->rangeMinimumQueries(queries.data(), queries.size(), out); },
+			[&](uint64_t i) { return rmq->rangeMinimumQuery(queries[i].first, queries[i].second); },
+			counters, overhead);
+		printResult("rmq", structure, toString(shape), toString(lengths[s]), n, queries.size(), build, result);
+	}
+	delete rmq;
+}
+
+/**
+* Runs all rmq structures on all array shapes and range lengths. The array and the queries of a shape are shared by all structures.
+*/
+void benchmarkRangeMinimums(uint64_t n, uint64_t count, uint64_t seed, uint64_t threads, std::string only, HardwareCounters* counters, double overhead) {
+	const std::vector<ArrayShape> shapes = { ArrayShape::RANDOM, ArrayShape::SORTED, ArrayShape::SAWTOOTH };
+	const std::vector<RangeLength> lengths = { RangeLength::SHORT, RangeLength::LONG, RangeLength::MIXED };
+	for (ArrayShape shape : shapes) {
+		std::vector<uint64_t> numbers = generateArray(shape, n, seed);
+		std::vector<std::vector<std::pair<uint64_t, uint64_t>>> querySets;
+		for (RangeLength length : lengths) {
+			querySets.push_back(generateRangeQueries(length, n, count, seed + 1));
+		}
+		BuildResult build;
+		if (only.empty() || only == "cartesian") {
+			CartesianRMQ<uint64_t>* rmq = measureBuild([&]() { return new CartesianRMQ<uint64_t>(numbers, threads); }, n, &build);
+			benchmarkRangeMinimum("cartesian", rmq, build, shape, n, querySets, lengths, counters, overhead);
+		}
+		if (only.empty() || only == "cartesian-noscan") {
+			CartesianRMQ<uint64_t>* rmq = measureBuild([&]() { return new CartesianRMQ<uint64_t>(numbers, threads); }, n, &build);
+			rmq->setScanThreshold(0);
+			benchmarkRangeMinimum("cartesian-noscan", rmq, build, shape, n, querySets, lengths, counters, overhead);
+		}
+		if (only.empty() || only == "cartesian-linear") {
+			CartesianRMQ<uint64_t>* rmq = measureBuild([&]() { return new CartesianRMQ<uint64_t>(numbers, threads, 0, true); }, n, &build);
+			benchmarkRangeMinimum("cartesian-linear", rmq, build, shape, n, querySets, lengths, counters, overhead);
+		}
+		if (only.empty() || only == "cartesian-lazy") {
+			CartesianRMQ<uint64_t>* rmq = measureBuild([&]() { return new CartesianRMQ<uint64_t>(numbers, threads, 0, false, true); }, n, &build);
+			benchmarkRangeMinimum("cartesian-lazy", rmq, build, shape, n, querySets, lengths, counters, overhead);
+		}
+		if (only.empty() || only == "streaming") {
+			// Appends one number at a time, so the build time is the cost of n appends.
+			StreamingRMQ<uint64_t>* rmq = measureBuild([&]() {
+				StreamingRMQ<uint64_t>* streaming = new StreamingRMQ<uint64_t>();
+				for (uint64_t value : numbers) {
+					streaming->append(value);
+				}
+				return streaming;
+			}, n, &build);
+			benchmarkRangeMinimum("streaming", rmq, build, shape, n, querySets, lengths, counters, overhead);
+		}
+		if (only.empty() || only == "hierarchical") {
+			HierarchicalRMQ<uint64_t>* rmq = measureBuild([&]() { return new HierarchicalRMQ<uint64_t>(numbers, threads); }, n, &build);
+			benchmarkRangeMinimum("hierarchical", rmq, build, shape, n, querySets, lengths, counters, overhead);
+		}
+		if (only.empty() || only == "succinct") {
+			SuccinctRMQ* rmq = measureBuild([&]() { return new SuccinctRMQ(numbers.data(), numbers.size(), threads); }, n, &build);
+			benchmarkRangeMinimum("succinct", rmq, build, shape, n, querySets, lengths, counters, overhead);
+		}
+	}
+}
+
+/**
+* Answers the queries on the built predecessor data structure and deletes it afterwards.
+*/
+template <typename Predecessor>
+void benchmarkPredecessor(std::string structure, Predecessor* predecessor, const BuildResult& build, std::string data, uint64_t n,
+	const std::vector<uint64_t>& queries, HardwareCounters* counters, double overhead) {
+	QueryResult result = measureQueries(queries.size(),
+		[&](uint64_t* out) { predecessor->getPredecessors(queries.data(), queries.size(), out); },
+		[&](uint64_t i) { return predecessor->getPredecessor(queries[i]); },
+		counters, overhead);
+	printResult("pd", structure, data, "", n, queries.size(), build, result);
+	delete predecessor;
+}
+
+/**
+* Like benchmarkPredecessor(), but the queries are looked up in a new cache first and only the misses are answered by the batch query, the way the program answers every chunk with "--cache".
+*/
+template <typename Predecessor>
+void benchmarkCachedPredecessor(std::string structure, Predecessor* predecessor, const BuildResult& build, std::string data, uint64_t n,
+	const std::vector<uint64_t>& queries, HardwareCounters* counters, double overhead) {
+	QueryCache<uint64_t> cache(CACHE_ENTRIES);
+	QueryCache<uint64_t>::AnswerFunction answer = [predecessor](const uint64_t* batch, size_t length, uint64_t* out) {
+		predecessor->getPredecessors(batch, length, out);
+	};
+	QueryResult result = measureQueries(queries.size(),
+		[&](uint64_t* out) { cache.answerQueries(queries.data(), queries.size(), out, answer); },
+		[&](uint64_t i) {
+			uint64_t cached;
+			return cache.lookup(queries[i], &cached) ? cached : predecessor->getPredecessor(queries[i]);
+		},
+		counters, overhead);
+	printResult("pd", structure, data, "", n, queries.size(), build, result);
+	delete predecessor;
+}
+
+/**
+* Runs the y-fast trie, its variants with packed buckets and with shards, the latter also behind the query cache, and the static predecessor structure on all key distributions. Throughput uses the batched queries of the program, latency single queries.
+*/
+void benchmarkPredecessors(uint64_t n, uint64_t count, uint64_t seed, uint64_t threads, std::string only, HardwareCounters* counters, double overhead) {
+	const std::vector<KeyDistribution> distributions = { KeyDistribution::UNIFORM, KeyDistribution::CLUSTERED, KeyDistribution::SPARSE };
+	for (KeyDistribution distribution : distributions) {
+		std::vector<uint64_t> keys = generateKeys(distribution, n, seed);
+		std::vector<uint64_t> queries = generatePredecessorQueries(keys, count, seed + 1);
+		BuildResult build;
+		if (only.empty() || only == "ytrie") {
+			YTrie<uint64_t>* trie = measureBuild([&]() { return new YTrie<uint64_t>(keys); }, n, &build);
+			benchmarkPredecessor("ytrie", trie, build, toString(distribution), n, queries, counters, overhead);
+		}
+		if (only.empty() || only == "ytrie-packed") {
+			YTrie<uint64_t>* trie = measureBuild([&]() { return new YTrie<uint64_t>(keys, true); }, n, &build);
+			benchmarkPredecessor("ytrie-packed", trie, build, toString(distribution), n, queries, counters, overhead);
+		}
+		if (only.empty() || only == "ytrie-sharded") {
+			ShardedYTrie<uint64_t>* trie = measureBuild([&]() { return new ShardedYTrie<uint64_t>(keys, threads); }, n, &build);
+			benchmarkPredecessor("ytrie-sharded", trie, build, toString(distribution), n, queries, counters, overhead);
+		}
+		if (only.empty() || only == "ytrie-sharded-cached") {
+			// The cache only pays off for repeating queries, so the sharded trie with and without it is also compared on hot queries, which the other structures don't run.
+			std::vector<uint64_t> hotQueries = generateHotQueries(keys, count, HOT_QUERIES, seed + 2);
+			ShardedYTrie<uint64_t>* trie = measureBuild([&]() { return new ShardedYTrie<uint64_t>(keys, threads); }, n, &build);
+			benchmarkCachedPredecessor("ytrie-sharded-cached", trie, build, toString(distribution), n, queries, counters, overhead);
+			trie = measureBuild([&]() { return new ShardedYTrie<uint64_t>(keys, threads); }, n, &build);
+			benchmarkPredecessor("ytrie-sharded", trie, build, toString(distribution) + "-hot", n, hotQueries, counters, overhead);
+			trie = measureBuild([&]() { return new ShardedYTrie<uint64_t>(keys, threads); }, n, &build);
+			benchmarkCachedPredecessor("ytrie-sharded-cached", trie, build, toString(distribution) + "-hot", n, hotQueries, counters, overhead);
+		}
+		if (only.empty() || only == "static") {
+			StaticPredecessor<uint64_t>* tree = measureBuild([&]() { return new StaticPredecessor<uint64_t>(keys); }, n, &build);
+			benchmarkPredecessor("static", tree, build, toString(distribution), n, queries, counters, overhead);
+		}
+	}
+}
+
+/**
+* Usage: ads_benchmark [pd|rmq|all] [--n N] [--queries N] [--seed N] [--threads N] [--structure NAME]
+* --n N            Number of keys or numbers. Default is 10000000.
+* --queries N      Number of queries per workload. Default is 1000000.
+* --seed N         Seed of all generators. Default is 1.
+* --threads N      Threads used for construction. The queries always run on one thread, so the counters see all of them. Default is 1.
+* --structure NAME Only runs one structure: ytrie, ytrie-packed, ytrie-sharded, ytrie-sharded-cached, static, cartesian, cartesian-noscan, cartesian-linear, cartesian-lazy, streaming, hierarchical or succinct.
+*/
+int main(int argc, const char** argv) {
+	std::string algo = argc > 1 ? std::string(argv[1]) : "all";
+	uint64_t n = 10000000;
+	uint64_t count = 1000000;
+	uint64_t seed = 1;
+	uint64_t threads = 1;
+	std::string only;
+	for (int i = 2; i < argc; i++) {
+		std::string option = std::string(argv[i]);
+		bool parsed = i + 1 < argc;
+		if (parsed && option == "--n") {
+			parsed = parseNumber(argv[++i], &n) && n > 0;
+		}
+		else if (parsed && option == "--queries") {
+			parsed = parseNumber(argv[++i], &count);
+		}
+		else if (parsed && option == "--seed") {
+			parsed = parseNumber(argv[++i], &seed);
+		}
+		else if (parsed && option == "--threads") {
+			parsed = parseNumber(argv[++i], &threads);
+		}
+		else if (parsed && option == "--structure") {
+			only = std::string(argv[++i]);
+		}
+		else {
+			parsed = false;
+		}
+		if (!parsed) {
+			return 1;
+		}
+	}
+	if (algo != "pd" && algo != "rmq" && algo != "all") {
+		return 1;
+	}
+	HardwareCounters counters;
+	double overhead = clockOverhead();
+	if (algo != "rmq") {
+		benchmarkPredecessors(n, count, seed, threads, only, &counters, overhead);
+	}
+	if (algo != "pd") {
+		benchmarkRangeMinimums(n, count, seed, threads, only, &counters, overhead);
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "HardwareCounters.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+const char* const HardwareCounters::NAMES[EVENTS] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+
+bool HardwareCounters::available() const {
+	return available_;
+}
+
+void HardwareCounters::start() {
+#ifdef __linux__
+	if (available_) {
+		ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+#endif
+}
+
+void HardwareCounters::stop(uint64_t* counts) {
+	for (int i = 0; i < EVENTS; i++) {
+		counts[i] = 0;
+	}
+#ifdef __linux__
+	if (available_) {
+		ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		// A group read returns the number of events followed by their counts.
+		uint64_t group[EVENTS + 1];
+		if (read(fds_[0], group, sizeof(group)) == (ssize_t)sizeof(group)) {
+			for (int i = 0; i < EVENTS; i++) {
+				counts[i] = group[i + 1];
+			}
+		}
+	}
+#endif
+}
+
+HardwareCounters::HardwareCounters() {
+	for (int i = 0; i < EVENTS; i++) {
+		fds_[i] = -1;
+	}
+#ifdef __linux__
+	const uint64_t configs[EVENTS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+	available_ = true;
+	for (int i = 0; i < EVENTS && available_; i++) {
+		perf_event_attr attributes;
+		std::memset(&attributes, 0, sizeof(attributes));
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.size = sizeof(attributes);
+		attributes.config = configs[i];
+		attributes.disabled = i == 0 ? 1 : 0; // The group follows its leader.
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_GROUP;
+		fds_[i] = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, i == 0 ? -1 : fds_[0], 0);
+		available_ = fds_[i] >= 0;
+	}
+#endif
+}
+
+HardwareCounters::~HardwareCounters() {
+#ifdef __linux__
+	for (int i = 0; i < EVENTS; i++) {
+		if (fds_[i] >= 0) {
+			close(fds_[i]);
+		}
+	}
+#endif
+}
\ No newline at end of file
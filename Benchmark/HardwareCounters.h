@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+/**
+* Counts cycles, instructions, cache misses and branch misses of the calling thread with the perf events of Linux.
+* Only user space is counted, which perf_event_paranoid <= 2 allows without privileges.
+* If the counters can not be opened, for example in a container or on other systems, available() is false and all counts are 0.
+*/
+class HardwareCounters {
+
+public:
+	// Number of counted events.
+	static const int EVENTS = 4;
+
+	// Names of the events, in the order of the counts.
+	static const char* const NAMES[EVENTS];
+
+private:
+	// The file descriptors of the events, the first one leads the group. -1 if not opened.
+	int fds_[EVENTS];
+
+	bool available_ = false;
+
+public:
+	bool available() const;
+
+	/**
+	* Resets the counts and starts counting.
+	*/
+	void start();
+
+	/**
+	* Stops counting and writes the counts since start() in the order of NAMES.
+	*/
+	void stop(uint64_t* counts);
+
+	/**
+	* Opens all events as one group, so they are counted over the same time.
+	*/
+	HardwareCounters();
+
+	HardwareCounters(const HardwareCounters&) = delete;
+	HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+	~HardwareCounters();
+};
\ No newline at end of file
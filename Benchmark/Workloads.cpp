@@ -0,0 +1,145 @@
+#include "Workloads.h"
+#include <algorithm>
+#include <random>
+
+
+std::string toString(KeyDistribution distribution) {
+	switch (distribution) {
+	case KeyDistribution::UNIFORM:
+		return "uniform";
+	case KeyDistribution::CLUSTERED:
+		return "clustered";
+	default:
+		return "sparse";
+	}
+}
+
+
+std::string toString(ArrayShape shape) {
+	switch (shape) {
+	case ArrayShape::RANDOM:
+		return "random";
+	case ArrayShape::SORTED:
+		return "sorted";
+	default:
+		return "sawtooth";
+	}
+}
+
+
+std::string toString(RangeLength length) {
+	switch (length) {
+	case RangeLength::SHORT:
+		return "short";
+	case RangeLength::LONG:
+		return "long";
+	default:
+		return "mixed";
+	}
+}
+
+
+/**
+* Draws a single key of the given distribution.
+*/
+uint64_t drawKey(KeyDistribution distribution, std::mt19937_64* random, const std::vector<uint64_t>& clusters) {
+	if (distribution == KeyDistribution::UNIFORM) {
+		return (*random)() % UINT64_MAX;
+	}
+	if (distribution == KeyDistribution::CLUSTERED) {
+		// Every cluster spans 2^20 numbers, so with 2^16 keys per cluster about every 16th number is a key.
+		return clusters[(*random)() % clusters.size()] + (*random)() % (1ULL << 20);
+	}
+	uint64_t bits = 1 + (*random)() % 63;
+	return ((*random)() | (1ULL << (bits - 1))) & ((1ULL << bits) - 1);
+}
+
+
+std::vector<uint64_t> generateKeys(KeyDistribution distribution, uint64_t n, uint64_t seed) {
+	std::mt19937_64 random(seed);
+	std::vector<uint64_t> clusters(n / (1ULL << 16) + 1);
+	for (uint64_t& cluster : clusters) {
+		cluster = random() % (UINT64_MAX - (1ULL << 20));
+	}
+	std::vector<uint64_t> keys;
+	keys.reserve(n);
+	// Duplicates are removed after sorting, so keys are drawn until there are enough distinct ones.
+	while (keys.size() < n) {
+		uint64_t missing = n - keys.size();
+		for (uint64_t i = 0; i < missing; i++) {
+			keys.push_back(drawKey(distribution, &random, clusters));
+		}
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	}
+	return keys;
+}
+
+
+std::vector<uint64_t> generatePredecessorQueries(const std::vector<uint64_t>& keys, uint64_t count, uint64_t seed) {
+	std::mt19937_64 random(seed);
+	std::vector<uint64_t> queries(count);
+	uint64_t span = keys.back() - keys.front();
+	for (uint64_t i = 0; i < count; i++) {
+		if (i % 2 == 0) {
+			uint64_t key = keys[random() % keys.size()];
+			uint64_t offset = random() % 1024;
+			queries[i] = key < UINT64_MAX - offset ? key + offset : key;
+		}
+		else {
+			queries[i] = keys.front() + (span == UINT64_MAX ? random() : random() % (span + 1));
+		}
+	}
+	return queries;
+}
+
+
+std::vector<uint64_t> generateHotQueries(const std::vector<uint64_t>& keys, uint64_t count, uint64_t hot, uint64_t seed) {
+	std::vector<uint64_t> hotQueries = generatePredecessorQueries(keys, hot, seed);
+	std::mt19937_64 random(seed + 1);
+	std::vector<uint64_t> queries(count);
+	for (uint64_t i = 0; i < count; i++) {
+		queries[i] = hotQueries[random() % hot];
+	}
+	return queries;
+}
+
+
+std::vector<uint64_t> generateArray(ArrayShape shape, uint64_t n, uint64_t seed) {
+	std::mt19937_64 random(seed);
+	std::vector<uint64_t> numbers(n);
+	uint64_t value = 0;
+	for (uint64_t i = 0; i < n; i++) {
+		if (shape == ArrayShape::RANDOM) {
+			numbers[i] = random();
+		}
+		else if (shape == ArrayShape::SORTED) {
+			value += 1 + random() % 16;
+			numbers[i] = value;
+		}
+		else {
+			// Every run starts below 1000 and rises by about 1000 per number, so the minimum of a range spanning a run start is one of the run starts.
+			numbers[i] = (i % 1000) * 1000 + random() % 1000;
+		}
+	}
+	return numbers;
+}
+
+
+std::vector<std::pair<uint64_t, uint64_t>> generateRangeQueries(RangeLength length, uint64_t n, uint64_t count, uint64_t seed) {
+	std::mt19937_64 random(seed);
+	std::vector<std::pair<uint64_t, uint64_t>> queries(count);
+	for (uint64_t i = 0; i < count; i++) {
+		if (length == RangeLength::SHORT || (length == RangeLength::MIXED && i % 2 == 0)) {
+			uint64_t min = random() % n;
+			uint64_t max = min + random() % 64;
+			queries[i] = { min, max < n ? max : n - 1 };
+		}
+		else {
+			uint64_t a = random() % n;
+			uint64_t b = random() % n;
+			queries[i] = { std::min(a, b), std::max(a, b) };
+		}
+	}
+	return queries;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+* Synthetic inputs for the benchmarks. All generators are deterministic for a given seed, so runs of different builds see the same inputs.
+*/
+
+// Distribution of the key sets for the predecessor benchmarks.
+enum class KeyDistribution {
+	// Keys drawn uniformly from all 64 bit numbers.
+	UNIFORM,
+	// Keys in a few dense clusters of consecutive-ish numbers, spread over all 64 bit numbers.
+	CLUSTERED,
+	// Keys with a uniformly drawn bit length, so the gaps grow from 1 near 0 up to 2^63 at the top.
+	SPARSE
+};
+
+// Shape of the arrays for the range minimum benchmarks.
+enum class ArrayShape {
+	// Uniformly drawn 64 bit numbers.
+	RANDOM,
+	// Increasing numbers, so every minimum is the left border of its query.
+	SORTED,
+	// Increasing runs of 1000 numbers, each starting at the same low number.
+	SAWTOOTH
+};
+
+// Lengths of the ranges for the range minimum benchmarks.
+enum class RangeLength {
+	// Ranges of 1 to 64 numbers.
+	SHORT,
+	// Ranges between two uniformly drawn positions.
+	LONG,
+	// Half short, half long ranges, interleaved.
+	MIXED
+};
+
+std::string toString(KeyDistribution distribution);
+
+std::string toString(ArrayShape shape);
+
+std::string toString(RangeLength length);
+
+/**
+* Generates n distinct keys of the given distribution in sorted order, the input the predecessor data structures are built on.
+* All keys are below UINT64_MAX, which is reserved for missing answers.
+*
+* @param distribution The distribution of the keys.
+* @param n The number of keys.
+* @param seed The seed of the random generator.
+*/
+std::vector<uint64_t> generateKeys(KeyDistribution distribution, uint64_t n, uint64_t seed);
+
+/**
+* Generates predecessor queries for the given keys. Half of them lie shortly behind a random key, the other half are drawn uniformly between the smallest and the largest key.
+* So for clustered keys, both the queries within and between the clusters are measured.
+*
+* @param keys The sorted keys the queries are answered on. May not be empty.
+* @param count The number of queries.
+* @param seed The seed of the random generator.
+*/
+std::vector<uint64_t> generatePredecessorQueries(const std::vector<uint64_t>& keys, uint64_t count, uint64_t seed);
+
+/**
+* Generates skewed predecessor queries, where every query is one of a few hot queries drawn by generatePredecessorQueries(). These are the workloads the query cache is meant for.
+*
+* @param keys The sorted keys the queries are answered on. May not be empty.
+* @param count The number of queries.
+* @param hot The number of distinct queries. May not be 0.
+* @param seed The seed of the random generator.
+*/
+std::vector<uint64_t> generateHotQueries(const std::vector<uint64_t>& keys, uint64_t count, uint64_t hot, uint64_t seed);
+
+/**
+* Generates an array of n numbers with the given shape for the range minimum data structures.
+*
+* @param shape The shape of the array.
+* @param n The number of numbers.
+* @param seed The seed of the random generator.
+*/
+std::vector<uint64_t> generateArray(ArrayShape shape, uint64_t n, uint64_t seed);
+
+/**
+* Generates range minimum queries (min, max) with min <= max < n.
+*
+* @param length The lengths of the ranges.
+* @param n The size of the array the queries are answered on. May not be 0.
+* @param count The number of queries.
+* @param seed The seed of the random generator.
+*/
+std::vector<std::pair<uint64_t, uint64_t>> generateRangeQueries(RangeLength length, uint64_t n, uint64_t count, uint64_t seed);
\ No newline at end of file
@@ -0,0 +1,580 @@
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <utility>
+#include <functional>
+#include <limits>
+#include <random>
+#include <set>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include "../Predecessor/YTrie.h"
+#include "../Predecessor/ShardedYTrie.h"
+#include "../RMQ/CartesianRMQ.h"
+#include "../RMQ/LinearRMQ.h"
+#include "../RMQ/HierarchicalRMQ.h"
+#include "../RMQ/StreamingRMQ.h"
+#include "../Util/QueryCache.h"
+
+/**
+* Compares the data structures with brute force answers on small random inputs and prints one line per check:
+* CHECK name=... rounds=... result=ok, or result=failed with the first wrong answer. Returns 1, if any check failed.
+* The inputs use small value ranges, so there are many equal numbers, duplicate queries and cache collisions.
+* It is built and run by build_check.sh.
+*/
+
+// The snapshot written and loaded again by the checks, removed afterwards.
+const char* SNAPSHOT_PATH = "ads_check.snap";
+
+/**
+* Parses a whole argument as unsigned decimal number. Returns false, if it is empty or contains anything else.
+*/
+bool parseNumber(const char* argument, uint64_t* number) {
+	char* end;
+	*number = std::strtoull(argument, &end, 10);
+	return *end == '\0' && argument[0] != '\0';
+}
+
+/**
+* Prints the result line of a check. Returns whether it succeeded.
+*/
+bool report(std::string name, uint64_t rounds, std::string failure) {
+	std::cout << "CHECK name=" << name << " rounds=" << rounds << " result=" << (failure.empty() ? "ok" : "failed " + failure) << std::endl;
+	return failure.empty();
+}
+
+std::string describe(uint64_t round, uint64_t step, uint64_t got, uint64_t expected) {
+	return "round=" + std::to_string(round) + " step=" + std::to_string(step) + " got=" + std::to_string(got) + " expected=" + std::to_string(expected);
+}
+
+
+/**
+* The largest value <= limit, or missing if there is none.
+*/
+uint64_t brutePredecessor(const std::set<uint64_t>& values, uint64_t limit, uint64_t missing) {
+	auto next = values.upper_bound(limit);
+	return next == values.begin() ? missing : *--next;
+}
+
+/**
+* The leftmost position of the minimum in [min, max] under compare.
+*/
+template <typename Compare>
+uint64_t bruteMinimum(const std::vector<uint64_t>& numbers, uint64_t min, uint64_t max, Compare compare) {
+	uint64_t position = min;
+	for (uint64_t i = min + 1; i <= max; i++) {
+		if (compare(numbers[i], numbers[position])) {
+			position = i;
+		}
+	}
+	return position;
+}
+
+
+/**
+* Builds a YTrie of random values and compares single and batch predecessor queries. Every other round, the trie is saved and loaded again before the queries.
+*/
+template <typename Key>
+std::string checkYTrie(uint64_t rounds, uint64_t seed, bool packedBuckets) {
+	const uint64_t notFound = std::numeric_limits<Key>::max();
+	for (uint64_t round = 0; round < rounds; round++) {
+		std::mt19937_64 random(seed + round);
+		// From a few values, so the buckets are full, up to the whole key range, so the trie is as deep as the key.
+		uint64_t ranges[] = { 16, 1000, 1ULL << 20, notFound - 1 };
+		uint64_t range = ranges[round % 4];
+		std::set<uint64_t> expected;
+		uint64_t count = round < 2 ? round : random() % 3000;
+		for (uint64_t i = 0; i < count; i++) {
+			expected.insert(random() % range);
+		}
+		YTrie<Key>* trie = new YTrie<Key>(std::vector<Key>(expected.begin(), expected.end()), packedBuckets);
+		if (round % 2 == 1) {
+			if (!trie->save(SNAPSHOT_PATH)) {
+				delete trie;
+				return "round=" + std::to_string(round) + " save failed";
+			}
+			delete trie;
+			trie = YTrie<Key>::load(SNAPSHOT_PATH);
+			if (trie == nullptr) {
+				return "round=" + std::to_string(round) + " load failed";
+			}
+		}
+		for (uint64_t q = 0; q < 1000; q++) {
+			uint64_t limit = random() % range;
+			if (trie->getPredecessor((Key)limit) != brutePredecessor(expected, limit, notFound)) {
+				uint64_t answer = trie->getPredecessor((Key)limit);
+				delete trie;
+				return describe(round, q, answer, brutePredecessor(expected, limit, notFound)) + " predecessor";
+			}
+		}
+		// The batch query also takes queries above the key range, which are answered like the largest key.
+		std::vector<uint64_t> queries(1000);
+		for (uint64_t& query : queries) {
+			query = random() % 2 == 0 ? random() % range : random();
+		}
+		std::vector<uint64_t> answers(queries.size());
+		trie->getPredecessors(queries.data(), queries.size(), answers.data());
+		delete trie;
+		for (uint64_t i = 0; i < queries.size(); i++) {
+			if (answers[i] != brutePredecessor(expected, queries[i], std::numeric_limits<uint64_t>::max())) {
+				return describe(round, i, answers[i], brutePredecessor(expected, queries[i], std::numeric_limits<uint64_t>::max())) + " getPredecessors";
+			}
+		}
+	}
+	return "";
+}
+
+
+/**
+* Inserts and erases random values in a YTrie and a std::set, and compares the insert and erase results, the size and the predecessor queries after every change.
+* Half way through, the trie is saved and loaded again, so the second half changes a trie using the arrays of the snapshot.
+*/
+template <typename Key>
+std::string checkDynamicYTrie(uint64_t rounds, uint64_t seed, bool packedBuckets) {
+	const uint64_t notFound = std::numeric_limits<Key>::max();
+	for (uint64_t round = 0; round < rounds; round++) {
+		std::mt19937_64 random(seed + round);
+		// From a few values, so most buckets split and merge, up to the whole key range, so the trie also grows in depth.
+		uint64_t ranges[] = { 16, 1000, 1ULL << 20, notFound - 1 };
+		uint64_t range = ranges[round % 4];
+		std::set<uint64_t> expected;
+		uint64_t initial = random() % 100;
+		for (uint64_t i = 0; i < initial; i++) {
+			expected.insert(random() % (range < 1000 ? range : 1000));
+		}
+		YTrie<Key>* trie = new YTrie<Key>(std::vector<Key>(expected.begin(), expected.end()), packedBuckets);
+		uint64_t steps = 2000;
+		for (uint64_t step = 0; step < steps; step++) {
+			if (step == steps / 2) {
+				if (!trie->save(SNAPSHOT_PATH)) {
+					delete trie;
+					return "round=" + std::to_string(round) + " save failed";
+				}
+				delete trie;
+				trie = YTrie<Key>::load(SNAPSHOT_PATH);
+				if (trie == nullptr) {
+					return "round=" + std::to_string(round) + " load failed";
+				}
+			}
+			uint64_t value = random() % range;
+			// Growing first and shrinking later, so the trie is empty again in some rounds.
+			bool insert = random() % 100 < (step < steps / 2 ? 65 : 35);
+			bool changed = insert ? trie->insert((Key)value) : trie->erase((Key)value);
+			bool expectedChanged = insert ? expected.insert(value).second : expected.erase(value) > 0;
+			std::string failure;
+			if (changed != expectedChanged) {
+				failure = describe(round, step, changed, expectedChanged) + (insert ? " insert" : " erase");
+			}
+			else if (trie->getSize() != expected.size()) {
+				failure = describe(round, step, trie->getSize(), expected.size()) + " size";
+			}
+			for (uint64_t q = 0; q < 4 && failure.empty(); q++) {
+				uint64_t limit = q == 0 ? value : q == 1 ? value + 1 : random() % range;
+				if (trie->getPredecessor((Key)limit) != brutePredecessor(expected, limit, notFound)) {
+					failure = describe(round, step, trie->getPredecessor((Key)limit), brutePredecessor(expected, limit, notFound)) + " predecessor";
+				}
+			}
+			if (!failure.empty()) {
+				delete trie;
+				return failure;
+			}
+		}
+		delete trie;
+	}
+	return "";
+}
+
+
+/**
+* Changes a YTrie by random inserts and erases, and compares the successor and countRange queries after every change and getRange over all values at the end.
+* So the order of the buckets is also checked while they split and merge.
+*/
+template <typename Key>
+std::string checkYTrieRanges(uint64_t rounds, uint64_t seed, bool packedBuckets) {
+	const uint64_t notFound = std::numeric_limits<Key>::max();
+	for (uint64_t round = 0; round < rounds; round++) {
+		std::mt19937_64 random(seed + round);
+		uint64_t ranges[] = { 16, 1000, 1ULL << 20, notFound - 1 };
+		uint64_t range = ranges[round % 4];
+		std::set<uint64_t> expected;
+		uint64_t initial = random() % 100;
+		for (uint64_t i = 0; i < initial; i++) {
+			expected.insert(random() % (range < 1000 ? range : 1000));
+		}
+		YTrie<Key> trie(std::vector<Key>(expected.begin(), expected.end()), packedBuckets);
+		for (uint64_t step = 0; step < 1000; step++) {
+			uint64_t value = random() % range;
+			if (random() % 2 == 0) {
+				trie.insert((Key)value);
+				expected.insert(value);
+			}
+			else {
+				trie.erase((Key)value);
+				expected.erase(value);
+			}
+			for (uint64_t q = 0; q < 4; q++) {
+				uint64_t limit = q == 0 ? value : q == 1 ? value + 1 : random() % range;
+				uint64_t upper = limit < notFound - 101 ? limit + 100 : notFound - 1;
+				auto successor = expected.lower_bound(limit);
+				uint64_t count = 0;
+				for (auto it = successor; it != expected.end() && *it <= upper; ++it) {
+					count++;
+				}
+				if (trie.getSuccessor((Key)limit) != (successor == expected.end() ? notFound : *successor)) {
+					return describe(round, step, trie.getSuccessor((Key)limit), successor == expected.end() ? notFound : *successor) + " successor";
+				}
+				if (limit <= upper && trie.countRange((Key)limit, (Key)upper) != count) {
+					return describe(round, step, trie.countRange((Key)limit, (Key)upper), count) + " countRange";
+				}
+			}
+		}
+		std::vector<uint64_t> all;
+		Key value;
+		typename YTrie<Key>::RangeIterator iterator = trie.getRange(0, (Key)(notFound - 1));
+		while (iterator.next(&value)) {
+			all.push_back(value);
+		}
+		if (all != std::vector<uint64_t>(expected.begin(), expected.end())) {
+			return describe(round, 0, all.size(), expected.size()) + " getRange";
+		}
+	}
+	return "";
+}
+
+
+/**
+* Builds ShardedYTries with 1 to 16 shards and compares the single, batched and node local queries with brute force answers.
+* The keys of every other round lie just below the largest key, so a single shard splits no bits at all.
+*/
+template <typename Key>
+std::string checkShardedYTrie(uint64_t rounds, uint64_t seed) {
+	const uint64_t notFound = std::numeric_limits<Key>::max();
+	for (uint64_t round = 0; round < rounds; round++) {
+		std::mt19937_64 random(seed + round);
+		uint64_t shards = 1ULL << (round % 5);
+		std::set<uint64_t> expected;
+		uint64_t n = random() % 3000;
+		for (uint64_t i = 0; i < n; i++) {
+			expected.insert(round % 2 == 0 ? notFound - 1 - random() % (1ULL << 20) : random() % notFound);
+		}
+		ShardedYTrie<Key> trie(std::vector<Key>(expected.begin(), expected.end()), 1 + round % 2, shards, round % 3 == 0);
+		if (trie.getSize() != expected.size()) {
+			return describe(round, 0, trie.getSize(), expected.size()) + " size";
+		}
+		std::vector<uint64_t> queries(2000);
+		for (uint64_t& query : queries) {
+			query = random() % 4 == 0 ? random() : round % 2 == 0 ? notFound - random() % (1ULL << 21) : random() % notFound;
+		}
+		if (round % 4 == 1) {
+			std::sort(queries.begin(), queries.end());
+		}
+		std::vector<uint64_t> answers(queries.size());
+		std::vector<uint64_t> localAnswers(queries.size());
+		trie.getPredecessors(queries.data(), queries.size(), answers.data());
+		trie.getPredecessorsLocal(queries.data(), queries.size(), localAnswers.data(), 2);
+		for (uint64_t i = 0; i < queries.size(); i++) {
+			uint64_t answer = brutePredecessor(expected, queries[i], std::numeric_limits<uint64_t>::max());
+			if (answers[i] != answer) {
+				return describe(round, i, answers[i], answer) + " getPredecessors";
+			}
+			if (localAnswers[i] != answer) {
+				return describe(round, i, localAnswers[i], answer) + " getPredecessorsLocal";
+			}
+			if (queries[i] < notFound && trie.getPredecessor((Key)queries[i]) != brutePredecessor(expected, queries[i], notFound)) {
+				return describe(round, i, trie.getPredecessor((Key)queries[i]), brutePredecessor(expected, queries[i], notFound)) + " getPredecessor";
+			}
+		}
+	}
+	return "";
+}
+
+
+/**
+* Answers random queries on a CartesianRMQ of every mode, also for empty arrays and arrays of a single block.
+*/
+std::string checkCartesianRMQ(uint64_t rounds, uint64_t seed) {
+	for (uint64_t round = 0; round < rounds; round++) {
+		std::mt19937_64 random(seed + round);
+		uint64_t n = round < 4 ? round : random() % 2000;
+		std::vector<uint64_t> numbers(n);
+		for (uint64_t& number : numbers) {
+			number = random() % (round % 2 == 0 ? 4 : 1000000);
+		}
+		CartesianRMQ<uint64_t> rmq(numbers, 1 + round % 3, round % 5 == 0 ? 1 + random() % 32 : 0, round % 3 == 1, round % 3 == 2);
+		if (round % 4 == 0) {
+			rmq.setScanThreshold(0);
+		}
+		for (uint64_t q = 0; n > 0 && q < 1000; q++) {
+			uint64_t min = random() % n;
+			uint64_t max = min + random() % (n - min);
+			if (rmq.rangeMinimumQuery(min, max) != bruteMinimum(numbers, min, max, std::less<uint64_t>())) {
+				return describe(round, q, rmq.rangeMinimumQuery(min, max), bruteMinimum(numbers, min, max, std::less<uint64_t>()));
+			}
+		}
+	}
+	return "";
+}
+
+
+/**
+* Answers random queries on a HierarchicalRMQ with random macro block sizes, from the smallest of one micro block up to the largest of 256.
+* Every other round, the data structure is saved and loaded again before the queries.
+*/
+template <typename Compare>
+std::string checkHierarchicalRMQ(uint64_t rounds, uint64_t seed) {
+	Compare compare;
+	for (uint64_t round = 0; round < rounds; round++) {
+		std::mt19937_64 random(seed + round);
+		uint64_t n = 1 + random() % (round % 4 == 3 ? 100000 : 3000);
+		std::vector<uint64_t> numbers(n);
+		for (uint64_t& number : numbers) {
+			number = random() % (round % 2 == 0 ? 4 : 1000000);
+		}
+		uint64_t macroSizes[] = { 0, 1, 64, 130, 1000, 256 * 64 };
+		HierarchicalRMQ<uint64_t, Compare>* rmq = new HierarchicalRMQ<uint64_t, Compare>(numbers, 1 + round % 3, macroSizes[round % 6], compare);
+		if (round % 2 == 1) {
+			if (!rmq->save(SNAPSHOT_PATH)) {
+				delete rmq;
+				return "round=" + std::to_string(round) + " save failed";
+			}
+			delete rmq;
+			rmq = HierarchicalRMQ<uint64_t, Compare>::load(SNAPSHOT_PATH, compare);
+			if (rmq == nullptr) {
+				return "round=" + std::to_string(round) + " load failed";
+			}
+		}
+		for (uint64_t q = 0; q < 300; q++) {
+			uint64_t min = random() % n;
+			uint64_t max = q % 2 == 0 ? std::min(n - 1, min + random() % 200) : min + random() % (n - min);
+			uint64_t answer = rmq->rangeMinimumQuery(min, max);
+			if (answer != bruteMinimum(numbers, min, max, compare)) {
+				delete rmq;
+				return describe(round, q, answer, bruteMinimum(numbers, min, max, compare));
+			}
+		}
+		delete rmq;
+	}
+	return "";
+}
+
+
+/**
+* Answers random queries on a LinearRMQ. Every fifth round has enough numbers for more than 4096 blocks, so the block minima get another LinearRMQ instead of the LogRMQ.
+*/
+template <typename Compare>
+std::string checkLinearRMQ(uint64_t rounds, uint64_t seed) {
+	Compare compare;
+	for (uint64_t round = 0; round < rounds; round++) {
+		std::mt19937_64 random(seed + round);
+		uint64_t n = round % 5 == 4 ? 4096 * 64 + random() % 50000 : 1 + random() % 3000;
+		std::vector<uint64_t> numbers(n);
+		for (uint64_t& number : numbers) {
+			number = random() % (round % 2 == 0 ? 4 : 1000000);
+		}
+		LinearRMQ<uint64_t, Compare> rmq(numbers.data(), n, 1 + round % 3, compare);
+		for (uint64_t q = 0; q < 300; q++) {
+			// Short ranges within and across a few blocks, and ranges between any two positions.
+			uint64_t min = random() % n;
+			uint64_t max = q % 2 == 0 ? std::min(n - 1, min + random() % 200) : min + random() % (n - min);
+			if (rmq.rangeMinimumQuery(min, max) != bruteMinimum(numbers, min, max, compare)) {
+				return describe(round, q, rmq.rangeMinimumQuery(min, max), bruteMinimum(numbers, min, max, compare));
+			}
+		}
+	}
+	return "";
+}
+
+
+/**
+* Appends random numbers to a StreamingRMQ one by one and in batches, and compares queries over the numbers appended so far after every append.
+* Every third round, the data structure is saved and loaded in between, so the appends continue on the arrays of the snapshot.
+*/
+template <typename Compare>
+std::string checkStreamingRMQ(uint64_t rounds, uint64_t seed) {
+	Compare compare;
+	for (uint64_t round = 0; round < rounds; round++) {
+		std::mt19937_64 random(seed + round);
+		uint64_t blockSizes[] = { 0, 1, 3, 8, 32, 40 };
+		StreamingRMQ<uint64_t, Compare>* rmq = new StreamingRMQ<uint64_t, Compare>(blockSizes[round % 6], compare);
+		if (round % 2 == 0) {
+			rmq->setScanThreshold(0);
+		}
+		std::vector<uint64_t> numbers;
+		uint64_t appends = 300;
+		for (uint64_t step = 0; step < appends; step++) {
+			if (round % 3 == 0 && step == appends / 2) {
+				if (!rmq->save(SNAPSHOT_PATH)) {
+					delete rmq;
+					return "round=" + std::to_string(round) + " save failed";
+				}
+				delete rmq;
+				rmq = StreamingRMQ<uint64_t, Compare>::load(SNAPSHOT_PATH, compare);
+				if (rmq == nullptr) {
+					return "round=" + std::to_string(round) + " load failed";
+				}
+			}
+			std::vector<uint64_t> batch(random() % 3 == 0 ? random() % 40 : 1);
+			for (uint64_t& number : batch) {
+				number = random() % (round % 4 < 2 ? 5 : 1000000);
+			}
+			if (batch.size() == 1 && random() % 2 == 0) {
+				rmq->append(batch[0]);
+			}
+			else {
+				rmq->appendBatch(batch.data(), batch.size());
+			}
+			numbers.insert(numbers.end(), batch.begin(), batch.end());
+			if (rmq->getSize() != numbers.size()) {
+				uint64_t size = rmq->getSize();
+				delete rmq;
+				return describe(round, step, size, numbers.size()) + " size";
+			}
+			for (uint64_t q = 0; !numbers.empty() && q < 20; q++) {
+				uint64_t min = random() % numbers.size();
+				uint64_t max = q == 0 ? numbers.size() - 1 : min + random() % (numbers.size() - min);
+				uint64_t answer = rmq->rangeMinimumQuery(min, max);
+				if (answer != bruteMinimum(numbers, min, max, compare)) {
+					delete rmq;
+					return describe(round, step, answer, bruteMinimum(numbers, min, max, compare));
+				}
+			}
+		}
+		delete rmq;
+	}
+	return "";
+}
+
+
+/**
+* The answer the cache checks compute for a query, so every cached answer can be checked without a data structure.
+*/
+uint64_t scramble(uint64_t query) {
+	return (query ^ (query >> 29)) * 0xBF58476D1CE4E5B9ULL + 1;
+}
+
+uint64_t scramble(const std::pair<uint64_t, uint64_t>& query) {
+	return scramble(query.first * 31 + scramble(query.second));
+}
+
+std::pair<uint64_t, uint64_t> randomQuery(std::mt19937_64& random, uint64_t range, const std::pair<uint64_t, uint64_t>*) {
+	uint64_t min = random() % range;
+	return std::make_pair(min, min + random() % 3);
+}
+
+uint64_t randomQuery(std::mt19937_64& random, uint64_t range, const uint64_t*) {
+	return random() % range;
+}
+
+/**
+* Answers skewed batches on several threads through one small QueryCache, so the threads insert into and read the same entries at the same time.
+* Every answer has to be the computed one, whether it came from the cache or not. Also checks answerUnique the same way.
+*/
+template <typename Query>
+std::string checkQueryCache(uint64_t rounds, uint64_t seed) {
+	std::function<void(const Query*, size_t, uint64_t*)> answer = [](const Query* queries, size_t n, uint64_t* out) {
+		for (size_t i = 0; i < n; i++) {
+			out[i] = scramble(queries[i]);
+		}
+	};
+	for (uint64_t round = 0; round < rounds; round++) {
+		QueryCache<Query> cache(round % 2 == 0 ? 64 : 4096);
+		uint64_t threads = 4;
+		std::atomic<uint64_t> wrong(0);
+		std::vector<std::thread> workers;
+		for (uint64_t t = 0; t < threads; t++) {
+			workers.push_back(std::thread([&, t]() {
+				std::mt19937_64 random(seed + round * threads + t);
+				for (uint64_t batch = 0; batch < 20; batch++) {
+					std::vector<Query> queries(1 + random() % 2000);
+					for (Query& query : queries) {
+						// Most queries hit a few hot ones, the others are spread over many more than the cache holds.
+						query = randomQuery(random, random() % 10 < 8 ? 100 : 1000000, (const Query*)nullptr);
+					}
+					std::vector<uint64_t> out(queries.size());
+					if (batch % 4 == 3) {
+						answerUnique(queries.data(), queries.size(), out.data(), answer);
+					}
+					else {
+						cache.answerQueries(queries.data(), queries.size(), out.data(), answer);
+					}
+					for (uint64_t i = 0; i < queries.size(); i++) {
+						if (out[i] != scramble(queries[i])) {
+							wrong++;
+						}
+					}
+				}
+			}));
+		}
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+		if (wrong.load() != 0) {
+			return "round=" + std::to_string(round) + " wrong=" + std::to_string(wrong.load());
+		}
+		// An inserted answer is found until another query replaces its entry, and a query never inserted is not.
+		std::mt19937_64 random(seed + round);
+		Query query = randomQuery(random, 1ULL << 40, (const Query*)nullptr);
+		uint64_t cached = 0;
+		cache.insert(query, scramble(query));
+		if (!cache.lookup(query, &cached) || cached != scramble(query)) {
+			return "round=" + std::to_string(round) + " inserted answer missing";
+		}
+		Query other = randomQuery(random, 1ULL << 40, (const Query*)nullptr);
+		if (!(other == query) && cache.lookup(other, &cached)) {
+			return "round=" + std::to_string(round) + " answer of an other query";
+		}
+	}
+	return "";
+}
+
+
+int main(int argc, const char** argv) {
+	uint64_t rounds = 20;
+	uint64_t seed = 1;
+	for (int i = 1; i < argc; i++) {
+		std::string option = std::string(argv[i]);
+		bool parsed = i + 1 < argc;
+		if (parsed && option == "--rounds") {
+			parsed = parseNumber(argv[++i], &rounds);
+		}
+		else if (parsed && option == "--seed") {
+			parsed = parseNumber(argv[++i], &seed);
+		}
+		else {
+			parsed = false;
+		}
+		if (!parsed) {
+			return 1;
+		}
+	}
+	bool success = true;
+	success = report("ytrie_32", rounds, checkYTrie<uint32_t>(rounds, seed, false)) && success;
+	success = report("ytrie_64", rounds, checkYTrie<uint64_t>(rounds, seed, false)) && success;
+	success = report("dynamic_ytrie_32", rounds, checkDynamicYTrie<uint32_t>(rounds, seed, false)) && success;
+	success = report("dynamic_ytrie_64", rounds, checkDynamicYTrie<uint64_t>(rounds, seed, false)) && success;
+	success = report("ytrie_ranges_32", rounds, checkYTrieRanges<uint32_t>(rounds, seed, false)) && success;
+	success = report("ytrie_ranges_64", rounds, checkYTrieRanges<uint64_t>(rounds, seed, false)) && success;
+	success = report("ytrie_32_packed", rounds, checkYTrie<uint32_t>(rounds, seed, true)) && success;
+	success = report("ytrie_64_packed", rounds, checkYTrie<uint64_t>(rounds, seed, true)) && success;
+	success = report("dynamic_ytrie_32_packed", rounds, checkDynamicYTrie<uint32_t>(rounds, seed, true)) && success;
+	success = report("dynamic_ytrie_64_packed", rounds, checkDynamicYTrie<uint64_t>(rounds, seed, true)) && success;
+	success = report("ytrie_ranges_32_packed", rounds, checkYTrieRanges<uint32_t>(rounds, seed, true)) && success;
+	success = report("ytrie_ranges_64_packed", rounds, checkYTrieRanges<uint64_t>(rounds, seed, true)) && success;
+	success = report("sharded_ytrie_32", rounds, checkShardedYTrie<uint32_t>(rounds, seed)) && success;
+	success = report("sharded_ytrie_64", rounds, checkShardedYTrie<uint64_t>(rounds, seed)) && success;
+	success = report("cartesian_rmq", rounds, checkCartesianRMQ(rounds, seed)) && success;
+	success = report("hierarchical_rmq_less", rounds, checkHierarchicalRMQ<std::less<uint64_t>>(rounds, seed)) && success;
+	success = report("hierarchical_rmq_greater", rounds, checkHierarchicalRMQ<std::greater<uint64_t>>(rounds, seed)) && success;
+	success = report("linear_rmq_less", rounds, checkLinearRMQ<std::less<uint64_t>>(rounds, seed)) && success;
+	success = report("linear_rmq_greater", rounds, checkLinearRMQ<std::greater<uint64_t>>(rounds, seed)) && success;
+	success = report("streaming_rmq_less", rounds, checkStreamingRMQ<std::less<uint64_t>>(rounds, seed)) && success;
+	success = report("streaming_rmq_greater", rounds, checkStreamingRMQ<std::greater<uint64_t>>(rounds, seed)) && success;
+	success = report("query_cache_pd", rounds, checkQueryCache<uint64_t>(rounds, seed)) && success;
+	success = report("query_cache_rmq", rounds, checkQueryCache<std::pair<uint64_t, uint64_t>>(rounds, seed)) && success;
+	std::remove(SNAPSHOT_PATH);
+	return success ? 0 : 1;
+}
\ No newline at end of file
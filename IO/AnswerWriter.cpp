@@ -0,0 +1,95 @@
+#include "AnswerWriter.h"
+#include "../Util/Parallel.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+// Number of answers formatted into one buffer. Every answer takes at most 21 characters (20 digits and a newline).
+const uint64_t ANSWERS_PER_CHUNK = 1 << 18;
+
+// "00" to "99", so two digits can be written at once.
+const char DIGIT_PAIRS[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+
+char* formatAnswer(char* position, uint64_t number) {
+	char digits[20];
+	char* start = digits + 20;
+	while (number >= 100) {
+		uint64_t pair = (number % 100) * 2;
+		number /= 100;
+		start -= 2;
+		start[0] = DIGIT_PAIRS[pair];
+		start[1] = DIGIT_PAIRS[pair + 1];
+	}
+	if (number >= 10) {
+		start -= 2;
+		start[0] = DIGIT_PAIRS[number * 2];
+		start[1] = DIGIT_PAIRS[number * 2 + 1];
+	}
+	else {
+		start--;
+		start[0] = (char)('0' + number);
+	}
+	while (start < digits + 20) {
+		*position = *start;
+		position++;
+		start++;
+	}
+	*position = '\n';
+	return position + 1;
+}
+
+/**
+* Writes the whole buffer, retrying on partial writes.
+*/
+bool writeFully(int fd, const char* data, uint64_t length) {
+	while (length > 0) {
+		ssize_t written = write(fd, data, length);
+		if (written < 0) {
+			return false;
+		}
+		data += written;
+		length -= written;
+	}
+	return true;
+}
+
+
+bool writeAnswers(std::string path, const std::vector<uint64_t>* answers, uint64_t threads) {
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	threads = resolveThreads(threads);
+	// A round has at most one chunk per thread, and no chunk holds more answers than there are. So short outputs only get small buffers.
+	uint64_t chunkAnswers = answers->size() < ANSWERS_PER_CHUNK ? answers->size() : ANSWERS_PER_CHUNK;
+	uint64_t totalChunks = (answers->size() + ANSWERS_PER_CHUNK - 1) / ANSWERS_PER_CHUNK;
+	uint64_t roundChunks = threads < totalChunks ? threads : totalChunks;
+	std::vector<std::vector<char>> buffers(roundChunks, std::vector<char>(chunkAnswers * 21));
+	std::vector<uint64_t> lengths(roundChunks);
+	bool success = true;
+	for (uint64_t roundStart = 0; roundStart < answers->size() && success; roundStart += threads * ANSWERS_PER_CHUNK) {
+		uint64_t roundEnd = roundStart + threads * ANSWERS_PER_CHUNK;
+		if (roundEnd > answers->size()) {
+			roundEnd = answers->size();
+		}
+		uint64_t chunks = (roundEnd - roundStart + ANSWERS_PER_CHUNK - 1) / ANSWERS_PER_CHUNK;
+		parallelFor(chunks, chunks, [&](uint64_t begin, uint64_t end) {
+			for (uint64_t chunk = begin; chunk < end; chunk++) {
+				uint64_t first = roundStart + chunk * ANSWERS_PER_CHUNK;
+				uint64_t last = first + ANSWERS_PER_CHUNK < roundEnd ? first + ANSWERS_PER_CHUNK : roundEnd;
+				char* position = buffers[chunk].data();
+				for (uint64_t i = first; i < last; i++) {
+					position = formatAnswer(position, (*answers)[i]);
+				}
+				lengths[chunk] = position - buffers[chunk].data();
+			}
+		});
+		for (uint64_t chunk = 0; chunk < chunks && success; chunk++) {
+			success = writeFully(fd, buffers[chunk].data(), lengths[chunk]);
+		}
+	}
+	return close(fd) == 0 && success;
+}
\ No newline at end of file
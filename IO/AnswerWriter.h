@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+* Writes all answers to the given file, one answer per line.
+* The answers are formatted into large buffers, which are written with a few big write calls instead of flushing every line.
+* The answers are processed in rounds of one chunk per thread. Every thread formats its own chunk and the chunks are then written in input order.
+* This bounds the buffer memory to about 5 MiB per thread.
+*
+* @param path The file to write. An existing file gets truncated.
+* @param answers The answers to write.
+* @param threads The number of threads formatting the answers. 0 uses all hardware threads.
+* @return false, if the file could not be written.
+*/
+bool writeAnswers(std::string path, const std::vector<uint64_t>* answers, uint64_t threads = 1);
+
+/**
+* Formats the number followed by a newline at position and returns the position behind it. At most 21 characters are written.
+*/
+char* formatAnswer(char* position, uint64_t number);
\ No newline at end of file
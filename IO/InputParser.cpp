@@ -0,0 +1,171 @@
+#include "InputParser.h"
+#include "../Util/Parallel.h"
+
+// Chunks smaller than this are not worth a thread of their own.
+const uint64_t MIN_CHUNK_SIZE = 1 << 20;
+
+
+bool isSpace(char c) {
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+* Parses the decimal number starting at position, stopping at the first non digit.
+* Moves position behind the number.
+*/
+uint64_t parseNumber(const char** position, const char* end) {
+	const char* p = *position;
+	uint64_t number = 0;
+	while (p < end && (unsigned char)(*p - '0') < 10) {
+		number = number * 10 + (uint64_t)(*p - '0');
+		p++;
+	}
+	*position = p;
+	return number;
+}
+
+void parseQuery(const char** position, const char* end, uint64_t* query) {
+	*query = parseNumber(position, end);
+}
+
+void parseQuery(const char** position, const char* end, std::pair<uint64_t, uint64_t>* query) {
+	query->first = parseNumber(position, end);
+	if (*position < end && **position == ',') {
+		(*position)++;
+	}
+	query->second = parseNumber(position, end);
+}
+
+/**
+* Counts the whitespace separated tokens in [begin, end).
+*/
+uint64_t countTokens(const char* begin, const char* end) {
+	uint64_t count = 0;
+	bool inToken = false;
+	for (const char* p = begin; p < end; p++) {
+		bool space = isSpace(*p);
+		count += (!space && !inToken);
+		inToken = !space;
+	}
+	return count;
+}
+
+/**
+* Parses the whole file. Every token of the body (everything after the first number) is either a value or a query, depending on its index.
+* The body is split into chunks whose borders lie on whitespace, so no token is split.
+* The first pass counts the tokens of every chunk, which tells every chunk the global index of its first token.
+* The second pass parses every chunk directly into the presized vectors.
+*/
+template <typename Query>
+bool parseInput(std::string path, std::vector<uint64_t>* values, std::vector<Query>* queries, uint64_t threads) {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		return false;
+	}
+	const char* position = file.data();
+	const char* end = file.data() + file.size();
+	while (position < end && isSpace(*position)) {
+		position++;
+	}
+	uint64_t length = parseNumber(&position, end);
+	uint64_t chunks = resolveThreads(threads);
+	if (chunks > (uint64_t)(end - position) / MIN_CHUNK_SIZE + 1) {
+		chunks = (uint64_t)(end - position) / MIN_CHUNK_SIZE + 1;
+	}
+	std::vector<const char*> borders(chunks + 1);
+	borders[0] = position;
+	borders[chunks] = end;
+	for (uint64_t i = 1; i < chunks; i++) {
+		const char* border = position + (end - position) * i / chunks;
+		if (border < borders[i - 1]) {
+			border = borders[i - 1];
+		}
+		while (border < end && !isSpace(*border)) {
+			border++;
+		}
+		borders[i] = border;
+	}
+	std::vector<uint64_t> firstToken(chunks + 1, 0);
+	parallelFor(chunks, chunks, [&](uint64_t begin, uint64_t stop) {
+		for (uint64_t i = begin; i < stop; i++) {
+			firstToken[i + 1] = countTokens(borders[i], borders[i + 1]);
+		}
+	});
+	for (uint64_t i = 0; i < chunks; i++) {
+		firstToken[i + 1] += firstToken[i];
+	}
+	uint64_t tokens = firstToken[chunks];
+	if (tokens < length) { // Less values than announced.
+		length = tokens;
+	}
+	values->resize(length);
+	queries->resize(tokens - length);
+	parallelFor(chunks, chunks, [&](uint64_t begin, uint64_t stop) {
+		for (uint64_t i = begin; i < stop; i++) {
+			const char* p = borders[i];
+			const char* chunkEnd = borders[i + 1];
+			uint64_t token = firstToken[i];
+			while (true) {
+				while (p < chunkEnd && isSpace(*p)) {
+					p++;
+				}
+				if (p >= chunkEnd) {
+					break;
+				}
+				if (token < length) {
+					(*values)[token] = parseNumber(&p, chunkEnd);
+				}
+				else {
+					parseQuery(&p, chunkEnd, &(*queries)[token - length]);
+				}
+				while (p < chunkEnd && !isSpace(*p)) { // Skip whatever is left of a malformed token.
+					p++;
+				}
+				token++;
+			}
+		}
+	});
+	return true;
+}
+
+
+bool readPredecessorInput(std::string path, std::vector<uint64_t>* values, std::vector<uint64_t>* queries, uint64_t threads) {
+	return parseInput(path, values, queries, threads);
+}
+
+
+bool readRMQInput(std::string path, std::vector<uint64_t>* values, std::vector<std::pair<uint64_t, uint64_t>>* queries, uint64_t threads) {
+	return parseInput(path, values, queries, threads);
+}
+
+
+/**
+* Parses queries->size() whitespace separated queries from [begin, end), with the same handling of malformed tokens as parseInput().
+*/
+template <typename Query>
+bool parseQueryList(const char* begin, const char* end, std::vector<Query>* queries) {
+	const char* p = begin;
+	for (Query& query : *queries) {
+		while (p < end && isSpace(*p)) {
+			p++;
+		}
+		if (p >= end) {
+			return false;
+		}
+		parseQuery(&p, end, &query);
+		while (p < end && !isSpace(*p)) {
+			p++;
+		}
+	}
+	return true;
+}
+
+
+bool parseQueries(const char* begin, const char* end, std::vector<uint64_t>* queries) {
+	return parseQueryList(begin, end, queries);
+}
+
+
+bool parseQueries(const char* begin, const char* end, std::vector<std::pair<uint64_t, uint64_t>>* queries) {
+	return parseQueryList(begin, end, queries);
+}
\ No newline at end of file
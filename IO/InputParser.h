@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "MappedFile.h"
+
+/**
+* Reads a predecessor input file. The first number is the amount of values, followed by the values and then the queries.
+* The numbers are parsed in place from the mapped file.
+* The file is split into newline aligned chunks, which are parsed on multiple threads directly into the presized vectors.
+*
+* @param path The file to read.
+* @param values The vector receiving the values, on which the data structure is built.
+* @param queries The vector receiving the queries.
+* @param threads The number of threads used for parsing. 0 uses all hardware threads.
+* @return false, if the file could not be read.
+*/
+bool readPredecessorInput(std::string path, std::vector<uint64_t>* values, std::vector<uint64_t>* queries, uint64_t threads = 1);
+
+/**
+* Reads a rmq input file. The first number is the amount of values, followed by the values and then the queries in the format "a,b".
+* Works the same way as readPredecessorInput.
+*
+* @param path The file to read.
+* @param values The vector receiving the values, on which the data structure is built.
+* @param queries The vector receiving the queries as pairs of borders.
+* @param threads The number of threads used for parsing. 0 uses all hardware threads.
+* @return false, if the file could not be read.
+*/
+bool readRMQInput(std::string path, std::vector<uint64_t>* values, std::vector<std::pair<uint64_t, uint64_t>>* queries, uint64_t threads = 1);
+
+/**
+* Parses queries from a buffer instead of a file, in the same formats as the input files.
+* Used for the requests of the QueryServer, whose queries arrive over a socket.
+*
+* @param begin The first character of the queries.
+* @param end The end of the queries.
+* @param queries The vector receiving the queries. Its size is the number of queries to parse.
+* @return false, if [begin, end) holds less queries.
+*/
+bool parseQueries(const char* begin, const char* end, std::vector<uint64_t>* queries);
+
+bool parseQueries(const char* begin, const char* end, std::vector<std::pair<uint64_t, uint64_t>>* queries);
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+bool MappedFile::isOpen() const {
+	return open_;
+}
+
+
+const char* MappedFile::data() const {
+	return data_;
+}
+
+
+uint64_t MappedFile::size() const {
+	return size_;
+}
+
+
+MappedFile::MappedFile(std::string path, bool sequential) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat info;
+	if (fstat(fd, &info) == 0) {
+		size_ = info.st_size;
+		if (size_ == 0) { // mmap can't map empty files, but they are still valid (and empty).
+			open_ = true;
+		}
+		else {
+			void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapping != MAP_FAILED) {
+				if (sequential) {
+					madvise(mapping, size_, MADV_SEQUENTIAL);
+				}
+				data_ = (const char*)mapping;
+				open_ = true;
+			}
+		}
+	}
+	close(fd); // The mapping stays valid after closing.
+}
+
+
+MappedFile::~MappedFile() {
+	if (data_ != nullptr) {
+		munmap((void*)data_, size_);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+* Read only memory mapping of a whole file. The mapping is removed on destruction.
+* The input parsers and snapshot loading read directly from the mapping, so the file is never copied into a buffer or a string.
+*/
+class MappedFile {
+
+private:
+	const char* data_ = nullptr;
+
+	uint64_t size_ = 0;
+
+	bool open_ = false;
+
+public:
+	/**
+	* Returns false, if the file could not be opened or mapped.
+	*/
+	bool isOpen() const;
+
+	const char* data() const;
+
+	uint64_t size() const;
+
+	/**
+	* Maps the whole file.
+	*
+	* @param path The file to map.
+	* @param sequential Tells the kernel that the file is read front to back, so it reads ahead aggressively.
+	*/
+	MappedFile(std::string path, bool sequential = true);
+
+	// A mapping can't be shared between two owners, since both would unmap it.
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile();
+};
\ No newline at end of file
@@ -0,0 +1,413 @@
+#include "QueryServer.h"
+#include "InputParser.h"
+#include "AnswerWriter.h"
+#include "../Util/Parallel.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Most events handled per epoll_wait call.
+const int MAX_EVENTS = 64;
+
+
+/**
+* Parses the count line of a request in [begin, end). Returns false, if it holds anything but one number between whitespace, and sets blank for a line of only whitespace.
+*/
+bool parseCountLine(const char* begin, const char* end, uint64_t* count, bool* blank) {
+	const char* p = begin;
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+		p++;
+	}
+	*blank = p == end;
+	const char* digits = p;
+	*count = 0;
+	while (p < end && (unsigned char)(*p - '0') < 10) {
+		*count = *count * 10 + (uint64_t)(*p - '0');
+		p++;
+	}
+	if (p == digits) {
+		return *blank;
+	}
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+		p++;
+	}
+	return p == end;
+}
+
+
+template <typename Query>
+bool QueryServer<Query>::setUp() {
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, &previousSignals_);
+	signalFd_ = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+	wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (signalFd_ < 0 || wakeFd_ < 0 || epollFd_ < 0 || socketPath_.empty() || socketPath_.size() >= sizeof(address.sun_path)) {
+		return false;
+	}
+	memcpy(address.sun_path, socketPath_.c_str(), socketPath_.size());
+	listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listenFd_ < 0) {
+		return false;
+	}
+	unlink(socketPath_.c_str());
+	if (bind(listenFd_, (const sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd_, SOMAXCONN) != 0) {
+		return false;
+	}
+	int fds[] = { listenFd_, signalFd_, wakeFd_ };
+	uint64_t ids[] = { listenId_, signalId_, wakeId_ };
+	for (int i = 0; i < 3; i++) {
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.u64 = ids[i];
+		if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fds[i], &event) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+template <typename Query>
+void QueryServer<Query>::tearDown() {
+	if (listenFd_ >= 0) {
+		close(listenFd_);
+		unlink(socketPath_.c_str());
+	}
+	int fds[] = { signalFd_, wakeFd_, epollFd_ };
+	for (int fd : fds) {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+	listenFd_ = signalFd_ = wakeFd_ = epollFd_ = -1;
+	pthread_sigmask(SIG_SETMASK, &previousSignals_, nullptr);
+}
+
+
+template <typename Query>
+void QueryServer<Query>::work() {
+	while (true) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(requestMutex_);
+			requestReady_.wait(lock, [this]() { return stopping_ || !requests_.empty(); });
+			if (stopping_) {
+				return;
+			}
+			request = std::move(requests_.front());
+			requests_.pop_front();
+		}
+		Response response;
+		response.connection = request.connection;
+		response.sequence = request.sequence;
+		std::vector<Query> queries(request.count);
+		response.valid = parseQueries(request.body.data(), request.body.data() + request.body.size(), &queries);
+		if (response.valid && request.count > 0) {
+			std::vector<uint64_t> answers(request.count);
+			answer_(queries.data(), request.count, answers.data());
+			response.answers.resize(request.count * 21);
+			char* start = &response.answers[0];
+			char* position = start;
+			for (uint64_t answer : answers) {
+				position = formatAnswer(position, answer);
+			}
+			response.answers.resize(position - start);
+		}
+		{
+			std::lock_guard<std::mutex> lock(responseMutex_);
+			responses_.push_back(std::move(response));
+		}
+		uint64_t one = 1;
+		if (write(wakeFd_, &one, sizeof(one)) < 0) {
+			// Only fails if the counter is about to overflow, then the event loop is woken anyway.
+		}
+	}
+}
+
+
+template <typename Query>
+void QueryServer<Query>::acceptConnections() {
+	while (true) {
+		int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			return;
+		}
+		uint64_t id = nextConnection_++;
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.u64 = id;
+		if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+			close(fd);
+			continue;
+		}
+		Connection& connection = connections_[id];
+		connection.fd = fd;
+		connection.events = EPOLLIN;
+	}
+}
+
+
+template <typename Query>
+bool QueryServer<Query>::readFrom(uint64_t id) {
+	Connection& connection = connections_.find(id)->second;
+	char buffer[readSize_];
+	ssize_t got = read(connection.fd, buffer, sizeof(buffer));
+	if (got > 0) {
+		connection.input.append(buffer, got);
+	}
+	else if (got == 0) {
+		connection.readClosed = true;
+	}
+	else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+		closeConnection(id);
+		return false;
+	}
+	return frameRequests(id) && flush(id);
+}
+
+
+template <typename Query>
+bool QueryServer<Query>::frameRequests(uint64_t id) {
+	Connection& connection = connections_.find(id)->second;
+	// Start of the first request which was not handed to a worker yet.
+	uint64_t consumed = 0;
+	while (connection.inFlight < maxInFlight_) {
+		size_t lineEnd = connection.input.find('\n', connection.scanned);
+		if (lineEnd == std::string::npos) {
+			connection.scanned = connection.input.size();
+			break;
+		}
+		connection.scanned = lineEnd + 1;
+		if (!connection.inBody) {
+			bool blank;
+			if (!parseCountLine(connection.input.data() + consumed, connection.input.data() + connection.scanned, &connection.count, &blank)) {
+				closeConnection(id);
+				return false;
+			}
+			if (blank) { // Empty lines between requests are skipped.
+				consumed = connection.scanned;
+				continue;
+			}
+			connection.inBody = true;
+			connection.bodyStart = connection.scanned;
+			connection.linesSeen = 0;
+		}
+		else {
+			connection.linesSeen++;
+		}
+		if (connection.linesSeen == connection.count) {
+			Request request;
+			request.connection = id;
+			request.sequence = connection.nextSequence++;
+			request.count = connection.count;
+			request.body = connection.input.substr(connection.bodyStart, connection.scanned - connection.bodyStart);
+			{
+				std::lock_guard<std::mutex> lock(requestMutex_);
+				requests_.push_back(std::move(request));
+			}
+			requestReady_.notify_one();
+			connection.inFlight++;
+			connection.inBody = false;
+			consumed = connection.scanned;
+		}
+	}
+	if (consumed > 0) {
+		connection.input.erase(0, consumed);
+		connection.scanned -= consumed;
+		connection.bodyStart -= connection.inBody ? consumed : 0;
+	}
+	if (connection.input.size() > maxRequestBytes_) {
+		closeConnection(id);
+		return false;
+	}
+	return true;
+}
+
+
+template <typename Query>
+void QueryServer<Query>::collectResponses() {
+	uint64_t count;
+	if (read(wakeFd_, &count, sizeof(count)) < 0) {
+		// Nothing was written since the last wake up, the responses were already collected then.
+	}
+	std::vector<Response> responses;
+	{
+		std::lock_guard<std::mutex> lock(responseMutex_);
+		responses.swap(responses_);
+	}
+	std::vector<uint64_t> touched;
+	for (Response& response : responses) {
+		auto found = connections_.find(response.connection);
+		if (found == connections_.end()) { // Closed while the request was answered.
+			continue;
+		}
+		found->second.inFlight--;
+		if (!response.valid) {
+			closeConnection(response.connection);
+			continue;
+		}
+		found->second.finished[response.sequence] = std::move(response.answers);
+		touched.push_back(response.connection);
+	}
+	for (uint64_t id : touched) {
+		auto found = connections_.find(id);
+		if (found == connections_.end()) {
+			continue;
+		}
+		Connection& connection = found->second;
+		while (!connection.finished.empty() && connection.finished.begin()->first == connection.nextToSend) {
+			connection.output += connection.finished.begin()->second;
+			connection.finished.erase(connection.finished.begin());
+			connection.nextToSend++;
+		}
+		// Less requests are in flight now, so requests which were held back can go to the workers.
+		if (frameRequests(id)) {
+			flush(id);
+		}
+	}
+}
+
+
+template <typename Query>
+bool QueryServer<Query>::flush(uint64_t id) {
+	Connection& connection = connections_.find(id)->second;
+	while (connection.written < connection.output.size()) {
+		ssize_t sent = send(connection.fd, connection.output.data() + connection.written, connection.output.size() - connection.written, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			closeConnection(id);
+			return false;
+		}
+		connection.written += sent;
+	}
+	if (connection.written == connection.output.size()) {
+		connection.output.clear();
+		connection.written = 0;
+	}
+	if (connection.readClosed && connection.inFlight == 0 && connection.output.empty()) { // Every response the client asked for was written.
+		closeConnection(id);
+		return false;
+	}
+	updateEvents(id);
+	return true;
+}
+
+
+template <typename Query>
+void QueryServer<Query>::updateEvents(uint64_t id) {
+	Connection& connection = connections_.find(id)->second;
+	uint64_t pending = connection.output.size() - connection.written;
+	bool readMore = !connection.readClosed && connection.inFlight < maxInFlight_ && pending < maxRequestBytes_;
+	uint32_t events = (readMore ? (uint32_t)EPOLLIN : 0u) | (pending > 0 ? (uint32_t)EPOLLOUT : 0u);
+	if (events != connection.events) {
+		epoll_event event;
+		event.events = events;
+		event.data.u64 = id;
+		epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection.fd, &event);
+		connection.events = events;
+	}
+}
+
+
+template <typename Query>
+void QueryServer<Query>::closeConnection(uint64_t id) {
+	auto found = connections_.find(id);
+	epoll_ctl(epollFd_, EPOLL_CTL_DEL, found->second.fd, nullptr);
+	close(found->second.fd);
+	connections_.erase(found);
+}
+
+
+template <typename Query>
+QueryServer<Query>::QueryServer(std::string socketPath, uint64_t threads, AnswerFunction answer) :
+	socketPath_(socketPath),
+	threads_(threads),
+	answer_(answer) {}
+
+
+template <typename Query>
+bool QueryServer<Query>::run() {
+	if (!setUp()) {
+		tearDown();
+		return false;
+	}
+	uint64_t workers = resolveThreads(threads_);
+	for (uint64_t i = 0; i < workers; i++) {
+		workers_.push_back(std::thread(&QueryServer::work, this));
+	}
+	bool running = true;
+	epoll_event events[MAX_EVENTS];
+	while (running) {
+		int ready = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+		if (ready < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ready < 0) {
+			break;
+		}
+		for (int i = 0; i < ready; i++) {
+			uint64_t id = events[i].data.u64;
+			if (id == listenId_) {
+				acceptConnections();
+			}
+			else if (id == signalId_) {
+				// The signal has to be taken, else it is still pending when tearDown() unblocks it.
+				signalfd_siginfo signal;
+				if (read(signalFd_, &signal, sizeof(signal)) == sizeof(signal)) {
+					running = false;
+				}
+			}
+			else if (id == wakeId_) {
+				collectResponses();
+			}
+			else if (connections_.count(id) != 0) { // Events of connections closed earlier in this round are skipped.
+				if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+					closeConnection(id);
+				}
+				else if (events[i].events & EPOLLIN) {
+					readFrom(id);
+				}
+				else if (events[i].events & EPOLLOUT) {
+					flush(id);
+				}
+			}
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(requestMutex_);
+		stopping_ = true;
+	}
+	requestReady_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+	for (auto& entry : connections_) {
+		close(entry.second.fd);
+	}
+	connections_.clear();
+	tearDown();
+	return true;
+}
+
+
+template class QueryServer<uint64_t>;
+template class QueryServer<std::pair<uint64_t, uint64_t>>;
\ No newline at end of file
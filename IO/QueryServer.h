@@ -0,0 +1,198 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <signal.h>
+
+/**
+* Long running server, which answers batched queries on an already built data structure over a Unix domain socket.
+* A request is a line with the number k of queries, followed by k lines with one query each, in the format of the input files ("a,b" for rmq).
+* Its response are the k answers, one per line, as in the output files.
+* Clients can send the next requests before the responses of the previous ones arrived. The responses of one connection always come back in request order.
+*
+* The work is pipelined over the threads: one thread runs an epoll event loop, which accepts connections, reads the requests, finds where they end and writes the responses.
+* Complete requests go to a pool of workers, which parse the queries, answer them with one batched call and encode the answers.
+* Finished responses are handed back to the event loop, which is woken through an eventfd.
+* So while a worker answers one request, the event loop already reads the next ones, and other workers answer those at the same time.
+* The server runs until it receives SIGINT or SIGTERM.
+* Query is the type of one query, uint64_t for predecessor and std::pair<uint64_t, uint64_t> for rmq queries.
+*/
+template <typename Query>
+class QueryServer {
+
+public:
+	// Answers n queries into out. It is called from multiple workers at the same time.
+	typedef std::function<void(const Query* queries, size_t n, uint64_t* out)> AnswerFunction;
+
+private:
+	/**
+	* A complete request, waiting for a worker.
+	*/
+	struct Request {
+		uint64_t connection;
+		uint64_t sequence;
+		uint64_t count;
+		std::string body;
+	};
+
+	/**
+	* The encoded answers of a request. Invalid, if the request held less queries than announced.
+	*/
+	struct Response {
+		uint64_t connection;
+		uint64_t sequence;
+		bool valid;
+		std::string answers;
+	};
+
+	/**
+	* The state of one client connection, only used by the event loop.
+	*/
+	struct Connection {
+		int fd;
+		// Read bytes, starting with the first request that was not handed to a worker yet.
+		std::string input;
+		// input up to here has been searched for line ends.
+		uint64_t scanned = 0;
+		// Whether the count line of the first request in input was read already, and the count and the start of the queries then.
+		bool inBody = false;
+		uint64_t count = 0;
+		uint64_t bodyStart = 0;
+		uint64_t linesSeen = 0;
+		// Sequence number of the next request, and of the next response to send.
+		uint64_t nextSequence = 0;
+		uint64_t nextToSend = 0;
+		// Responses which are done, but wait for an earlier one.
+		std::map<uint64_t, std::string> finished;
+		// Encoded responses not yet written, and how much of them was written already.
+		std::string output;
+		uint64_t written = 0;
+		// Requests handed to the workers, whose responses did not come back yet.
+		uint64_t inFlight = 0;
+		// The client closed its side, so nothing more is read.
+		bool readClosed = false;
+		// The events the fd is registered for.
+		uint32_t events = 0;
+	};
+
+	std::string socketPath_;
+
+	uint64_t threads_;
+
+	AnswerFunction answer_;
+
+	int listenFd_ = -1;
+
+	int signalFd_ = -1;
+
+	// The signal mask of the thread calling run(), restored when it returns.
+	sigset_t previousSignals_;
+
+	// Written by the workers, so the event loop wakes up for new responses.
+	int wakeFd_ = -1;
+
+	int epollFd_ = -1;
+
+	// Ids of the epoll events of the three fds above. Connections get the ids after them.
+	static const uint64_t listenId_ = 0;
+	static const uint64_t signalId_ = 1;
+	static const uint64_t wakeId_ = 2;
+
+	std::unordered_map<uint64_t, Connection> connections_;
+
+	uint64_t nextConnection_ = wakeId_ + 1;
+
+	// Requests waiting for a worker, guarded by requestMutex_.
+	std::deque<Request> requests_;
+	std::mutex requestMutex_;
+	std::condition_variable requestReady_;
+	bool stopping_ = false;
+
+	// Responses waiting for the event loop, guarded by responseMutex_.
+	std::vector<Response> responses_;
+	std::mutex responseMutex_;
+
+	std::vector<std::thread> workers_;
+
+	// Most requests of one connection handed to the workers at the same time. Beyond that, the connection is not read until responses came back.
+	static const uint64_t maxInFlight_ = 16;
+
+	// Largest request. A connection sending a larger one is closed, so a client can't make the server buffer without bounds.
+	static const uint64_t maxRequestBytes_ = 1ULL << 26;
+
+	// Bytes read from a connection per read call.
+	static const uint64_t readSize_ = 1ULL << 16;
+
+	/**
+	* Creates the socket, the signalfd, the eventfd and the epoll instance. Blocks SIGINT and SIGTERM before any worker starts, so they only arrive at the signalfd.
+	*/
+	bool setUp();
+
+	/**
+	* Closes all fds, removes the socket file and restores the signal mask.
+	*/
+	void tearDown();
+
+	/**
+	* The loop of a worker: takes requests, answers them and hands back the responses, until the server stops.
+	*/
+	void work();
+
+	void acceptConnections();
+
+	/**
+	* Reads everything available from the connection and hands its complete requests to the workers.
+	* Returns false, if the connection was closed.
+	*/
+	bool readFrom(uint64_t id);
+
+	/**
+	* Finds the complete requests at the beginning of the input of the connection and hands them to the workers, as long as less than maxInFlight_ are in flight.
+	* Returns false, if the connection was closed because of a malformed or too large request.
+	*/
+	bool frameRequests(uint64_t id);
+
+	/**
+	* Takes all finished responses from the workers, puts them into the outputs of their connections in request order and writes them.
+	*/
+	void collectResponses();
+
+	/**
+	* Writes as much of the output as the connection takes. May close the connection once it wrote everything the client will ever get.
+	* Returns false, if the connection was closed.
+	*/
+	bool flush(uint64_t id);
+
+	/**
+	* Registers the connection for reading, if it may read more requests, and for writing, if output is left.
+	*/
+	void updateEvents(uint64_t id);
+
+	void closeConnection(uint64_t id);
+
+public:
+	/**
+	* Prepares a server on the given socket path. Nothing is created before run().
+	*
+	* @param socketPath The path of the Unix domain socket. An existing file at this path is replaced.
+	* @param threads The number of workers answering the requests. 0 uses all hardware threads.
+	* @param answer The function answering a batch of queries.
+	*/
+	QueryServer(std::string socketPath, uint64_t threads, AnswerFunction answer);
+
+	/**
+	* Serves requests until SIGINT or SIGTERM arrives. All connections are closed then, also if responses are still missing.
+	*
+	* @return false, if the socket could not be created.
+	*/
+	bool run();
+};
\ No newline at end of file
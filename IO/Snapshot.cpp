@@ -0,0 +1,109 @@
+#include "Snapshot.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+const char SNAPSHOT_MAGIC[8] = { 'A', 'D', 'S', 'S', 'N', 'A', 'P', 'S' };
+
+
+void SnapshotWriter::writeBytes(const void* data, uint64_t length) {
+	const char* position = (const char*)data;
+	while (ok_ && length > 0) {
+		ssize_t written = write(fd_, position, length);
+		if (written < 0) {
+			ok_ = false;
+			return;
+		}
+		position += written;
+		length -= written;
+		offset_ += written;
+	}
+}
+
+
+void SnapshotWriter::align() {
+	const char zeros[64] = {};
+	writeBytes(zeros, (64 - offset_ % 64) % 64);
+}
+
+
+void SnapshotWriter::writeValue(uint64_t value) {
+	writeBytes(&value, sizeof(value));
+}
+
+
+bool SnapshotWriter::finish() {
+	if (fd_ >= 0) {
+		ok_ = close(fd_) == 0 && ok_;
+		fd_ = -1;
+	}
+	return ok_;
+}
+
+
+SnapshotWriter::SnapshotWriter(std::string path, uint32_t kind) :
+	fd_(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+	ok_(fd_ >= 0) {
+	writeBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	writeBytes(&SNAPSHOT_VERSION, sizeof(SNAPSHOT_VERSION));
+	writeBytes(&kind, sizeof(kind));
+}
+
+
+SnapshotWriter::~SnapshotWriter() {
+	finish();
+}
+
+
+const char* SnapshotReader::take(uint64_t length) {
+	if (!ok_ || length > mapping_->size() - offset_) {
+		ok_ = false;
+		return nullptr;
+	}
+	const char* data = mapping_->data() + offset_;
+	offset_ += length;
+	return data;
+}
+
+
+void SnapshotReader::align() {
+	take((64 - offset_ % 64) % 64);
+}
+
+
+bool SnapshotReader::isValid() const {
+	return ok_;
+}
+
+
+void SnapshotReader::invalidate() {
+	ok_ = false;
+}
+
+
+uint64_t SnapshotReader::readValue() {
+	uint64_t value = 0;
+	const char* data = take(sizeof(value));
+	if (data != nullptr) {
+		std::memcpy(&value, data, sizeof(value));
+	}
+	return value;
+}
+
+
+std::shared_ptr<MappedFile> SnapshotReader::getMapping() const {
+	return mapping_;
+}
+
+
+SnapshotReader::SnapshotReader(std::string path, uint32_t kind) :
+	mapping_(new MappedFile(path, false)),
+	ok_(mapping_->isOpen()) {
+	const char* magic = take(sizeof(SNAPSHOT_MAGIC));
+	const char* version = take(sizeof(SNAPSHOT_VERSION));
+	const char* storedKind = take(sizeof(kind));
+	if (!ok_ || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+		|| std::memcmp(version, &SNAPSHOT_VERSION, sizeof(SNAPSHOT_VERSION)) != 0
+		|| std::memcmp(storedKind, &kind, sizeof(kind)) != 0) {
+		ok_ = false;
+	}
+}
\ No newline at end of file
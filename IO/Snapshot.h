@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "MappedFile.h"
+#include "../Util/FlatArray.h"
+
+/**
+* Binary snapshot format for built data structures.
+* A snapshot starts with the magic "ADSSNAPS", the format version and the kind of data structure stored in it.
+* The rest is a flat sequence of 64 bit values and arrays in the order the data structure writes them.
+* An array is stored as its element count, followed by its raw elements, starting at the next 64 byte aligned offset.
+* Because of that, a loaded array can be used in place from a memory mapping of the snapshot, without any deserialization.
+* The snapshot uses the byte order and struct layout of the machine that wrote it.
+* Loading checks the header and all sizes, but not the content of the arrays, so snapshots have to come from a trusted source.
+*/
+
+// Increase whenever the layout of any data structure in a snapshot changes.
+const uint32_t SNAPSHOT_VERSION = 5;
+
+// The data structure stored in a snapshot, so a snapshot of the wrong kind is never loaded.
+const uint32_t SNAPSHOT_KIND_YTRIE = 1;
+const uint32_t SNAPSHOT_KIND_CARTESIAN_RMQ = 2;
+const uint32_t SNAPSHOT_KIND_YTRIE_32 = 3;
+const uint32_t SNAPSHOT_KIND_SUCCINCT_RMQ = 4;
+const uint32_t SNAPSHOT_KIND_HIERARCHICAL_RMQ = 5;
+const uint32_t SNAPSHOT_KIND_STATIC_PREDECESSOR = 6;
+const uint32_t SNAPSHOT_KIND_SHARDED_YTRIE = 7;
+const uint32_t SNAPSHOT_KIND_STREAMING_RMQ = 8;
+
+/**
+* Identifies the type of the numbers in a snapshot of a data structure templated on them, so they are never read as another type.
+* It holds the size of the type, and whether it is a floating point or a signed type.
+*/
+template <typename T>
+uint64_t snapshotValueType() {
+	return sizeof(T) | (std::is_floating_point<T>::value ? 1ULL << 8 : 0) | (std::is_signed<T>::value ? 1ULL << 9 : 0);
+}
+
+/**
+* Writes a snapshot file front to back.
+* Errors are remembered, so the caller only has to check the result of finish().
+*/
+class SnapshotWriter {
+
+private:
+	int fd_;
+
+	// Number of bytes written so far. Needed for the alignment of arrays.
+	uint64_t offset_ = 0;
+
+	bool ok_;
+
+	void writeBytes(const void* data, uint64_t length);
+
+	/**
+	* Writes zeros until the offset is a multiple of 64.
+	*/
+	void align();
+
+public:
+	void writeValue(uint64_t value);
+
+	template <typename T>
+	void writeArray(const FlatArray<T>& array) {
+		writeValue(array.size());
+		align();
+		writeBytes(array.data(), array.size() * sizeof(T));
+	}
+
+	/**
+	* Closes the file and returns whether everything was written successfully.
+	*/
+	bool finish();
+
+	/**
+	* Creates the snapshot file and writes the header.
+	*/
+	SnapshotWriter(std::string path, uint32_t kind);
+
+	SnapshotWriter(const SnapshotWriter&) = delete;
+	SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+	~SnapshotWriter();
+};
+
+/**
+* Reads a snapshot from a memory mapping of the file.
+* Arrays are returned as views into the mapping. The mapping is shared, so a loaded data structure keeps it alive via getMapping().
+* Reading past the end of the snapshot, or a wrong header marks the reader as invalid and returns zeros and empty arrays from then on.
+*/
+class SnapshotReader {
+
+private:
+	std::shared_ptr<MappedFile> mapping_;
+
+	uint64_t offset_ = 0;
+
+	bool ok_;
+
+	/**
+	* Returns a pointer to the next length bytes and moves behind them, or nullptr if the snapshot is too short.
+	*/
+	const char* take(uint64_t length);
+
+	/**
+	* Moves to the next offset that is a multiple of 64.
+	*/
+	void align();
+
+public:
+	bool isValid() const;
+
+	/**
+	* Marks the snapshot as invalid. Used by data structures which find inconsistent values while loading.
+	*/
+	void invalidate();
+
+	uint64_t readValue();
+
+	template <typename T>
+	FlatArray<T> readArray() {
+		uint64_t size = readValue();
+		align();
+		if (size > mapping_->size() / sizeof(T)) { // Also protects the multiplication below from overflowing.
+			ok_ = false;
+		}
+		const char* data = ok_ ? take(size * sizeof(T)) : nullptr;
+		if (data == nullptr) {
+			return FlatArray<T>();
+		}
+		return FlatArray<T>((const T*)data, size);
+	}
+
+	/**
+	* Returns the mapping the arrays point into. Whoever uses the arrays has to keep it.
+	*/
+	std::shared_ptr<MappedFile> getMapping() const;
+
+	/**
+	* Maps the snapshot file and checks the header.
+	*/
+	SnapshotReader(std::string path, uint32_t kind);
+};
\ No newline at end of file
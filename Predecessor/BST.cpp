@@ -1,65 +1,135 @@
 #include "BST.h"
-#include "Node.h"
-#include <cmath>
-
-	/**
-	* Recursively builds the Binary Search Tree from left to right.
-	* Since the given values are sorted, we can split the array and the subarrays in the middle.
-	* 
-	* @param values all the values, on which the binary search tree should be constructed.
-	* @param leftRange Left border for recursive construction. Starts at 0.
-	* @param rightRange Right border for recursive construction. Starts at values.size().
-	*/
-	Node* build(std::vector<uint64_t> values, int64_t leftRange, int64_t rightRange) {
-		if (leftRange > rightRange) {
-			return nullptr;
+#include "../Util/Profile.h"
+
+
+	template <typename Key>
+	void BST<Key>::build(const Key* sorted, uint64_t size, uint64_t* nextValue, uint64_t node, Key* out) {
+		if (node > size) {
+			return;
+		}
+		build(sorted, size, nextValue, 2 * node, out);
+		out[node - 1] = sorted[*nextValue];
+		(*nextValue)++;
+		build(sorted, size, nextValue, 2 * node + 1, out);
+	}
+
+
+	template <typename Key>
+	void BST<Key>::collect(uint64_t* nextValue, uint64_t node, Key* out) const {
+		if (node > size_) {
+			return;
 		}
-		int64_t split = round((leftRange + rightRange) / 2);
-		return new Node(values[split], build(values, leftRange, split-1), build(values, split+1, rightRange));
+		collect(nextValue, 2 * node, out);
+		out[*nextValue] = values_[node - 1];
+		(*nextValue)++;
+		collect(nextValue, 2 * node + 1, out);
 	}
 
 
-	/**
-	* Recursively finds the predecessor to a given integer in the tree.
-	* This is done by comparing to the value in the node and then looking at the left, or right child.
-	* 
-	* @params node The node we are looking at right now. Starts at the root.
-	* @params maxFound The best predecessor candidate found so far. Starts with root's value.
-	* @param limit The number we want to find the predecessor for.
-	*/
-	int64_t getPredecessorInternal(Node* node, uint64_t maxFound, uint64_t limit) {
-		if (node == nullptr) {
-			// End of tree
-			return maxFound;
+	template <typename Key>
+	Key BST<Key>::getPredecessor(Key maxSmallerTree, Key limit) const {
+		// Go right whenever the node is still a predecessor candidate. This way the node number records the path we took.
+		uint64_t node = 1;
+		while (node <= size_) {
+			node = 2 * node + (values_[node - 1] <= limit);
 		}
-		if (node->getValue() <= limit && node->getValue() >= maxFound) {
-			// Found new maximum
-			maxFound = node->getValue();
+		countTreeSteps(63 - __builtin_clzll(node)); // Every step appended one bit to the node number.
+		// The last right turn was made at the largest value <= limit. Strip the trailing left turns (0s) and this right turn (1).
+		node >>= __builtin_ctzll(node) + 1;
+		if (node == 0) {
+			// Never went right, so all values in this tree are larger than limit.
+			return maxSmallerTree;
+		}
+		return values_[node - 1];
+	}
+
+
+	template <typename Key>
+	uint64_t BST<Key>::findSuccessorNode(Key limit) const {
+		uint64_t node = 1;
+		while (node <= size_) {
+			node = 2 * node + (values_[node - 1] < limit);
 		}
-		if (node->getValue() < limit) {
-			// Search in right subtree
-			return getPredecessorInternal(node->getRightChild(), maxFound, limit);
+		// The last left turn was made at the smallest value >= limit. Strip the trailing right turns (1s) and this left turn (0).
+		return node >> (__builtin_ctzll(~node) + 1);
+	}
+
+
+	template <typename Key>
+	uint64_t BST<Key>::firstNode() const {
+		if (size_ == 0) {
+			return 0;
 		}
-		else {
-			// Search in left subtree
-			return getPredecessorInternal(node->getLeftChild(), maxFound, limit);
+		uint64_t node = 1;
+		while (2 * node <= size_) {
+			node = 2 * node;
 		}
+		return node;
 	}
 
-	uint64_t BST::getPredecessor(uint64_t maxFound, uint64_t limit) {
-		return getPredecessorInternal(root_, maxFound, limit);
+
+	template <typename Key>
+	uint64_t BST<Key>::nextNode(uint64_t node) const {
+		if (2 * node + 1 <= size_) {
+			// Leftmost node of the right subtree.
+			node = 2 * node + 1;
+			while (2 * node <= size_) {
+				node = 2 * node;
+			}
+			return node;
+		}
+		// Go up until we come from a left child. 0 means we came from the right of the root.
+		return node >> (__builtin_ctzll(~node) + 1);
+	}
+
+
+	template <typename Key>
+	Key BST<Key>::getValue(uint64_t node) const {
+		return values_[node - 1];
+	}
+
+
+	template <typename Key>
+	Key BST<Key>::getMinimum() const {
+		return values_[firstNode() - 1];
+	}
+
+
+	template <typename Key>
+	uint64_t BST<Key>::countAtMost(Key limit) const {
+		uint64_t count = 0;
+		for (uint64_t i = 0; i < size_; i++) {
+			count += values_[i] <= limit;
+		}
+		return count;
+	}
+
+
+	template <typename Key>
+	void BST<Key>::getSortedValues(Key* out) const {
+		uint64_t nextValue = 0;
+		collect(&nextValue, 1, out);
+	}
+
+
+	template <typename Key>
+	uint64_t BST<Key>::getSize() const {
+		return size_;
 	}
 
 
-	Node* BST::getRoot() {
-		return root_;
+	template <typename Key>
+	void BST<Key>::layout(const Key* sorted, uint64_t size, Key* out) {
+		uint64_t nextValue = 0;
+		build(sorted, size, &nextValue, 1, out);
 	}
 
 
-	BST::BST(std::vector<uint64_t> values) :
-		root_(build(values, 0, values.size() - 1)) {}
+	template <typename Key>
+	BST<Key>::BST(const Key* values, uint64_t size) :
+		values_(values),
+		size_(size) {}
 
 
-	BST::~BST() {
-		delete(root_);
-	}
\ No newline at end of file
+	template class BST<uint32_t>;
+	template class BST<uint64_t>;
\ No newline at end of file
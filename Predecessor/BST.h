@@ -1,37 +1,111 @@
 #pragma once
-#include "Node.h"
 #include <cstdint>
-#include <vector>
 
 /**
 * Class representing a binary searching tree.
-* It consists of a single pointer to a root node, which knows its children.
+* The tree is stored implicitly in a contiguous array in Eytzinger (breadth first) order.
+* Numbering the nodes from 1, the root is node 1 and the children of node k are 2k and 2k+1. Node k is stored at position k-1.
+* The array itself is not owned, all trees of a Y-Trie lie in one bucket array of the trie.
+* This avoids a heap allocation per value and keeps the upper levels of the tree in the same cache lines.
+* Key is the unsigned integer type of the values.
 */
+template <typename Key>
 class BST {
 
 private:
-	Node* root_ = nullptr;
+	// The values in Eytzinger order.
+	const Key* values_;
+
+	// Number of values in the tree.
+	uint64_t size_;
+
+	/**
+	* Recursively fills the array in Eytzinger order by doing an in order traversal of the implicit tree.
+	* Since the given values are sorted, the in order traversal visits them exactly in the given order.
+	*
+	* @param sorted All the values, on which the binary search tree should be constructed.
+	* @param size The number of values.
+	* @param nextValue The index of the next value in the sorted values that gets placed. Starts at 0.
+	* @param node The node we are filling right now. Starts at the root (1).
+	* @param out The array receiving the tree.
+	*/
+	static void build(const Key* sorted, uint64_t size, uint64_t* nextValue, uint64_t node, Key* out);
+
+	/**
+	* Recursively writes the values of the subtree below node to out in sorted order. The inverse of build().
+	*/
+	void collect(uint64_t* nextValue, uint64_t node, Key* out) const;
 
 public:
 	/**
 	* Performs the predecessor query.
 	* Since this should later be used in a Y-Trie, it also gets the maximum (representant) of the left neighbour tree.
 	* This allows it to dynamically find out, if the predecessor is actually the maximum of the neighbour, or present in itself.
+	* The descent through the tree is branchless, the comparison result is used directly to pick the child.
 	* 
 	* @param maxSmallerTree The maximum (representant) of the left neighbour tree in the Y-Trie.
 	* @param limit The number, for which we want to find the predecessor.
 	*/
-	uint64_t getPredecessor(uint64_t maxSmallerTree, uint64_t limit);
+	Key getPredecessor(Key maxSmallerTree, Key limit) const;
 
-	Node* getRoot();
+	/**
+	* Returns the node of the smallest value >= limit, or 0 if all values are smaller.
+	* Mirrors getPredecessor(): the descent goes left whenever the node is still a successor candidate.
+	*/
+	uint64_t findSuccessorNode(Key limit) const;
 
 	/**
-	* Constructs the binary search tree from the given values.
-	* These given values will later be present as the values of the tree nodes.
-	* 
-	* @params values The vector of numbers, which should be used to construct the binary search tree.
+	* Returns the leftmost node, which holds the smallest value, or 0 for an empty tree.
+	*/
+	uint64_t firstNode() const;
+
+	/**
+	* Returns the node following the given one in sorted order, or 0 if it is the last one.
+	* Takes amortized O(1) steps when iterating over the whole tree.
+	*/
+	uint64_t nextNode(uint64_t node) const;
+
+	/**
+	* Returns the value of the given node. Nodes are numbered from 1.
+	*/
+	Key getValue(uint64_t node) const;
+
+	/**
+	* Returns the smallest value of the tree, which is the leftmost node. The tree must not be empty.
+	*/
+	Key getMinimum() const;
+
+	/**
+	* Counts the values <= limit. The values are scanned linearly, since the tree stores no subtree sizes and holds only O(log U) values.
 	*/
-	BST(std::vector<uint64_t> values);
+	uint64_t countAtMost(Key limit) const;
 
-	~BST();
+	/**
+	* Writes all values of the tree to out in sorted order.
+	*
+	* @param out The array receiving the values. Must have space for getSize() values.
+	*/
+	void getSortedValues(Key* out) const;
+
+	/**
+	* Returns the number of values stored in the tree.
+	*/
+	uint64_t getSize() const;
+
+	/**
+	* Writes the binary search tree for the given sorted values in Eytzinger order to out.
+	*
+	* @param sorted The sorted values, which should be used to construct the binary search tree.
+	* @param size The number of values.
+	* @param out The array receiving the tree. Must have space for size values.
+	*/
+	static void layout(const Key* sorted, uint64_t size, Key* out);
+
+	/**
+	* Constructs a view on a binary search tree, which was written by layout().
+	* 
+	* @param values The tree in Eytzinger order.
+	* @param size The number of values in the tree.
+	*/
+	BST(const Key* values, uint64_t size);
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "PackedBucket.h"
+#include "../Util/Profile.h"
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::getDelta(uint64_t position) const {
+	uint64_t bit = position * width_;
+	uint64_t shift = bit & 63;
+	// The last word holding bits of the delta is the first one for deltas that do not cross a word boundary. Its bits then end up above the width and are masked away.
+	uint64_t low = deltas_[bit >> 6] >> shift;
+	uint64_t high = (deltas_[(bit + width_ - 1) >> 6] << 1) << (63 - shift);
+	return (low | high) & (~0ULL >> (64 - width_));
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::lastAtMost(uint64_t delta) const {
+	uint64_t first = 0;
+	uint64_t length = size_;
+	uint64_t steps = 0;
+	while (length > 1) {
+		uint64_t half = length / 2;
+		first = getDelta(first + half) <= delta ? first + half : first;
+		length -= half;
+		steps++;
+	}
+	countTreeSteps(steps);
+	return first;
+}
+
+
+template <typename Key>
+Key PackedBucket<Key>::getPredecessor(Key maxSmallerTree, Key limit) const {
+	if (size_ == 0 || limit < minimum_) {
+		return maxSmallerTree;
+	}
+	return minimum_ + (Key)getDelta(lastAtMost(limit - minimum_));
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::findSuccessorNode(Key limit) const {
+	if (size_ == 0 || limit <= minimum_) {
+		return size_ == 0 ? 0 : 1;
+	}
+	// All deltas < limit - minimum_ are <= limit - minimum_ - 1, and the first delta (0) always is.
+	uint64_t node = lastAtMost(limit - minimum_ - 1) + 2;
+	return node <= size_ ? node : 0;
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::firstNode() const {
+	return size_ == 0 ? 0 : 1;
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::nextNode(uint64_t node) const {
+	return node < size_ ? node + 1 : 0;
+}
+
+
+template <typename Key>
+Key PackedBucket<Key>::getValue(uint64_t node) const {
+	return minimum_ + (Key)getDelta(node - 1);
+}
+
+
+template <typename Key>
+Key PackedBucket<Key>::getMinimum() const {
+	return minimum_;
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::countAtMost(Key limit) const {
+	if (size_ == 0 || limit < minimum_) {
+		return 0;
+	}
+	return lastAtMost(limit - minimum_) + 1;
+}
+
+
+template <typename Key>
+void PackedBucket<Key>::getSortedValues(Key* out) const {
+	for (uint64_t i = 0; i < size_; i++) {
+		out[i] = minimum_ + (Key)getDelta(i);
+	}
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::getSize() const {
+	return size_;
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::widthOf(const Key* sorted, uint64_t size) {
+	uint64_t largest = size < 2 ? 0 : (uint64_t)(sorted[size - 1] - sorted[0]);
+	// Width 0 would make the extraction read before the deltas, so single values also take one bit.
+	return largest == 0 ? 1 : 64 - __builtin_clzll(largest);
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::wordCount(uint64_t size, uint64_t width) {
+	return 2 + (size * width + 63) / 64;
+}
+
+
+template <typename Key>
+uint64_t PackedBucket<Key>::layout(const Key* sorted, uint64_t size, uint64_t* out) {
+	uint64_t width = widthOf(sorted, size);
+	uint64_t words = wordCount(size, width);
+	Key minimum = size == 0 ? 0 : sorted[0];
+	out[0] = minimum;
+	out[1] = size | width << 8;
+	uint64_t* deltas = out + 2;
+	for (uint64_t i = 2; i < words; i++) {
+		out[i] = 0;
+	}
+	for (uint64_t i = 0; i < size; i++) {
+		uint64_t delta = (uint64_t)(sorted[i] - minimum);
+		uint64_t bit = i * width;
+		deltas[bit >> 6] |= delta << (bit & 63);
+		if ((bit & 63) + width > 64) {
+			deltas[(bit >> 6) + 1] |= delta >> (64 - (bit & 63));
+		}
+	}
+	return words;
+}
+
+
+template <typename Key>
+PackedBucket<Key>::PackedBucket(const uint64_t* words) :
+	deltas_(words + 2),
+	minimum_((Key)words[0]),
+	size_(words[1] & 255),
+	width_(words[1] >> 8) {}
+
+
+template class PackedBucket<uint32_t>;
+template class PackedBucket<uint64_t>;
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+
+/**
+* Class representing a compressed bucket of a Y-Trie, as alternative to the binary search tree (see BST).
+* The values are stored in sorted order as deltas from the minimum of the bucket (frame of reference), bit packed to the width of the largest delta.
+* The bucket is one run of 64 bit words: the minimum, a header with the number of values and the width, then the packed deltas, lowest bits first.
+* Dense keys, like timestamps or ids, need only a few bits per value this way, instead of a whole key.
+* Searches are branchless binary searches on the packed deltas, extracting a delta from at most two words.
+* The nodes of the BST interface are the positions in sorted order, starting at 1, so the trie can iterate over both kinds of buckets the same way.
+* The words are not owned, all buckets of a Y-Trie lie in one word array of the trie.
+* Key is the unsigned integer type of the values.
+*/
+template <typename Key>
+class PackedBucket {
+
+private:
+	// The packed deltas, starting at the third word of the bucket.
+	const uint64_t* deltas_;
+
+	// Smallest value of the bucket, all deltas are relative to it.
+	Key minimum_;
+
+	// Number of values in the bucket.
+	uint64_t size_;
+
+	// Bits per delta, at least 1.
+	uint64_t width_;
+
+	/**
+	* Returns the delta at the given position in sorted order.
+	*/
+	uint64_t getDelta(uint64_t position) const;
+
+	/**
+	* Returns the last position in sorted order whose delta is <= delta. Requires the first delta (0) to be <= delta.
+	*/
+	uint64_t lastAtMost(uint64_t delta) const;
+
+public:
+	/**
+	* Performs the predecessor query, with the same conventions as BST::getPredecessor().
+	*
+	* @param maxSmallerTree The maximum (representant) of the left neighbour bucket in the Y-Trie.
+	* @param limit The number, for which we want to find the predecessor.
+	*/
+	Key getPredecessor(Key maxSmallerTree, Key limit) const;
+
+	/**
+	* Returns the node of the smallest value >= limit, or 0 if all values are smaller.
+	*/
+	uint64_t findSuccessorNode(Key limit) const;
+
+	/**
+	* Returns the node of the smallest value, or 0 for an empty bucket.
+	*/
+	uint64_t firstNode() const;
+
+	/**
+	* Returns the node following the given one in sorted order, or 0 if it is the last one.
+	*/
+	uint64_t nextNode(uint64_t node) const;
+
+	/**
+	* Returns the value of the given node. Nodes are numbered from 1.
+	*/
+	Key getValue(uint64_t node) const;
+
+	/**
+	* Returns the smallest value of the bucket. The bucket must not be empty.
+	*/
+	Key getMinimum() const;
+
+	/**
+	* Counts the values <= limit.
+	*/
+	uint64_t countAtMost(Key limit) const;
+
+	/**
+	* Writes all values of the bucket to out in sorted order.
+	*
+	* @param out The array receiving the values. Must have space for getSize() values.
+	*/
+	void getSortedValues(Key* out) const;
+
+	/**
+	* Returns the number of values stored in the bucket.
+	*/
+	uint64_t getSize() const;
+
+	/**
+	* Returns the width of the deltas of the given sorted values.
+	*/
+	static uint64_t widthOf(const Key* sorted, uint64_t size);
+
+	/**
+	* Returns the number of words of a bucket with size values of the given width.
+	*/
+	static uint64_t wordCount(uint64_t size, uint64_t width);
+
+	/**
+	* Writes the bucket for the given sorted values to out.
+	*
+	* @param sorted The sorted values of the bucket.
+	* @param size The number of values. Less than 256.
+	* @param out The array receiving the bucket. Must have space for wordCount(size, widthOf(sorted, size)) words.
+	* @return The number of words written.
+	*/
+	static uint64_t layout(const Key* sorted, uint64_t size, uint64_t* out);
+
+	/**
+	* Constructs a view on a bucket, which was written by layout().
+	*
+	* @param words The first word of the bucket.
+	*/
+	PackedBucket(const uint64_t* words);
+};
\ No newline at end of file
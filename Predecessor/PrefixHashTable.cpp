@@ -0,0 +1,142 @@
+#include "PrefixHashTable.h"
+#include "../Util/Profile.h"
+
+template <typename Key>
+typename PrefixHashTable<Key>::Slot emptySlot() {
+	return { 0, TrieNode<Key>::NONE, TrieNode<Key>::NONE };
+}
+
+template <typename Key>
+bool isEmpty(const typename PrefixHashTable<Key>::Slot& slot) {
+	return slot.leftMax == TrieNode<Key>::NONE && slot.rightMin == TrieNode<Key>::NONE;
+}
+
+
+template <typename Key>
+uint64_t PrefixHashTable<Key>::slotIndex(Key key) const {
+	return (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits_);
+}
+
+
+template <typename Key>
+void PrefixHashTable<Key>::grow() {
+	std::vector<Slot> oldSlots(slots_.size() * 2, emptySlot<Key>());
+	oldSlots.swap(slots_.edit());
+	bits_++;
+	size_ = 0;
+	for (uint64_t i = 0; i < oldSlots.size(); i++) {
+		if (!isEmpty<Key>(oldSlots[i])) {
+			insert(oldSlots[i].key, oldSlots[i].leftMax, oldSlots[i].rightMin);
+		}
+	}
+}
+
+
+template <typename Key>
+void PrefixHashTable<Key>::insert(Key key, uint32_t leftMax, uint32_t rightMin) {
+	if (2 * (size_ + 1) > slots_.size()) {
+		grow();
+	}
+	std::vector<Slot>& slots = slots_.edit();
+	uint64_t mask = slots.size() - 1;
+	uint64_t index = slotIndex(key);
+	while (!isEmpty<Key>(slots[index])) {
+		if (slots[index].key == key) {
+			slots[index].leftMax = leftMax;
+			slots[index].rightMin = rightMin;
+			return;
+		}
+		index = (index + 1) & mask;
+	}
+	slots[index] = { key, leftMax, rightMin };
+	size_++;
+}
+
+
+template <typename Key>
+void PrefixHashTable<Key>::erase(Key key) {
+	std::vector<Slot>& slots = slots_.edit();
+	uint64_t mask = slots.size() - 1;
+	uint64_t hole = slotIndex(key);
+	while (!isEmpty<Key>(slots[hole]) && slots[hole].key != key) {
+		hole = (hole + 1) & mask;
+	}
+	if (isEmpty<Key>(slots[hole])) {
+		return;
+	}
+	// Move every following slot of the cluster into the hole, if the hole is not in front of its home slot.
+	for (uint64_t index = (hole + 1) & mask; !isEmpty<Key>(slots[index]); index = (index + 1) & mask) {
+		uint64_t home = slotIndex(slots[index].key);
+		if (((index - home) & mask) >= ((index - hole) & mask)) {
+			slots[hole] = slots[index];
+			hole = index;
+		}
+	}
+	slots[hole] = emptySlot<Key>();
+	size_--;
+}
+
+
+template <typename Key>
+const typename PrefixHashTable<Key>::Slot* PrefixHashTable<Key>::find(Key key) const {
+	const Slot* slots = slots_.data();
+	uint64_t mask = slots_.size() - 1;
+	uint64_t start = slotIndex(key);
+	uint64_t index = start;
+	// Terminates, since the load factor guarantees at least one empty slot.
+	while (!isEmpty<Key>(slots[index])) {
+		if (slots[index].key == key) {
+			countHashProbes(((index - start) & mask) + 1);
+			return &slots[index];
+		}
+		index = (index + 1) & mask;
+	}
+	countHashProbes(((index - start) & mask) + 1);
+	return nullptr;
+}
+
+
+template <typename Key>
+void PrefixHashTable<Key>::prefetch(Key key) const {
+	__builtin_prefetch(&slots_[slotIndex(key)]);
+}
+
+
+template <typename Key>
+void PrefixHashTable<Key>::save(SnapshotWriter* writer) const {
+	writer->writeValue(bits_);
+	writer->writeValue(size_);
+	writer->writeArray(slots_);
+}
+
+
+template <typename Key>
+PrefixHashTable<Key> PrefixHashTable<Key>::load(SnapshotReader* reader) {
+	PrefixHashTable table;
+	table.bits_ = reader->readValue();
+	table.size_ = reader->readValue();
+	table.slots_ = reader->readArray<Slot>();
+	if (table.bits_ == 0 || table.bits_ > 63 || table.slots_.size() != (1ULL << table.bits_) || 2 * table.size_ > table.slots_.size()) {
+		// Never hand out a table whose probing could run out of bounds, or never terminate.
+		table.bits_ = 1;
+		table.size_ = 0;
+		table.slots_ = FlatArray<Slot>(std::vector<Slot>(2, emptySlot<Key>()));
+		reader->invalidate();
+	}
+	return table;
+}
+
+
+template <typename Key>
+PrefixHashTable<Key>::PrefixHashTable(uint64_t expectedSize) :
+	bits_(1) {
+	// Smallest power of 2 that keeps the load factor at or below 1/2.
+	while ((1ULL << bits_) < 2 * expectedSize) {
+		bits_++;
+	}
+	slots_ = FlatArray<Slot>(std::vector<Slot>(1ULL << bits_, emptySlot<Key>()));
+}
+
+
+template class PrefixHashTable<uint32_t>;
+template class PrefixHashTable<uint64_t>;
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "TrieNode.h"
+#include "../Util/FlatArray.h"
+#include "../IO/Snapshot.h"
+
+/**
+* Hash table for a single level of the trie, mapping the integer prefix of a node to the node itself.
+* It uses open addressing with linear probing and stores the keys together with the values in one slot.
+* A slot is 16 bytes for 64 bit keys and 12 bytes for 32 bit keys, so a lookup usually touches a single cache line.
+* The load factor is kept at or below 1/2, which keeps the probe sequences short.
+* Key is the unsigned integer type of the prefixes.
+*/
+template <typename Key>
+class PrefixHashTable {
+
+public:
+	/**
+	* An inner node of the trie with the indices of its leftMax and rightMin leaves, which may be TrieNode::NONE.
+	* On the last level, the nodes are the leaves themselves, so both indices are the index of the leaf.
+	* A slot with both indices set to TrieNode::NONE is empty. We can't use a key for that, since every value is a valid prefix.
+	*/
+	struct Slot {
+		Key key;
+		uint32_t leftMax;
+		uint32_t rightMin;
+	};
+
+private:
+	// All slots of the table. The length is always a power of 2.
+	FlatArray<Slot> slots_;
+
+	// Number of bits used from the hash to get the slot index. slots_.size() == 2^bits_.
+	uint64_t bits_;
+
+	// Number of occupied slots.
+	uint64_t size_ = 0;
+
+	/**
+	* Fibonacci hashing. Multiplies with 2^64 / golden ratio and takes the highest bits_ bits as slot index.
+	*/
+	uint64_t slotIndex(Key key) const;
+
+	/**
+	* Doubles the number of slots and reinserts all stored nodes.
+	*/
+	void grow();
+
+	PrefixHashTable() {}
+
+public:
+	/**
+	* Inserts the node for the given prefix. If the prefix is already present, the stored node gets replaced.
+	*/
+	void insert(Key key, uint32_t leftMax, uint32_t rightMin);
+
+	/**
+	* Removes the node stored for the given prefix, if there is one.
+	* The following slots of the probe sequence are shifted back into the gap, so lookups never need to skip deleted slots.
+	*/
+	void erase(Key key);
+
+	/**
+	* Returns the slot of the node stored for the given prefix, or nullptr if the prefix is not present.
+	*/
+	const Slot* find(Key key) const;
+
+	/**
+	* Hints the CPU to load the slot where the search for the given prefix starts.
+	*/
+	void prefetch(Key key) const;
+
+	void save(SnapshotWriter* writer) const;
+
+	/**
+	* Loads a table written by save(). The slots stay in the snapshot mapping.
+	*/
+	static PrefixHashTable load(SnapshotReader* reader);
+
+	/**
+	* Constructs an empty table which can hold the given number of nodes without growing.
+	*/
+	PrefixHashTable(uint64_t expectedSize);
+};
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "ShardedYTrie.h"
+#include "../Util/Parallel.h"
+#include "../Util/Numa.h"
+#include "../IO/Snapshot.h"
+#include <algorithm>
+#include <climits>
+
+
+template <typename Key>
+uint64_t ShardedYTrie<Key>::shardOf(Key key) const {
+	if (shift_ >= 8 * sizeof(Key)) {
+		return 0;
+	}
+	// Keys above the largest value can have higher top bits than any shard. Their predecessor is in the last shard.
+	uint64_t shard = (uint64_t)(key >> shift_);
+	return shard < shards_.size() ? shard : shards_.size() - 1;
+}
+
+
+template <typename Key>
+uint64_t ShardedYTrie<Key>::nodeOf(uint64_t shard, uint64_t nodeCount) const {
+	return shard * nodeCount / shards_.size();
+}
+
+
+template <typename Key>
+void ShardedYTrie<Key>::fixMissing(uint64_t shard, size_t n, uint64_t* out) const {
+	uint64_t fallback = previousMaximum_[shard] == NOT_FOUND ? ULLONG_MAX : previousMaximum_[shard];
+	for (size_t i = 0; i < n; i++) {
+		if (out[i] == ULLONG_MAX) {
+			out[i] = fallback;
+		}
+	}
+}
+
+
+template <typename Key>
+ShardedYTrie<Key>::ShardedYTrie(const std::vector<Key>& values, uint64_t threads, uint64_t shards, bool packedBuckets) :
+	size_(values.size()) {
+	std::vector<std::vector<int>> nodes = numaNodes();
+	if (shards == 0) {
+		shards = resolveThreads(threads) > nodes.size() ? resolveThreads(threads) : nodes.size();
+	}
+	uint64_t shardBits = 0;
+	while ((1ULL << shardBits) < shards && (1ULL << shardBits) < maxShards_) {
+		shardBits++;
+	}
+	// Only the bits up to the largest value are split, so small values still spread over all shards.
+	uint64_t valueBits = values.empty() ? 0 : 64 - __builtin_clzll((uint64_t)values.back() | 1);
+	if (shardBits > valueBits) {
+		shardBits = valueBits;
+	}
+	shift_ = valueBits - shardBits;
+	uint64_t count = 1ULL << shardBits;
+	std::vector<uint64_t> bounds(count + 1, values.size());
+	// The first shard starts at the first value. Further shards only exist for shardBits > 0, so their shift is below 64, also if the largest value has all 64 bits.
+	bounds[0] = 0;
+	for (uint64_t s = 1; s < count; s++) {
+		bounds[s] = std::lower_bound(values.begin(), values.end(), (Key)(s << shift_)) - values.begin();
+	}
+	previousMaximum_.assign(count, (Key)NOT_FOUND);
+	for (uint64_t s = 1; s < count; s++) {
+		previousMaximum_[s] = bounds[s] > bounds[s - 1] ? values[bounds[s] - 1] : previousMaximum_[s - 1];
+	}
+	shards_.assign(count, nullptr);
+	parallelFor(count, threads, [&](uint64_t begin, uint64_t end) {
+		std::vector<int> cpus = threadCpus();
+		for (uint64_t s = begin; s < end; s++) {
+			pinThread(nodes[nodeOf(s, nodes.size())]);
+			shards_[s] = new YTrie<Key>(values.data() + bounds[s], bounds[s + 1] - bounds[s], packedBuckets);
+		}
+		pinThread(cpus);
+	});
+}
+
+
+template <typename Key>
+Key ShardedYTrie<Key>::getPredecessor(Key limit) const {
+	uint64_t shard = shardOf(limit);
+	Key predecessor = shards_[shard]->getPredecessor(limit);
+	return predecessor != NOT_FOUND ? predecessor : previousMaximum_[shard];
+}
+
+
+template <typename Key>
+void ShardedYTrie<Key>::getPredecessors(const uint64_t* queries, size_t n, uint64_t* out) const {
+	size_t begin = 0;
+	while (begin < n) {
+		uint64_t shard = shardOf(queries[begin] > NOT_FOUND ? NOT_FOUND : (Key)queries[begin]);
+		size_t end = begin + 1;
+		while (end < n && shardOf(queries[end] > NOT_FOUND ? NOT_FOUND : (Key)queries[end]) == shard) {
+			end++;
+		}
+		shards_[shard]->getPredecessors(queries + begin, end - begin, out + begin);
+		fixMissing(shard, end - begin, out + begin);
+		begin = end;
+	}
+}
+
+
+template <typename Key>
+void ShardedYTrie<Key>::getPredecessorsLocal(const uint64_t* queries, size_t n, uint64_t* out, uint64_t threads) const {
+	uint64_t count = shards_.size();
+	uint64_t chunks = resolveThreads(threads);
+	if (chunks > n) {
+		chunks = n == 0 ? 1 : n;
+	}
+	// Counting sort by shard: every chunk of queries counts its queries per shard, then places them behind those of the same shard from earlier chunks.
+	std::vector<uint64_t> positions(chunks * count, 0);
+	parallelFor(chunks, threads, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t c = begin; c < end; c++) {
+			for (uint64_t i = n * c / chunks; i < n * (c + 1) / chunks; i++) {
+				positions[c * count + shardOf(queries[i] > NOT_FOUND ? NOT_FOUND : (Key)queries[i])]++;
+			}
+		}
+	});
+	std::vector<uint64_t> shardBegin(count + 1, n);
+	uint64_t position = 0;
+	for (uint64_t s = 0; s < count; s++) {
+		shardBegin[s] = position;
+		for (uint64_t c = 0; c < chunks; c++) {
+			uint64_t queriesInChunk = positions[c * count + s];
+			positions[c * count + s] = position;
+			position += queriesInChunk;
+		}
+	}
+	std::vector<uint64_t> grouped(n);
+	std::vector<uint64_t> order(n);
+	parallelFor(chunks, threads, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t c = begin; c < end; c++) {
+			for (uint64_t i = n * c / chunks; i < n * (c + 1) / chunks; i++) {
+				uint64_t target = positions[c * count + shardOf(queries[i] > NOT_FOUND ? NOT_FOUND : (Key)queries[i])]++;
+				grouped[target] = queries[i];
+				order[target] = i;
+			}
+		}
+	});
+	std::vector<std::vector<int>> nodes = numaNodes();
+	parallelFor(count, threads, [&](uint64_t begin, uint64_t end) {
+		std::vector<int> cpus = threadCpus();
+		std::vector<uint64_t> answers;
+		for (uint64_t s = begin; s < end; s++) {
+			uint64_t length = shardBegin[s + 1] - shardBegin[s];
+			if (length == 0) {
+				continue;
+			}
+			pinThread(nodes[nodeOf(s, nodes.size())]);
+			answers.resize(length);
+			shards_[s]->getPredecessors(grouped.data() + shardBegin[s], length, answers.data());
+			fixMissing(s, length, answers.data());
+			for (uint64_t k = 0; k < length; k++) {
+				out[order[shardBegin[s] + k]] = answers[k];
+			}
+		}
+		pinThread(cpus);
+	});
+}
+
+
+template <typename Key>
+uint64_t ShardedYTrie<Key>::getSize() const {
+	return size_;
+}
+
+
+template <typename Key>
+bool ShardedYTrie<Key>::save(std::string path) const {
+	SnapshotWriter writer(path, SNAPSHOT_KIND_SHARDED_YTRIE);
+	writer.writeValue(snapshotValueType<Key>());
+	writer.writeValue(size_);
+	writer.writeValue(shift_);
+	writer.writeArray(FlatArray<Key>(previousMaximum_.data(), previousMaximum_.size()));
+	bool saved = writer.finish();
+	for (uint64_t s = 0; s < shards_.size(); s++) {
+		saved = shards_[s]->save(path + "." + std::to_string(s)) && saved;
+	}
+	return saved;
+}
+
+
+template <typename Key>
+ShardedYTrie<Key>* ShardedYTrie<Key>::load(std::string path) {
+	SnapshotReader reader(path, SNAPSHOT_KIND_SHARDED_YTRIE);
+	ShardedYTrie* trie = new ShardedYTrie();
+	if (reader.readValue() != snapshotValueType<Key>()) {
+		reader.invalidate();
+	}
+	trie->size_ = reader.readValue();
+	trie->shift_ = reader.readValue();
+	FlatArray<Key> previousMaximum = reader.readArray<Key>();
+	uint64_t count = previousMaximum.size();
+	if (count == 0 || count > maxShards_ || (count & (count - 1)) != 0 || trie->shift_ > 8 * sizeof(Key)) {
+		reader.invalidate();
+	}
+	uint64_t size = 0;
+	for (uint64_t s = 0; s < count && reader.isValid(); s++) {
+		trie->previousMaximum_.push_back(previousMaximum[s]);
+		trie->shards_.push_back(YTrie<Key>::load(path + "." + std::to_string(s)));
+		if (trie->shards_.back() == nullptr) {
+			reader.invalidate();
+		}
+		else {
+			size += trie->shards_.back()->getSize();
+		}
+	}
+	if (!reader.isValid() || size != trie->size_) {
+		delete trie;
+		return nullptr;
+	}
+	return trie;
+}
+
+
+template <typename Key>
+ShardedYTrie<Key>::~ShardedYTrie() {
+	for (YTrie<Key>* shard : shards_) {
+		delete shard;
+	}
+}
+
+
+template class ShardedYTrie<uint32_t>;
+template class ShardedYTrie<uint64_t>;
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "YTrie.h"
+
+/**
+* A YTrie split into independent shards by the top bits of the keys, so every shard can live in the memory of another NUMA node.
+* The universe up to the largest value is split into a power of two shards of equal ranges, and shard s holds the values v with v >> shift_ == s.
+* Every shard is built by a thread pinned to the node of the shard, so the memory of the shard is allocated on that node when it is first touched.
+* Queries go to the shard of their limit. If all values of that shard are larger, the predecessor is the largest value of the shards before, which is stored per shard.
+* Key is the unsigned integer type of the values, uint32_t or uint64_t.
+*/
+template <typename Key>
+class ShardedYTrie {
+
+public:
+	// Answer of queries without a result. Same as YTrie<Key>::NOT_FOUND.
+	static const Key NOT_FOUND = YTrie<Key>::NOT_FOUND;
+
+private:
+	// The shards. Empty shards are empty tries.
+	std::vector<YTrie<Key>*> shards_;
+
+	// The shard of a key is key >> shift_, or the last shard for keys above the largest value. Can be 8 * sizeof(Key) for a single shard, then all keys go to shard 0.
+	uint64_t shift_;
+
+	// For every shard, the largest value of all shards before it, or NOT_FOUND if they are all empty.
+	std::vector<Key> previousMaximum_;
+
+	// Number of values in all shards.
+	uint64_t size_;
+
+	// Most shards a trie is split into.
+	static const uint64_t maxShards_ = 1024;
+
+	/**
+	* Returns the shard of the key.
+	*/
+	uint64_t shardOf(Key key) const;
+
+	/**
+	* Returns the NUMA node a shard belongs to. The shards are spread evenly, neighbouring shards share a node.
+	*/
+	uint64_t nodeOf(uint64_t shard, uint64_t nodeCount) const;
+
+	/**
+	* Replaces the missing answers of queries to the given shard, which are ULLONG_MAX, by the largest value before the shard.
+	*/
+	void fixMissing(uint64_t shard, size_t n, uint64_t* out) const;
+
+	ShardedYTrie() {}
+
+public:
+	/**
+	* Splits the sorted values into shards and builds the tries of all shards on the given number of threads.
+	* The values are only read, the shards keep their own copy.
+	*
+	* @param values The sorted values.
+	* @param threads The number of threads building the shards. 0 uses all hardware threads.
+	* @param shards The number of shards, rounded up to a power of two and at most 1024. 0 uses one per thread, but at least one per NUMA node.
+	* @param packedBuckets Whether the shards store their buckets as PackedBuckets, see YTrie.
+	*/
+	ShardedYTrie(const std::vector<Key>& values, uint64_t threads = 1, uint64_t shards = 0, bool packedBuckets = false);
+
+	/**
+	* Performs the predecessor query on the shard of limit. It only reads the tries, so it can be called from multiple threads at the same time.
+	*
+	* @param limit The number we want to find the predeccesor of.
+	* @return The predecessor, or NOT_FOUND if all values are larger than limit.
+	*/
+	Key getPredecessor(Key limit) const;
+
+	/**
+	* Performs the predecessor query for all n queries and writes the answers into out, with the same conventions as YTrie::getPredecessors().
+	* Runs of consecutive queries to the same shard are answered by one call on the shard, so the finger search of the trie still works for sorted queries.
+	*
+	* @param queries The numbers we want to find the predecessors of.
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	*/
+	void getPredecessors(const uint64_t* queries, size_t n, uint64_t* out) const;
+
+	/**
+	* Like getPredecessors(), but answers the queries of every shard on a thread pinned to the node of the shard, so the tries are only read from local memory.
+	* The queries are grouped by shard first, keeping their order within a shard.
+	*
+	* @param queries The numbers we want to find the predecessors of.
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	* @param threads The number of threads grouping and answering the queries. 0 uses all hardware threads.
+	*/
+	void getPredecessorsLocal(const uint64_t* queries, size_t n, uint64_t* out, uint64_t threads) const;
+
+	/**
+	* Returns the number of values in all shards.
+	*/
+	uint64_t getSize() const;
+
+	/**
+	* Saves the shard layout to a snapshot file at path (see IO/Snapshot.h), and shard s to its own YTrie snapshot at path + "." + s.
+	* The layout is: the key type, size, shift, number of shards and the largest values before the shards.
+	*
+	* @param path The snapshot file to write.
+	* @return false, if any snapshot could not be written.
+	*/
+	bool save(std::string path) const;
+
+	/**
+	* Loads a ShardedYTrie from the snapshot files written by save(). The shards stay in the memory mappings of their snapshots.
+	*
+	* @param path The snapshot file of the shard layout.
+	* @return The loaded trie, or nullptr if any file is no valid snapshot of it.
+	*/
+	static ShardedYTrie* load(std::string path);
+
+	/**
+	* Deconstructs all shards.
+	*/
+	~ShardedYTrie();
+};
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "StaticPredecessor.h"
+#include "../IO/Snapshot.h"
+#include <climits>
+
+
+template <typename Key>
+void StaticPredecessor<Key>::build(const Key* sorted, uint64_t* nextValue, uint64_t node, Key* nodes) const {
+	if (node >= nodeCount_) {
+		return;
+	}
+	for (uint64_t i = 0; i < nodeSize_; i++) {
+		build(sorted, nextValue, node * (nodeSize_ + 1) + i + 1, nodes);
+		nodes[node * nodeSize_ + i] = *nextValue < size_ ? sorted[(*nextValue)++] : NOT_FOUND;
+	}
+	build(sorted, nextValue, node * (nodeSize_ + 1) + nodeSize_ + 1, nodes);
+}
+
+
+template <typename Key>
+StaticPredecessor<Key>::StaticPredecessor(const Key* values, uint64_t size) :
+	size_(size) {
+	nodeCount_ = (size + nodeSize_ - 1) / nodeSize_;
+	if (size > 0) {
+		minimalValue_ = values[0];
+		maximalValue_ = values[size - 1];
+	}
+	// One node more than needed, so the nodes can start at the first cache line boundary of the allocation.
+	std::vector<Key> tree((nodeCount_ + 1) * nodeSize_);
+	nodeOffset_ = (64 - (uintptr_t)tree.data() % 64) % 64 / sizeof(Key);
+	uint64_t nextValue = 0;
+	build(values, &nextValue, 0, tree.data() + nodeOffset_);
+	tree_ = FlatArray<Key>(std::move(tree));
+}
+
+
+template <typename Key>
+StaticPredecessor<Key>::StaticPredecessor(const std::vector<Key>& values) :
+	StaticPredecessor(values.data(), values.size()) {
+}
+
+
+template <typename Key>
+Key StaticPredecessor<Key>::search(Key limit) const {
+	const Key* nodes = tree_.data() + nodeOffset_;
+	Key predecessor = minimalValue_;
+	uint64_t node = 0;
+	while (node < nodeCount_) {
+		// The keys of a node are sorted and the padding is larger than limit, so the count is the child to descend into.
+		const Key* keys = nodes + node * nodeSize_;
+		uint64_t count = 0;
+		for (uint64_t i = 0; i < nodeSize_; i++) {
+			count += keys[i] <= limit;
+		}
+		// The largest key <= limit on the path is the predecessor. Later ones on the path are always larger.
+		predecessor = count > 0 ? keys[count - 1] : predecessor;
+		node = node * (nodeSize_ + 1) + count + 1;
+	}
+	return predecessor;
+}
+
+
+template <typename Key>
+Key StaticPredecessor<Key>::getPredecessor(Key limit) const {
+	if (limit < minimalValue_) {
+		return NOT_FOUND;
+	}
+	if (limit >= maximalValue_) {
+		return maximalValue_;
+	}
+	return search(limit);
+}
+
+
+template <typename Key>
+void StaticPredecessor<Key>::getPredecessors(const uint64_t* queries, size_t n, uint64_t* out) const {
+	for (size_t i = 0; i < n; i++) {
+		Key limit = queries[i] > NOT_FOUND ? NOT_FOUND : (Key)queries[i];
+		if (limit < minimalValue_) {
+			out[i] = ULLONG_MAX;
+		}
+		else if (limit >= maximalValue_) {
+			// An empty tree has NOT_FOUND as maximum, which still has to become ULLONG_MAX.
+			out[i] = size_ == 0 ? ULLONG_MAX : maximalValue_;
+		}
+		else {
+			out[i] = search(limit);
+		}
+	}
+}
+
+
+template <typename Key>
+uint64_t StaticPredecessor<Key>::getSize() const {
+	return size_;
+}
+
+
+template <typename Key>
+bool StaticPredecessor<Key>::save(std::string path) const {
+	SnapshotWriter writer(path, SNAPSHOT_KIND_STATIC_PREDECESSOR);
+	writer.writeValue(snapshotValueType<Key>());
+	writer.writeValue(size_);
+	writer.writeValue(minimalValue_);
+	writer.writeValue(maximalValue_);
+	// Only the nodes are written, so the snapshot starts them at an aligned offset itself.
+	writer.writeArray(FlatArray<Key>(tree_.data() + nodeOffset_, nodeCount_ * nodeSize_));
+	return writer.finish();
+}
+
+
+template <typename Key>
+StaticPredecessor<Key>* StaticPredecessor<Key>::load(std::string path) {
+	SnapshotReader reader(path, SNAPSHOT_KIND_STATIC_PREDECESSOR);
+	StaticPredecessor* tree = new StaticPredecessor();
+	if (reader.readValue() != snapshotValueType<Key>()) {
+		reader.invalidate();
+	}
+	tree->size_ = reader.readValue();
+	tree->minimalValue_ = (Key)reader.readValue();
+	tree->maximalValue_ = (Key)reader.readValue();
+	tree->tree_ = reader.readArray<Key>();
+	tree->nodeCount_ = tree->size_ > tree->tree_.size() ? 0 : (tree->size_ + nodeSize_ - 1) / nodeSize_; // Also protects the addition from overflowing.
+	if (tree->size_ > tree->tree_.size() || tree->tree_.size() != tree->nodeCount_ * nodeSize_ || (tree->size_ > 0 && tree->minimalValue_ > tree->maximalValue_)) {
+		reader.invalidate();
+	}
+	if (!reader.isValid()) {
+		delete tree;
+		return nullptr;
+	}
+	tree->mapping_ = reader.getMapping();
+	return tree;
+}
+
+
+template class StaticPredecessor<uint32_t>;
+template class StaticPredecessor<uint64_t>;
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Util/FlatArray.h"
+#include "../IO/MappedFile.h"
+
+/**
+* Static data structure for predecessor queries, as alternative to the YTrie for key sets which never change.
+* The sorted values are stored as implicit B-tree (S-tree): every node is one cache line of nodeSize_ keys, and the children of node k are the nodes k * (nodeSize_ + 1) + i + 1 for i in [0, nodeSize_].
+* A query descends from the root, counting the keys <= limit in every node without branches, which also picks the child. The predecessor is the largest of these keys on the path.
+* So a query reads log_(nodeSize_ + 1)(n) cache lines in a fixed order, the upper levels of which stay in the cache, instead of the random hash table probes of the YTrie.
+* Like the YTrie, it can be saved to a snapshot and used directly from a memory mapping of it.
+* Key is the unsigned integer type of the values, uint32_t or uint64_t.
+*/
+template <typename Key>
+class StaticPredecessor {
+
+public:
+	// Answer of queries without a result. Same as YTrie<Key>::NOT_FOUND.
+	static const Key NOT_FOUND = std::numeric_limits<Key>::max();
+
+private:
+	// Keys per node, so a node fills one cache line.
+	static const uint64_t nodeSize_ = 64 / sizeof(Key);
+
+	// Number of values.
+	uint64_t size_ = 0;
+
+	// Number of nodes, the last ones are padded with NOT_FOUND.
+	uint64_t nodeCount_ = 0;
+
+	// The nodes, starting at nodeOffset_, so the nodes of built structures lie on cache line boundaries. Loaded ones always start at 0.
+	FlatArray<Key> tree_;
+	uint64_t nodeOffset_ = 0;
+
+	// Smallest and largest value. Queries outside of them are answered without the tree.
+	Key minimalValue_ = NOT_FOUND;
+	Key maximalValue_ = NOT_FOUND;
+
+	// The snapshot the tree points into, if the data structure was loaded. Empty for built ones.
+	std::shared_ptr<MappedFile> mapping_;
+
+	/**
+	* Recursively fills the keys of node and its subtrees in order, which places the sorted values exactly in the order of the tree.
+	*
+	* @param sorted All values.
+	* @param nextValue The index of the next value in the sorted values that gets placed. Starts at 0.
+	* @param node The node we are filling right now. Starts at the root (0).
+	* @param nodes The array receiving the nodes.
+	*/
+	void build(const Key* sorted, uint64_t* nextValue, uint64_t node, Key* nodes) const;
+
+	/**
+	* Searches the tree for the largest value <= limit. Requires minimalValue_ <= limit < maximalValue_.
+	*/
+	Key search(Key limit) const;
+
+	StaticPredecessor() {}
+
+public:
+	/**
+	* Constructs the tree from the given sorted values. The values may be empty. They are only read, the tree keeps its own copy.
+	*/
+	StaticPredecessor(const Key* values, uint64_t size);
+
+	/**
+	* Constructs the tree from the sorted values of the vector, see above.
+	*/
+	StaticPredecessor(const std::vector<Key>& values);
+
+	/**
+	* Performs the predecessor query. It only reads the tree, so it can be called from multiple threads at the same time.
+	*
+	* @param limit The number we want to find the predeccesor of.
+	* @return The predecessor, or NOT_FOUND if all values are larger than limit.
+	*/
+	Key getPredecessor(Key limit) const;
+
+	/**
+	* Performs the predecessor query for all n queries and writes the answers into out, with the same conventions as YTrie::getPredecessors():
+	* queries and answers are 64 bit for every key width, and missing predecessors are ULLONG_MAX.
+	*
+	* @param queries The numbers we want to find the predecessors of.
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	*/
+	void getPredecessors(const uint64_t* queries, size_t n, uint64_t* out) const;
+
+	/**
+	* Returns the number of values.
+	*/
+	uint64_t getSize() const;
+
+	/**
+	* Saves the data structure to a snapshot file (see IO/Snapshot.h).
+	* The layout is: the key type, size, minimal and maximal value and the nodes.
+	*
+	* @param path The snapshot file to write.
+	* @return false, if the snapshot could not be written.
+	*/
+	bool save(std::string path) const;
+
+	/**
+	* Loads a StaticPredecessor from a snapshot file written by save(). The nodes stay in the memory mapping of the snapshot.
+	*
+	* @param path The snapshot file to read.
+	* @return The loaded data structure, or nullptr if the file is no valid snapshot of a StaticPredecessor with this key type.
+	*/
+	static StaticPredecessor* load(std::string path);
+};
\ No newline at end of file
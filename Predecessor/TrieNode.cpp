@@ -1,65 +1,77 @@
 #include "TrieNode.h"
 
 
-bool TrieNode::isLeaf() {
-	return leaf_;
+template <typename Key>
+Key TrieNode<Key>::getValue() const {
+	return value_;
 }
 
 
-uint64_t TrieNode::getValue() {
-	return value_;
+template <typename Key>
+void TrieNode<Key>::setValue(Key value) {
+	value_ = value;
+}
+
+
+template <typename Key>
+uint32_t TrieNode<Key>::previous() const {
+	return previous_;
 }
 
 
-TrieNode* TrieNode::getLeftMax() {
-	if (!leaf_) {
-		return leftMax_;
-	}
-	return nullptr;
+template <typename Key>
+uint32_t TrieNode<Key>::next() const {
+	return next_;
 }
 
-TrieNode* TrieNode::previous() {
-	if (leaf_) {
-		return leftMax_;
-	}
-	return nullptr;
+
+template <typename Key>
+void TrieNode<Key>::setPrevious(uint32_t previous) {
+	previous_ = previous;
 }
 
 
-TrieNode* TrieNode::getRightMin() {
-	if (!leaf_) {
-		return rightMin_;
-	}
-	return nullptr;
+template <typename Key>
+void TrieNode<Key>::setNext(uint32_t next) {
+	next_ = next;
 }
 
-TrieNode* TrieNode::next() {
-	if (leaf_) {
-		return rightMin_;
-	}
-	return nullptr;
+
+template <typename Key>
+uint64_t TrieNode<Key>::getBucketOffset() const {
+	return bucketOffset_;
 }
 
-void TrieNode::setNext(TrieNode* next) {
-	rightMin_ = next;
+
+template <typename Key>
+uint64_t TrieNode<Key>::getBucketSize() const {
+	return bucketSize_;
 }
 
 
-BST* TrieNode::getBinarySearchTree() {
-	if (leaf_) {
-		return tree_;
-	}
-	return nullptr;
+template <typename Key>
+uint64_t TrieNode<Key>::getBucketCapacity() const {
+	return bucketCapacity_;
 }
 
 
-TrieNode::TrieNode(TrieNode* leftMax, TrieNode* rightMin) :
-	leaf_(false),
-	leftMax_(leftMax),
-	rightMin_(rightMin) {}
+template <typename Key>
+void TrieNode<Key>::setBucket(uint64_t offset, uint32_t size, uint32_t capacity) {
+	bucketOffset_ = offset;
+	bucketSize_ = (BucketCount)size;
+	bucketCapacity_ = (BucketCount)capacity;
+}
+
 
-TrieNode::TrieNode(uint64_t value, TrieNode* previous, BST* tree) :
-	leaf_(true),
+template <typename Key>
+TrieNode<Key>::TrieNode(Key value, uint32_t previous, uint64_t bucketOffset, uint32_t bucketSize, uint32_t bucketCapacity) :
+	bucketOffset_(bucketOffset),
 	value_(value),
-	leftMax_(previous),
-	tree_(tree) {}
\ No newline at end of file
+	previous_(previous),
+	next_(NONE),
+	bucketSize_((BucketCount)bucketSize),
+	bucketCapacity_((BucketCount)bucketCapacity) {}
+
+
+template class TrieNode<uint32_t>;
+template class TrieNode<uint64_t>;
\ No newline at end of file
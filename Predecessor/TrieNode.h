@@ -1,88 +1,88 @@
 #pragma once
 #include <cstdint>
 #include <climits>
-#include "BST.h"
+#include <type_traits>
 
 /**
-* Class representing a node in the trie. 
-* It fulfills two purposes at once.
-* Inner Trie nodes only know the leftMax and rightMin nodes, to support efficient predecessor queries.
-* Outer Trie nodes (leaves) know the left and right leaf neighbours and form an implicit linked list. They also hold a value.
+* Class representing a leaf of the trie.
+* The leaves know the left and right leaf neighbours and form an implicit linked list. They also hold a value (the representant).
+* Neighbours are stored as indices into the leaf array of the trie instead of pointers, so a trie can be saved and memory mapped as it is.
+* Every leaf also knows where its binary search tree lies in the bucket array of the trie, and how many values fit there before it has to move.
+* For packed buckets (see PackedBucket), the offset and capacity count words of the packed bucket array instead.
+* Inner trie nodes only know the leftMax and rightMin leaves and live directly in the hash tables of their level (see PrefixHashTable).
+* Key is the unsigned integer type of the values. A leaf takes 32 bytes for 64 bit keys and 24 bytes for 32 bit keys.
 */
+template <typename Key>
 class TrieNode {
 
+public:
+	// Index used for a missing neighbour.
+	static const uint32_t NONE = UINT_MAX;
+
 private:
-	bool leaf_ = false;
+	// Buckets never hold more than 2 * 63 values, so half the width of a key is enough for their sizes.
+	// This also keeps the layout free of uninitialized padding for both key widths, since leaves are written to snapshots byte by byte.
+	typedef typename std::conditional<sizeof(Key) == 8, uint32_t, uint16_t>::type BucketCount;
 
-	// These are always set. For leaves, they represent the previous and next pointer in the double linked list.
-	TrieNode* leftMax_ = nullptr;
-	TrieNode* rightMin_= nullptr;
+	// Position of the first value of the binary search tree in the bucket array.
+	uint64_t bucketOffset_;
 
-	// This is only set for a leaf, else nullptr.
-	BST* tree_ = nullptr; 
+	Key value_;
 
-	// Set to max so predecessor queries fail when not set.
-	uint64_t value_ = ULLONG_MAX;
+	// These represent the previous and next pointer in the double linked list.
+	uint32_t previous_;
+	uint32_t next_;
 
-public:
+	// Number of values in the binary search tree.
+	BucketCount bucketSize_;
 
-	bool isLeaf();
+	// Number of values the binary search tree can grow to at its position in the bucket array.
+	BucketCount bucketCapacity_;
 
-	/**
-	* Only for leaves!
-	* Using it on inner nodes returns the maximum possible integer.
-	*/
-	uint64_t getValue();
+public:
+
+	Key getValue() const;
 
 	/**
-	* Only for inner nodes!
-	* Returns the leaf with the maximum value on the left side.
-	* Does the same as previous(), but should only be used on inner nodes for clarity.
+	* Sets the representant. The trie has to update its level hash tables accordingly.
 	*/
-	TrieNode* getLeftMax();
+	void setValue(Key value);
 
 	/**
-	* Only for inner nodes!
-	* Returns the leaf with the minimum value on the right side.
-	* Does the same as next(), but should only be used on inner nodes for clarity.
+	* Returns the index of the left leaf neighbour, or NONE for the first leaf.
 	*/
-	TrieNode* getRightMin();
+	uint32_t previous() const;
 
 	/**
-	* Only for leaves!
-	* Returns the left leaf neighbour.
-	* Does the same as getLeftMax(), but should only be used on leaves for clarity.
+	* Returns the index of the right leaf neighbour, or NONE for the last leaf.
 	*/
-	TrieNode* previous();
+	uint32_t next() const;
 
 	/**
-	* Only for leaves!
-	* Returns the right leaf neighbour.
-	* Does the same as getRightMin(), but should only be used on leaves for clarity.
+	* Sets the left neighbour leaf.
 	*/
-	TrieNode* next();
+	void setPrevious(uint32_t previous);
 
 	/**
-	* Only for leaves!
 	* Sets the right neighbour leaf.
 	*/
-	void setNext(TrieNode* next);
+	void setNext(uint32_t next);
 
-	/**
-	* Only for leaves!
-	* Returns the binary search tree corresponding to this trie leaf.
-	*/
-	BST* getBinarySearchTree();
+	uint64_t getBucketOffset() const;
+
+	uint64_t getBucketSize() const;
+
+	uint64_t getBucketCapacity() const;
 
 	/**
-	* Constructs an inner node.
+	* Sets the position, size and capacity of the binary search tree in the bucket array.
 	*/
-	TrieNode(TrieNode* leftMax, TrieNode* rightMin);
+	void setBucket(uint64_t offset, uint32_t size, uint32_t capacity);
 
 	/**
 	* Constructs a leaf. 
 	* Next cannot be set here, since the nodes are generated from left to right.
 	*/
-	TrieNode(uint64_t value, TrieNode* previous, BST* tree);
+	TrieNode(Key value, uint32_t previous, uint64_t bucketOffset, uint32_t bucketSize, uint32_t bucketCapacity);
 
 };
\ No newline at end of file
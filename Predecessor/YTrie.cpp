@@ -1,29 +1,33 @@
 #include "YTrie.h"
-#include <cmath>
-#include <bitset>
+#include "../Util/Profile.h"
+#include <algorithm>
 #include <climits>
 
 // For the whole trie: 0 = left, 1 = right
 
+/**
+* The snapshot kind of a trie, so a trie is never loaded with the wrong key width.
+*/
+template <typename Key>
+uint32_t snapshotKind() {
+	return sizeof(Key) == 4 ? SNAPSHOT_KIND_YTRIE_32 : SNAPSHOT_KIND_YTRIE;
+}
+
 /*
 * Calculates the depth needed for the trie.
-* Since the numbers are max 64 bits, we could just assume depth = 64.
+* Since the numbers have at most as many bits as the key type, we could just assume depth = number of key bits.
 * But we can speed up the process when only smaller numbers are present.
 * Eg. with only 32 bit numbers or smaller (even in 64 bit format), we can half the depth of the Trie.
 * The depth is given as the number of bits used to represent the largest number in the input values.
+* It is at least 1, since it is also the size of the groups.
+* Only the largest value is needed, which is the last one of the sorted input.
 */
-uint64_t calcDepth(std::vector <uint64_t> values) {
-	return (uint64_t)std::floor(std::log2(values.back()));
-}
-
-/**
-* 
-*/
-BST* constructBST(uint64_t position, uint64_t groupSize, std::vector <uint64_t> values) {
-	// Isolate the group with the given size for the representative on the given position 
-	std::vector<uint64_t> group(values.begin() + position - (groupSize - 1), values.begin() + position + 1);
-	BST* tree = new BST(group);
-	return tree;
+template <typename Key>
+uint64_t calcDepth(Key largest) {
+	if (largest < 2) {
+		return 1;
+	}
+	return 63 - __builtin_clzll(largest);
 }
 
 /**
@@ -31,12 +35,14 @@ BST* constructBST(uint64_t position, uint64_t groupSize, std::vector <uint64_t>
  * This only works because we start with an exponent that is the highest occurring set bit in all values and gradually go lower.
  * This function also requires the representative vector to not be as long as ULLONG_MAX;
 */
-void splitPointSearch(std::vector<TrieNode*>* representatives, uint64_t *splitpoint, TrieNode** leftMax, TrieNode** rightMin, int64_t exponent, uint64_t leftRange, uint64_t rightRange) {
-	uint64_t split = 1LL << exponent; // 2^exponent is the border to split
+template <typename Key>
+void splitPointSearch(const std::vector<TrieNode<Key>>& representatives, uint64_t *splitpoint, uint32_t* leftMax, uint32_t* rightMin, int64_t exponent, uint64_t leftRange, uint64_t rightRange) {
+	uint64_t split = 1ULL << exponent; // 2^exponent is the border to split
 	uint64_t bestSplit = ULLONG_MAX;
+	uint64_t first = leftRange; // leftRange moves during the search
 	while (leftRange <= rightRange) {
 		uint64_t middle = leftRange + ((rightRange  - leftRange) / 2);
-		uint64_t checkSum = (representatives->at(middle)->getValue() & split) >> exponent; // 1 if bit set, 0 else.
+		uint64_t checkSum = (representatives[middle].getValue() & split) >> exponent; // 1 if bit set, 0 else.
 		if (checkSum == 1) {
 			bestSplit = middle;
 			if (middle == 0) {
@@ -49,157 +55,734 @@ void splitPointSearch(std::vector<TrieNode*>* representatives, uint64_t *splitpo
 		}
 	}
 	if (bestSplit == ULLONG_MAX) {
-		*leftMax = representatives->at(rightRange);
+		*leftMax = (uint32_t)rightRange;
 	}
 	else {
 		*splitpoint = bestSplit;
-		*rightMin = representatives->at(bestSplit);
-		if (bestSplit != leftRange) {
-			*leftMax = representatives->at(bestSplit - 1);
+		*rightMin = (uint32_t)bestSplit;
+		if (bestSplit != first) {
+			*leftMax = (uint32_t)(bestSplit - 1);
 		}
 	}
 }
 
-/*
-* Adds a leaf to the trie representatives with a maximum sized binary search tree.
-* 
-* @param values A full vector of all values for which the trie is built.
-* @param index The index of the representative in the given values.
-* @param representatives A vector of all representatives so far in TrieNode format.
-* @param depth The trie depth.
-*/
-void addRegularTrieLeaf(std::vector<uint64_t> values, uint64_t index, std::vector<TrieNode*>* representatives, uint64_t depth) {
-	int64_t maxIndex = values.size() - 1;
-	if (index == depth - 1) {
-		// First to add has nullptr as previous
-		representatives->push_back(new TrieNode(values[index], nullptr, constructBST(index, depth, values)));
+
+template <typename Key>
+void YTrie<Key>::split(const Key* values, uint64_t size) {
+	// Every group becomes one leaf, so the leaves are allocated exactly once instead of growing.
+	std::vector<TrieNode<Key>> leaves;
+	leaves.reserve((size + depth_ - 1) / depth_);
+	std::vector<Key> buckets(packedBuckets_ ? 0 : size);
+	std::vector<uint64_t> packedWords;
+	if (packedBuckets_) {
+		// The packed size of a group depends on its values, so all groups are measured first.
+		uint64_t words = 0;
+		for (uint64_t first = 0; first < size; first = first + depth_) {
+			uint64_t groupSize = size - first < depth_ ? size - first : depth_;
+			words += PackedBucket<Key>::wordCount(groupSize, PackedBucket<Key>::widthOf(values + first, groupSize));
+		}
+		packedWords.resize(words);
+	}
+	uint64_t offset = 0;
+	for (uint64_t first = 0; first < size; first = first + depth_) {
+		// The last group has less than depth_ values, if the split is imperfect.
+		uint64_t groupSize = size - first < depth_ ? size - first : depth_;
+		Key representative = values[first + groupSize - 1];
+		uint64_t capacity = packedBuckets_ ? PackedBucket<Key>::layout(values + first, groupSize, packedWords.data() + offset) : groupSize;
+		if (!packedBuckets_) {
+			BST<Key>::layout(values + first, groupSize, buckets.data() + offset);
+		}
+		// First to add has NONE as previous, all other representatives have the predecessor as previous.
+		uint32_t previous = leaves.empty() ? TrieNode<Key>::NONE : (uint32_t)(leaves.size() - 1);
+		leaves.push_back(TrieNode<Key>(representative, previous, offset, (uint32_t)groupSize, (uint32_t)capacity));
+		if (previous != TrieNode<Key>::NONE) {
+			leaves[previous].setNext((uint32_t)(leaves.size() - 1));
+		}
+		offset += capacity;
+	}
+	leaves_ = FlatArray<TrieNode<Key>>(std::move(leaves));
+	buckets_ = FlatArray<Key>(std::move(buckets));
+	packedWords_ = FlatArray<uint64_t>(std::move(packedWords));
+}
+
+
+template <typename Key>
+void YTrie<Key>::constructTrie(int64_t exponent, Key prefix, uint64_t leftRange, uint64_t rightRange) {
+	PrefixHashTable<Key>& level = levels_[depth_ - exponent];
+	if (exponent != -1) { // Construct inner node
+		uint64_t splitIndex = rightRange + 1;
+		uint32_t leftMax = TrieNode<Key>::NONE;
+		uint32_t rightMin = TrieNode<Key>::NONE;
+		splitPointSearch(leaves_.edit(), &splitIndex, &leftMax, &rightMin, exponent, leftRange, rightRange);
+		if (leftMax == TrieNode<Key>::NONE && rightMin == TrieNode<Key>::NONE) { // No split was found, all representant belong to the left side of this inner node
+			leftMax = (uint32_t)rightRange;
+		}
+		level.insert(prefix, leftMax, rightMin);
+		if (splitIndex > leftRange) { // Construct left subtree
+			constructTrie(exponent - 1, prefix << 1, leftRange, splitIndex - 1);
+		}
+		if (splitIndex <= rightRange) { // Construct right subtree
+			constructTrie(exponent - 1, (prefix << 1) | 1, splitIndex, rightRange);
+		}
+	}
+	else { // Add the leafs
+		level.insert(prefix, (uint32_t)rightRange, (uint32_t)rightRange);
+	}
+}
+
+
+template <typename Key>
+void YTrie<Key>::build(const Key* values, uint64_t size) {
+	size_ = size;
+	wastedBuckets_ = 0;
+	levels_.clear();
+	mapping_.reset();
+	if (size == 0) {
+		depth_ = 1;
+		minimalValue_ = NOT_FOUND;
+		maximalValue_ = NOT_FOUND;
+		leaves_ = FlatArray<TrieNode<Key>>();
+		buckets_ = FlatArray<Key>();
+		packedWords_ = FlatArray<uint64_t>();
+		firstLeaf_ = TrieNode<Key>::NONE;
+		lastLeaf_ = TrieNode<Key>::NONE;
 	}
 	else {
-		// All other representatives have the predecessor as previous. Also sets the next pointers for the last added leaf.
-		representatives->push_back(new TrieNode(values[index], representatives->back(), constructBST(index, depth, values)));
-		(*representatives)[representatives->size() - 2]->setNext((*representatives)[representatives->size() - 1]);
+		depth_ = calcDepth(values[size - 1]);
+		minimalValue_ = values[0];
+		maximalValue_ = values[size - 1];
+		beginPhase("buckets");
+		split(values, size);
+		endPhase();
+		firstLeaf_ = 0;
+		lastLeaf_ = (uint32_t)(leaves_.size() - 1);
 	}
+	beginPhase("levels");
+	// Level l can hold at most 2^l nodes, but never more than there are representatives.
+	levels_.reserve(depth_ + 2);
+	for (uint64_t level = 0; level <= depth_ + 1; level++) {
+		uint64_t expectedSize = leaves_.size();
+		if (level < 64 && (1ULL << level) < expectedSize) {
+			expectedSize = 1ULL << level;
+		}
+		levels_.push_back(PrefixHashTable<Key>(expectedSize));
+	}
+	if (!leaves_.empty()) {
+		constructTrie(depth_, 0, 0, (leaves_.size() - 1));
+	}
+	endPhase();
 }
 
-/*
-* Adds a leaf to the trie representatives WITHOUT a maximum sized binary search tree. This can only happen, when the split is imperfect.
-* Does not need an index, since it knows it has to be the last representant.
-* 
-* @param values A full vector of all values for which the trie is built.
-* @param representatives A vector of all representatives so far in TrieNode format.
-* @param depth The trie depth.
+
+template <typename Key>
+YTrie<Key>::YTrie(const Key* values, uint64_t size, bool packedBuckets) :
+	packedBuckets_(packedBuckets) {
+	build(values, size);
+}
+
+
+template <typename Key>
+YTrie<Key>::YTrie(const std::vector<Key>& values, bool packedBuckets) :
+	YTrie(values.data(), values.size(), packedBuckets) {
+}
+
+
+template <typename Key>
+Key YTrie<Key>::prefix(Key value, uint64_t level) const {
+	// Level 0 is handled on its own, since shifting a value by all of its bits is undefined.
+	return level == 0 ? 0 : value >> (depth_ + 1 - level);
+}
+
+
+template <typename Key>
+void YTrie<Key>::addRepresentative(uint32_t leaf) {
+	Key value = leaves_[leaf].getValue();
+	uint64_t bits = depth_ + 1;
+	for (uint64_t level = 0; level < bits; level++) {
+		Key key = prefix(value, level);
+		const typename PrefixHashTable<Key>::Slot* node = levels_[level].find(key);
+		uint32_t leftMax = node != nullptr ? node->leftMax : TrieNode<Key>::NONE;
+		uint32_t rightMin = node != nullptr ? node->rightMin : TrieNode<Key>::NONE;
+		if (((value >> (bits - level - 1)) & 1) == 0) { // The leaf lies in the left subtree
+			if (leftMax == TrieNode<Key>::NONE || leaves_[leftMax].getValue() < value) {
+				leftMax = leaf;
+			}
+		}
+		else if (rightMin == TrieNode<Key>::NONE || leaves_[rightMin].getValue() > value) {
+			rightMin = leaf;
+		}
+		levels_[level].insert(key, leftMax, rightMin);
+	}
+	levels_[bits].insert(value, leaf, leaf);
+}
+
+
+template <typename Key>
+void YTrie<Key>::removeRepresentative(uint32_t leaf) {
+	Key value = leaves_[leaf].getValue();
+	uint32_t previous = leaves_[leaf].previous();
+	uint32_t next = leaves_[leaf].next();
+	uint64_t bits = depth_ + 1;
+	levels_[bits].erase(value);
+	for (uint64_t level = 0; level < bits; level++) {
+		Key key = prefix(value, level);
+		const typename PrefixHashTable<Key>::Slot* node = levels_[level].find(key);
+		uint32_t leftMax = node->leftMax;
+		uint32_t rightMin = node->rightMin;
+		// The neighbours are the closest representatives, so they are the new leftMax or rightMin, if they are still in the same subtree.
+		Key child = prefix(value, level + 1);
+		if (leftMax == leaf) {
+			leftMax = previous != TrieNode<Key>::NONE && prefix(leaves_[previous].getValue(), level + 1) == child ? previous : TrieNode<Key>::NONE;
+		}
+		if (rightMin == leaf) {
+			rightMin = next != TrieNode<Key>::NONE && prefix(leaves_[next].getValue(), level + 1) == child ? next : TrieNode<Key>::NONE;
+		}
+		if (leftMax == TrieNode<Key>::NONE && rightMin == TrieNode<Key>::NONE) {
+			levels_[level].erase(key);
+		}
+		else {
+			levels_[level].insert(key, leftMax, rightMin);
+		}
+	}
+}
+
+
+template <typename Key>
+void YTrie<Key>::setRepresentative(uint32_t leaf, Key value) {
+	if (leaves_[leaf].getValue() != value) {
+		removeRepresentative(leaf);
+		leaves_.edit()[leaf].setValue(value);
+		addRepresentative(leaf);
+	}
+}
+
+
+template <typename Key>
+BST<Key> YTrie<Key>::bucketOf(uint32_t leaf) const {
+	const TrieNode<Key>& node = leaves_[leaf];
+	return BST<Key>(buckets_.data() + node.getBucketOffset(), node.getBucketSize());
+}
+
+
+template <typename Key>
+PackedBucket<Key> YTrie<Key>::packedBucketOf(uint32_t leaf) const {
+	return PackedBucket<Key>(packedWords_.data() + leaves_[leaf].getBucketOffset());
+}
+
+
+template <typename Key>
+uint64_t YTrie<Key>::readBucket(uint32_t leaf, Key* out) const {
+	if (packedBuckets_) {
+		PackedBucket<Key> bucket = packedBucketOf(leaf);
+		bucket.getSortedValues(out);
+		return bucket.getSize();
+	}
+	BST<Key> bucket = bucketOf(leaf);
+	bucket.getSortedValues(out);
+	return bucket.getSize();
+}
+
+
+template <typename Key>
+void YTrie<Key>::writeBucket(uint32_t leaf, const Key* sorted, uint64_t count) {
+	TrieNode<Key>& node = leaves_.edit()[leaf];
+	uint64_t offset = node.getBucketOffset();
+	uint64_t capacity = node.getBucketCapacity();
+	// A packed bucket needs as many words as its values take at their width, which changes with the values.
+	uint64_t width = packedBuckets_ ? PackedBucket<Key>::widthOf(sorted, count) : 0;
+	uint64_t needed = packedBuckets_ ? PackedBucket<Key>::wordCount(count, width) : count;
+	uint64_t arraySize = packedBuckets_ ? packedWords_.size() : buckets_.size();
+	if (needed > capacity) {
+		// Leave room for the largest bucket size, so the bucket moves at most once, as long as the width stays the same.
+		wastedBuckets_ += capacity;
+		offset = arraySize;
+		capacity = packedBuckets_ ? PackedBucket<Key>::wordCount(2 * depth_, width) : 2 * depth_;
+		arraySize += capacity;
+	}
+	if (packedBuckets_) {
+		std::vector<uint64_t>& words = packedWords_.edit();
+		words.resize(arraySize);
+		PackedBucket<Key>::layout(sorted, count, words.data() + offset);
+	}
+	else {
+		std::vector<Key>& buckets = buckets_.edit();
+		buckets.resize(arraySize);
+		BST<Key>::layout(sorted, count, buckets.data() + offset);
+	}
+	node.setBucket(offset, (uint32_t)count, (uint32_t)capacity);
+	if (wastedBuckets_ > arraySize / 2) {
+		compactBuckets();
+	}
+}
+
+
+/**
+* Copies the buckets of all leaves together into a new array and points the leaves to their new positions.
+* The capacities stay the same, so the bucket can still grow in place afterwards.
 */
-void addIrregularTrieLeaf(std::vector<uint64_t> values, std::vector<TrieNode*>* representatives, uint64_t depth) {
-	representatives->push_back(new TrieNode(values.back(), representatives->back(), constructBST(values.size() - 1, values.size() % depth, values)));
-	(*representatives)[representatives->size() - 2]->setNext((*representatives)[representatives->size() - 1]);
+template <typename Key, typename T>
+FlatArray<T> compactArray(std::vector<TrieNode<Key>>& leaves, const FlatArray<T>& array, uint64_t wasted) {
+	std::vector<T> compacted;
+	compacted.reserve(array.size() - wasted);
+	for (uint64_t leaf = 0; leaf < leaves.size(); leaf++) {
+		const T* bucket = array.data() + leaves[leaf].getBucketOffset();
+		uint64_t offset = compacted.size();
+		compacted.insert(compacted.end(), bucket, bucket + leaves[leaf].getBucketCapacity());
+		leaves[leaf].setBucket(offset, (uint32_t)leaves[leaf].getBucketSize(), (uint32_t)leaves[leaf].getBucketCapacity());
+	}
+	return FlatArray<T>(std::move(compacted));
 }
 
 
-void YTrie::split(std::vector <uint64_t> values) {
-	for (uint64_t i = depth_ - 1; i < values.size(); i = i + depth_) {
-		// Store the representative and construct the BST for it.
-		addRegularTrieLeaf(values, i, &representatives_, depth_);
+template <typename Key>
+void YTrie<Key>::compactBuckets() {
+	if (packedBuckets_) {
+		packedWords_ = compactArray(leaves_.edit(), packedWords_, wastedBuckets_);
 	}
-	if (values.size() % depth_ != 0) {
-		// One or more(<depth) values at the back don't have a representant yet. Take the last value as one and construct the BST.
-		addIrregularTrieLeaf(values, &representatives_, depth_);
+	else {
+		buckets_ = compactArray(leaves_.edit(), buckets_, wastedBuckets_);
 	}
+	wastedBuckets_ = 0;
 }
 
 
-void YTrie::constructTrie(std::vector<TrieNode*>* representatives, int64_t exponent, std::string bitHistory, uint64_t leftRange, uint64_t rightRange) {
-	if (exponent != -1) { // Construct inner node
-		uint64_t splitIndex = rightRange + 1;
-		TrieNode* leftMax = nullptr;
-		TrieNode* rightMin = nullptr;
-		splitPointSearch(representatives, &splitIndex, &leftMax, &rightMin, exponent, leftRange, rightRange);
-		if (leftMax == nullptr && rightMin == nullptr) { // No split was found, all representant belong to the left side of this inner node
-			leftMax = (*representatives)[rightRange];
-		}
-		TrieNode* node = new TrieNode(leftMax, rightMin);
-		lookup_.insert({ bitHistory, node });
-		if (splitIndex > leftRange) { // Construct left subtree
-			std::string leftMaskHistory = bitHistory;
-			constructTrie(representatives, (exponent - 1), leftMaskHistory.append("0"), leftRange, splitIndex - 1);
+template <typename Key>
+uint32_t YTrie<Key>::removeLeaf(uint32_t leaf, uint32_t keep) {
+	removeRepresentative(leaf);
+	std::vector<TrieNode<Key>>& leaves = leaves_.edit();
+	uint32_t previous = leaves[leaf].previous();
+	uint32_t next = leaves[leaf].next();
+	if (previous != TrieNode<Key>::NONE) {
+		leaves[previous].setNext(next);
+	}
+	else {
+		firstLeaf_ = next;
+	}
+	if (next != TrieNode<Key>::NONE) {
+		leaves[next].setPrevious(previous);
+	}
+	else {
+		lastLeaf_ = previous;
+	}
+	wastedBuckets_ += leaves[leaf].getBucketCapacity();
+	uint32_t last = (uint32_t)(leaves.size() - 1);
+	if (leaf != last) {
+		// Move the last leaf into the free index and update everything pointing to it.
+		leaves[leaf] = leaves[last];
+		const TrieNode<Key>& moved = leaves[leaf];
+		if (moved.previous() != TrieNode<Key>::NONE) {
+			leaves[moved.previous()].setNext(leaf);
 		}
-		if (splitIndex <= rightRange) { // Construct right subtree
-			std::string rightMaskHistory = bitHistory;
-			constructTrie(representatives, exponent - 1, rightMaskHistory.append("1"), splitIndex, rightRange);
+		else {
+			firstLeaf_ = leaf;
 		}
-	}
-	else { // Add the leafs
-		if ((bitHistory.compare(bitHistory.size(), 1, "0")) == 0) { // Choose the correct leftRange and rightRange (according to last bit) to not go out of boundary
-			lookup_.insert({ bitHistory, (*representatives)[leftRange] });
+		if (moved.next() != TrieNode<Key>::NONE) {
+			leaves[moved.next()].setPrevious(leaf);
 		}
 		else {
-			lookup_.insert({ bitHistory, (*representatives)[rightRange] });
+			lastLeaf_ = leaf;
+		}
+		for (uint64_t level = 0; level <= depth_ + 1; level++) {
+			Key key = prefix(moved.getValue(), level);
+			const typename PrefixHashTable<Key>::Slot* node = levels_[level].find(key);
+			if (node->leftMax == last || node->rightMin == last) {
+				levels_[level].insert(key, node->leftMax == last ? leaf : node->leftMax, node->rightMin == last ? leaf : node->rightMin);
+			}
+		}
+		if (keep == last) {
+			keep = leaf;
 		}
 	}
+	leaves.pop_back();
+	return keep;
 }
 
 
-YTrie::YTrie(std::vector<uint64_t> values) :
-	depth_(calcDepth(values)), 
-	minimalValue_(values[0]) {
-	split(values);
-	std::vector<uint64_t> representativeValues;
-	constructTrie(&representatives_, depth_, "", 0, (representatives_.size() - 1));
+template <typename Key>
+std::vector<Key> YTrie<Key>::collectValues() const {
+	std::vector<Key> values(size_);
+	uint64_t count = 0;
+	for (uint32_t leaf = firstLeaf_; leaf != TrieNode<Key>::NONE; leaf = leaves_[leaf].next()) {
+		count += readBucket(leaf, values.data() + count);
+	}
+	return values;
 }
 
 
-uint64_t YTrie::getPredecessor(uint64_t limit) {
-	if (limit < minimalValue_) {
-		return ULLONG_MAX;
+template <typename Key>
+bool YTrie<Key>::insert(Key value) {
+	if (size_ == 0 || (depth_ + 1 < keyBits_ && (value >> (depth_ + 1)) != 0)) {
+		// The trie is empty, or the value is too large for the prefixes of this depth. It is larger than all values then, so the order stays sorted.
+		std::vector<Key> values = collectValues();
+		values.push_back(value);
+		build(values.data(), values.size());
+		return true;
+	}
+	uint32_t leaf = findBucket(value);
+	Key sorted[mergeBufferSize_];
+	uint64_t count = readBucket(leaf, sorted);
+	uint64_t position = std::lower_bound(sorted, sorted + count, value) - sorted;
+	if (position < count && sorted[position] == value) {
+		return false;
+	}
+	std::copy_backward(sorted + position, sorted + count, sorted + count + 1);
+	sorted[position] = value;
+	count++;
+	size_++;
+	// Only the last leaf can get a new maximum, since every other leaf only receives values up to its representative.
+	setRepresentative(leaf, sorted[count - 1]);
+	if (count > 2 * depth_) {
+		// Split off the lower half into a new leaf left of this one.
+		uint64_t lowerCount = count / 2;
+		std::vector<TrieNode<Key>>& leaves = leaves_.edit();
+		uint32_t lower = (uint32_t)leaves.size();
+		uint32_t previous = leaves[leaf].previous();
+		leaves.push_back(TrieNode<Key>(sorted[lowerCount - 1], previous, 0, 0, 0));
+		leaves[lower].setNext(leaf);
+		leaves[leaf].setPrevious(lower);
+		if (previous != TrieNode<Key>::NONE) {
+			leaves[previous].setNext(lower);
+		}
+		else {
+			firstLeaf_ = lower;
+		}
+		writeBucket(lower, sorted, lowerCount);
+		writeBucket(leaf, sorted + lowerCount, count - lowerCount);
+		addRepresentative(lower);
+	}
+	else {
+		writeBucket(leaf, sorted, count);
+	}
+	minimalValue_ = std::min(minimalValue_, value);
+	maximalValue_ = leaves_[lastLeaf_].getValue();
+	return true;
+}
+
+
+template <typename Key>
+bool YTrie<Key>::erase(Key value) {
+	if (size_ == 0 || value < minimalValue_ || value > maximalValue_) {
+		return false;
+	}
+	uint32_t leaf = findBucket(value);
+	Key sorted[mergeBufferSize_];
+	uint64_t count = readBucket(leaf, sorted);
+	uint64_t position = std::lower_bound(sorted, sorted + count, value) - sorted;
+	if (position == count || sorted[position] != value) {
+		return false;
 	}
+	std::copy(sorted + position + 1, sorted + count, sorted + position);
+	count--;
+	size_--;
+	if (size_ == 0) {
+		build(nullptr, 0);
+		return true;
+	}
+	uint32_t next = leaves_[leaf].next();
+	uint32_t neighbour = next != TrieNode<Key>::NONE ? next : leaves_[leaf].previous();
+	if ((count < depth_ / 2 || count == 0) && neighbour != TrieNode<Key>::NONE) { // count == 0 always has a neighbour, since the trie is not empty
+		// Merge with a neighbour. Both are collected in order in merged, the left one first.
+		uint32_t left = neighbour == next ? leaf : neighbour;
+		uint32_t right = neighbour == next ? next : leaf;
+		Key merged[mergeBufferSize_];
+		uint64_t total;
+		if (left == leaf) {
+			std::copy(sorted, sorted + count, merged);
+			total = count + readBucket(right, merged + count);
+		}
+		else {
+			total = readBucket(left, merged);
+			std::copy(sorted, sorted + count, merged + total);
+			total += count;
+		}
+		if (total > 2 * depth_) {
+			// Too many for one bucket, so distribute them evenly. The left representative never passes the old right one.
+			uint64_t half = total / 2;
+			setRepresentative(left, merged[half - 1]);
+			writeBucket(left, merged, half);
+			setRepresentative(right, merged[total - 1]);
+			writeBucket(right, merged + half, total - half);
+		}
+		else {
+			right = removeLeaf(left, right);
+			setRepresentative(right, merged[total - 1]);
+			writeBucket(right, merged, total);
+		}
+	}
+	else {
+		setRepresentative(leaf, sorted[count - 1]);
+		writeBucket(leaf, sorted, count);
+	}
+	if (value == minimalValue_) {
+		minimalValue_ = packedBuckets_ ? packedBucketOf(firstLeaf_).getMinimum() : bucketOf(firstLeaf_).getMinimum();
+	}
+	maximalValue_ = leaves_[lastLeaf_].getValue();
+	return true;
+}
+
+
+template <typename Key>
+uint64_t YTrie<Key>::getSize() const {
+	return size_;
+}
+
+
+template <typename Key>
+uint32_t YTrie<Key>::findLeaf(Key limit) const {
+	// Binary search for the longest prefix of limit present in the trie. The empty prefix (root) is always present.
+	uint64_t bits = depth_ + 1; // Number of bits of the representants
 	uint64_t lowRange = 0;
-	uint64_t highRange = depth_ + 1;
-	std::string fullBitString = std::bitset<64>(limit).to_string().substr(64-(depth_+1)); // Input bit-string with same length as representants
-	TrieNode* bestMatchingNode = lookup_[""];
-	while (lowRange <= highRange) {
-		uint64_t middle = (uint64_t) round((lowRange + highRange) / 2);
-		std::string partBitString = fullBitString.substr(0, middle);
-		if (lookup_.count(partBitString) != 0) { // Matched part bit string. Remember node and search lower in trie 
-			bestMatchingNode = lookup_[partBitString];
-			if (lowRange == middle) {
-				lowRange++; // When stuck, move the lower range one higher
-			}
-			else {
-				lowRange = middle;
-			}
+	uint64_t highRange = bits;
+	const typename PrefixHashTable<Key>::Slot* bestMatchingNode = levels_[0].find(0);
+	while (lowRange < highRange) {
+		uint64_t middle = lowRange + (highRange - lowRange + 1) / 2;
+		const typename PrefixHashTable<Key>::Slot* node = levels_[middle].find(limit >> (bits - middle));
+		if (node != nullptr) { // Matched prefix. Remember node and search lower in trie
+			bestMatchingNode = node;
+			lowRange = middle;
 		}
 		else { // Search higher in trie
-			if (highRange == middle) {
-				highRange--; // When stuck, move the higher range one lower
-			}
-			else {
-				highRange = middle;
-			}
+			highRange = middle - 1;
 		}
 	}
-	if (bestMatchingNode->isLeaf()) {
-		return bestMatchingNode->getValue();
+	if (lowRange == bits) { // Leaf level
+		return bestMatchingNode->leftMax;
 	}
-	else {
-		// Our binary search should have gotten to the best possible node for us. This means the bestMatchingNode only has one right, or one left child.
-		if (bestMatchingNode->getLeftMax() != nullptr) {
-			if (bestMatchingNode->getLeftMax()->next() != nullptr) {
-				return bestMatchingNode->getLeftMax()->next()->getBinarySearchTree()->getPredecessor(bestMatchingNode->getLeftMax()->getValue(), limit);
-			}
-			else {
-				return bestMatchingNode->getLeftMax()->getValue();
-			}
+	// Our binary search should have gotten to the best possible node for us. This means the bestMatchingNode only has one right, or one left child.
+	if (bestMatchingNode->leftMax != TrieNode<Key>::NONE) {
+		// limit is larger than everything in the left subtree, so its leaf is the next one. There always is one, since limit < maximalValue_.
+		return leaves_[bestMatchingNode->leftMax].next();
+	}
+	// limit is smaller than everything in the right subtree, so it belongs to the leftmost leaf of it.
+	return bestMatchingNode->rightMin;
+}
+
+
+template <typename Key>
+uint32_t YTrie<Key>::findBucket(Key limit) const {
+	if (limit <= minimalValue_) {
+		return firstLeaf_;
+	}
+	if (limit >= maximalValue_) {
+		return lastLeaf_;
+	}
+	return findLeaf(limit);
+}
+
+
+template <typename Key>
+Key YTrie<Key>::searchLeaf(uint32_t leaf, Key limit) const {
+	const TrieNode<Key>& node = leaves_[leaf];
+	// 0 is ok for the first leaf if we checked for input bound before
+	Key maxSmallerTree = node.previous() != TrieNode<Key>::NONE ? leaves_[node.previous()].getValue() : 0;
+	if (packedBuckets_) {
+		return packedBucketOf(leaf).getPredecessor(maxSmallerTree, limit);
+	}
+	return bucketOf(leaf).getPredecessor(maxSmallerTree, limit);
+}
+
+
+template <typename Key>
+void YTrie<Key>::prefetch(Key limit) const {
+	// Only the first probe of the binary search on the levels is known in advance.
+	uint64_t bits = depth_ + 1;
+	uint64_t middle = (bits + 1) / 2;
+	levels_[middle].prefetch(limit >> (bits - middle));
+}
+
+
+template <typename Key>
+Key YTrie<Key>::getPredecessor(Key limit) const {
+	if (limit < minimalValue_) {
+		return NOT_FOUND;
+	}
+	if (limit >= maximalValue_) {
+		return maximalValue_;
+	}
+	return searchLeaf(findLeaf(limit), limit);
+}
+
+
+template <typename Key>
+void YTrie<Key>::getPredecessors(const uint64_t* queries, size_t n, uint64_t* out) const {
+	uint32_t finger = TrieNode<Key>::NONE;
+	for (size_t i = 0; i < n; i++) {
+		if (i + prefetchDistance_ < n) {
+			uint64_t upcoming = queries[i + prefetchDistance_];
+			prefetch(upcoming > NOT_FOUND ? NOT_FOUND : (Key)upcoming);
 		}
-		else if (bestMatchingNode->getRightMin() != nullptr) {
-			if (bestMatchingNode->getRightMin()->previous() != nullptr) {
-				return bestMatchingNode->getRightMin()->getBinarySearchTree()->getPredecessor(bestMatchingNode->getRightMin()->previous()->getValue(), limit);
+		Key limit = queries[i] > NOT_FOUND ? NOT_FOUND : (Key)queries[i];
+		if (limit < minimalValue_) {
+			out[i] = ULLONG_MAX;
+			continue;
+		}
+		if (limit >= maximalValue_) {
+			// An empty trie has NOT_FOUND as maximum, which still has to become ULLONG_MAX.
+			out[i] = size_ == 0 ? ULLONG_MAX : maximalValue_;
+			continue;
+		}
+		// The leaf of limit is the one with previous()->getValue() < limit <= getValue().
+		// Check whether that is the leaf of the last query or one of its neighbours, before searching the levels again.
+		uint32_t leaf = TrieNode<Key>::NONE;
+		if (finger != TrieNode<Key>::NONE) {
+			const TrieNode<Key>& node = leaves_[finger];
+			if (limit > node.getValue()) {
+				uint32_t next = node.next(); // Not NONE, because limit < maximalValue_.
+				if (limit <= leaves_[next].getValue()) {
+					leaf = next;
+				}
+			}
+			else if (node.previous() == TrieNode<Key>::NONE || limit > leaves_[node.previous()].getValue()) {
+				leaf = finger;
 			}
 			else {
-				return bestMatchingNode->getRightMin()->getBinarySearchTree()->getPredecessor(0, limit); // 0 is ok if we checked for input bound before
+				uint32_t previous = node.previous();
+				if (leaves_[previous].previous() == TrieNode<Key>::NONE || limit > leaves_[leaves_[previous].previous()].getValue()) {
+					leaf = previous;
+				}
 			}
 		}
-		else {
-			// Something went wrong
-			return ULLONG_MAX;
+		if (leaf == TrieNode<Key>::NONE) {
+			leaf = findLeaf(limit);
 		}
+		out[i] = searchLeaf(leaf, limit);
+		finger = leaf;
+	}
+}
+
+
+template <typename Key>
+Key YTrie<Key>::getSuccessor(Key limit) const {
+	if (size_ == 0 || limit > maximalValue_) {
+		return NOT_FOUND;
+	}
+	// The representative of the bucket is >= limit, so the successor is always in this bucket.
+	uint32_t leaf = findBucket(limit);
+	if (packedBuckets_) {
+		PackedBucket<Key> bucket = packedBucketOf(leaf);
+		return bucket.getValue(bucket.findSuccessorNode(limit));
+	}
+	BST<Key> bucket = bucketOf(leaf);
+	return bucket.getValue(bucket.findSuccessorNode(limit));
+}
+
+
+template <typename Key>
+typename YTrie<Key>::RangeIterator YTrie<Key>::getRange(Key min, Key max) const {
+	if (size_ == 0 || min > max || min > maximalValue_) {
+		return RangeIterator(this, TrieNode<Key>::NONE, 0, max);
+	}
+	uint32_t leaf = findBucket(min);
+	return RangeIterator(this, leaf, packedBuckets_ ? packedBucketOf(leaf).findSuccessorNode(min) : bucketOf(leaf).findSuccessorNode(min), max);
+}
+
+
+template <typename Key>
+uint64_t YTrie<Key>::countRange(Key min, Key max) const {
+	if (size_ == 0 || min > max || min > maximalValue_ || max < minimalValue_) {
+		return 0;
+	}
+	uint32_t first = findBucket(min);
+	uint32_t last = findBucket(max);
+	// Values below min in the first bucket are subtracted, values above max in the last bucket are never counted.
+	uint64_t below = min == 0 ? 0 : packedBuckets_ ? packedBucketOf(first).countAtMost(min - 1) : bucketOf(first).countAtMost(min - 1);
+	uint64_t count = packedBuckets_ ? packedBucketOf(last).countAtMost(max) : bucketOf(last).countAtMost(max);
+	for (uint32_t leaf = first; leaf != last; leaf = leaves_[leaf].next()) {
+		count += leaves_[leaf].getBucketSize();
+	}
+	return count - below;
+}
+
+
+template <typename Key>
+bool YTrie<Key>::RangeIterator::next(Key* value) {
+	if (leaf_ == TrieNode<Key>::NONE) {
+		return false;
+	}
+	if (trie_->packedBuckets_) {
+		PackedBucket<Key> bucket = trie_->packedBucketOf(leaf_);
+		*value = bucket.getValue(node_);
+		node_ = bucket.nextNode(node_);
+	}
+	else {
+		BST<Key> bucket = trie_->bucketOf(leaf_);
+		*value = bucket.getValue(node_);
+		node_ = bucket.nextNode(node_);
+	}
+	if (*value > max_) {
+		leaf_ = TrieNode<Key>::NONE;
+		return false;
+	}
+	if (node_ == 0) {
+		leaf_ = trie_->leaves_[leaf_].next();
+		// Every bucket holds at least one value, so its first node is always 1 for packed buckets.
+		node_ = leaf_ == TrieNode<Key>::NONE ? 0 : trie_->packedBuckets_ ? 1 : trie_->bucketOf(leaf_).firstNode();
+	}
+	return true;
+}
+
+
+template <typename Key>
+YTrie<Key>::RangeIterator::RangeIterator(const YTrie* trie, uint32_t leaf, uint64_t node, Key max) :
+	trie_(trie),
+	leaf_(leaf),
+	node_(node),
+	max_(max) {}
+
+
+template <typename Key>
+bool YTrie<Key>::save(std::string path) const {
+	SnapshotWriter writer(path, snapshotKind<Key>());
+	writer.writeValue(depth_);
+	writer.writeValue(size_);
+	writer.writeValue(minimalValue_);
+	writer.writeValue(maximalValue_);
+	writer.writeValue(firstLeaf_);
+	writer.writeValue(lastLeaf_);
+	writer.writeValue(wastedBuckets_);
+	writer.writeValue(packedBuckets_);
+	writer.writeArray(leaves_);
+	writer.writeArray(buckets_);
+	writer.writeArray(packedWords_);
+	for (uint64_t level = 0; level < levels_.size(); level++) {
+		levels_[level].save(&writer);
 	}
-}
\ No newline at end of file
+	return writer.finish();
+}
+
+
+template <typename Key>
+YTrie<Key>* YTrie<Key>::load(std::string path) {
+	SnapshotReader reader(path, snapshotKind<Key>());
+	YTrie* trie = new YTrie();
+	trie->depth_ = reader.readValue();
+	trie->size_ = reader.readValue();
+	trie->minimalValue_ = reader.readValue();
+	trie->maximalValue_ = reader.readValue();
+	trie->firstLeaf_ = (uint32_t)reader.readValue();
+	trie->lastLeaf_ = (uint32_t)reader.readValue();
+	trie->wastedBuckets_ = reader.readValue();
+	uint64_t packedBuckets = reader.readValue();
+	trie->packedBuckets_ = packedBuckets == 1;
+	trie->leaves_ = reader.readArray<TrieNode<Key>>();
+	trie->buckets_ = reader.readArray<Key>();
+	trie->packedWords_ = reader.readArray<uint64_t>();
+	bool validLeaves = trie->leaves_.empty() ? trie->size_ == 0 : trie->size_ > 0 && trie->firstLeaf_ < trie->leaves_.size() && trie->lastLeaf_ < trie->leaves_.size();
+	uint64_t bucketArraySize = trie->packedBuckets_ ? trie->packedWords_.size() : trie->buckets_.size();
+	if (trie->depth_ == 0 || trie->depth_ >= keyBits_ || !validLeaves || packedBuckets > 1 || trie->wastedBuckets_ > bucketArraySize) {
+		reader.invalidate();
+	}
+	for (uint64_t level = 0; level <= trie->depth_ + 1 && reader.isValid(); level++) {
+		trie->levels_.push_back(PrefixHashTable<Key>::load(&reader));
+	}
+	if (!reader.isValid()) {
+		delete trie;
+		return nullptr;
+	}
+	trie->mapping_ = reader.getMapping();
+	return trie;
+}
+
+
+template class YTrie<uint32_t>;
+template class YTrie<uint64_t>;
\ No newline at end of file
@@ -1,70 +1,333 @@
 #pragma once
 #include <cstdint>
-#include <vector>
-#include <unordered_map>
+#include <cstddef>
+#include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 #include "TrieNode.h"
+#include "PrefixHashTable.h"
+#include "BST.h"
+#include "PackedBucket.h"
+#include "../Util/FlatArray.h"
+#include "../IO/MappedFile.h"
 
 /**
 * Implementation of a Y-Trie.
 * The trie itself is just built on representatives of blocks.
-* The inner trie nodes have pointers to answer predecessor queries, while the trie leaves have binary searching trees over all values.
-* To quickly traverse the trie, a HashMap is used.
+* The inner trie nodes know leftMax and rightMin leaves to answer predecessor queries, while the trie leaves have binary searching trees over all values.
+* To quickly traverse the trie, every level has its own hash table, which is keyed by the integer prefix of the nodes on that level.
+* All parts of the trie are flat arrays without any pointers, so a trie can be saved to a snapshot and used directly from a memory mapping of it.
+* Values can be inserted and erased. Buckets hold between depth_ / 2 and 2 * depth_ values, full buckets are split and small ones merged with a neighbour.
+* Only splits and merges add or remove representatives, which touches O(depth_) level entries, so the levels cost amortized O(1) per update.
+* Key is the unsigned integer type of the values, uint32_t or uint64_t. With 32 bit keys, values and prefixes take half the memory and leaves a quarter less.
+* Instead of binary search trees, the buckets can also be packed deltas from their minimum (see PackedBucket), which takes a fraction of the memory for dense keys.
 */
+template <typename Key>
 class YTrie {
 
+public:
+	// Answer of queries without a result. A trie containing this value can't tell it apart from a missing answer.
+	static const Key NOT_FOUND = std::numeric_limits<Key>::max();
+
+	/**
+	* Streams the values of a range in ascending order, see getRange().
+	* It walks the linked list of leaves and the binary search trees in order, so it never searches the trie again.
+	* Any insert or erase on the trie invalidates the iterator.
+	*/
+	class RangeIterator {
+
+	private:
+		const YTrie* trie_;
+
+		// The leaf of the next value, or TrieNode<Key>::NONE once the iteration is done.
+		uint32_t leaf_;
+
+		// The node of the next value in the binary search tree of leaf_.
+		uint64_t node_;
+
+		// Largest value of the range.
+		Key max_;
+
+	public:
+		/**
+		* Writes the next value of the range to value.
+		*
+		* @return false, if there are no more values in the range. value is undefined then.
+		*/
+		bool next(Key* value);
+
+		RangeIterator(const YTrie* trie, uint32_t leaf, uint64_t node, Key max);
+	};
+
 private:
+	// Number of bits of a key. The depth of the trie is always smaller.
+	static const uint64_t keyBits_ = 8 * sizeof(Key);
+
+	// Enough room for the values of two buckets during a merge, since a bucket never holds more than 2 * (keyBits_ - 1) values.
+	static const uint64_t mergeBufferSize_ = 4 * keyBits_;
+
 	// Depth of the trie.
 	uint64_t depth_;
 
-	// Vector of corresponding representants for all provided values.
-	std::vector<TrieNode*> representatives_ = *(new std::vector<TrieNode*>);
+	// Number of values in the trie.
+	uint64_t size_;
+
+	// All leaves (representatives). Built tries store them from left to right, after updates only the linked list of the leaves is ordered.
+	FlatArray<TrieNode<Key>> leaves_;
+
+	// Indices of the leftmost and the rightmost leaf, or TrieNode<Key>::NONE for an empty trie.
+	uint32_t firstLeaf_;
+	uint32_t lastLeaf_;
+
+	// The binary search trees of all leaves. Built tries store them one after another in leaf order.
+	FlatArray<Key> buckets_;
+
+	// Whether the buckets are PackedBuckets in packedWords_ instead of binary search trees in buckets_. Bucket offsets and capacities of the leaves count words then.
+	bool packedBuckets_ = false;
+
+	// The packed buckets of all leaves, if packedBuckets_ is set. Built tries store them one after another in leaf order.
+	FlatArray<uint64_t> packedWords_;
+
+	// Number of values in buckets_, or words in packedWords_, that belong to no leaf anymore, because a bucket moved or its leaf was merged away.
+	uint64_t wastedBuckets_ = 0;
 
-	// HashMap for performing a binary search on trie levels.
-	std::unordered_map<std::string, TrieNode*> lookup_ = *(new std::unordered_map<std::string, TrieNode*>);
+	// One hash table per trie level for performing a binary search on trie levels.
+	// Level l holds all nodes whose prefix has length l, so levels_[0] only contains the root and levels_[depth_ + 1] the leaves.
+	std::vector<PrefixHashTable<Key>> levels_;
 
 	// Minimal value in this trie. Used for lower boundary detection.
-	uint64_t minimalValue_;
+	// An empty trie uses NOT_FOUND for both, so every query returns NOT_FOUND without an extra check.
+	Key minimalValue_;
+
+	// Maximal value in this trie. Every query above it is answered directly and prefixes never have more than depth_ + 1 bits.
+	Key maximalValue_;
+
+	// The snapshot the arrays point into, if the trie was loaded. Empty for built tries.
+	std::shared_ptr<MappedFile> mapping_;
+
+	// How many queries ahead getPredecessors() prefetches the hash table slots.
+	static const size_t prefetchDistance_ = 8;
+
+	/**
+	* Sets up the trie for the given sorted values, replacing all previous content. The values may be empty.
+	* The values are only read, the trie keeps its own copy in the buckets.
+	*/
+	void build(const Key* values, uint64_t size);
 
 	/**
-	* Splits the given values into their representatives and creates TrieNodes for them.
-	* They are then linked to obtain the "leaf level" for our final trie.
+	* Splits the given values into groups of depth_ values and creates a leaf for the largest value (the representative) of each group.
+	* The groups are stored as binary search trees in the buckets_ array, or packed in the packedWords_ array, and the leaves are linked to obtain the "leaf level" for our final trie.
 	*/
-	void split(std::vector <uint64_t> values);
+	void split(const Key* values, uint64_t size);
 
 	/**
-	* Constructs the trie by creating all inner trie nodes and putting them into the lookup_ HashMap for later use.
+	* Constructs the trie by creating all inner trie nodes and putting them into the hash table of their level for later use.
 	* This is achieved by checking for a 0, or a 1 at a specific bit position.
 	* If we subtract 2^position from all numbers that have a 1 on that position every time we do it, this task changes.
 	* We can now check for greater equal 2^position and split on the first point, where this condition is met.
 	* All nodes representatives smaller than that split, have a 0 on this position and all others a 1.
 	* leftMax is the value left of the split point and rightMin the split point itself.
-	* We track the history by adding a "0" or a "1" to the bit history string and add the inner nodes in our HashMap.
-	* In the end, we also add the representatives themselves to the HashMap in order to allow direct hits on leaves.
+	* We track the history by appending a 0 or a 1 bit to the prefix and add the inner nodes to the hash table of level depth_ - exponent.
+	* In the end, we also add the representatives themselves to the last level in order to allow direct hits on leaves.
 	* 
-	* @param representatives A pointer to the TrieNode vector containing all the linked leaves.
-	* @param representativeValues A vector containing only the values of the representatives. This is needed, since we subtract from values and need to store the remainder.
 	* @param exponent The position on which we check for a 0 or 1. Starts at depth of trie.
-	* @param bitHistory The history of 0 and 1 edges to reach this inner node we are constructing. Starts with empty string.
+	* @param prefix The history of 0 and 1 edges to reach this inner node we are constructing, read as integer. Starts with 0 (empty prefix).
 	* @param leftRange The left border to check for splitting points. Starts at 0.
 	* @param rightRange The right border to check for splitting points. Starts at representatives length.
 	*/
-	void constructTrie(std::vector<TrieNode*>* representatives, int64_t exponent, std::string bitHistory, uint64_t leftRange, uint64_t rightRange);
+	void constructTrie(int64_t exponent, Key prefix, uint64_t leftRange, uint64_t rightRange);
+
+	/**
+	* Returns the prefix of value on the given level, which is the key of its node in the hash table of that level.
+	*/
+	Key prefix(Key value, uint64_t level) const;
+
+	/**
+	* Adds the nodes for the representative of the given leaf to all levels, or updates the leftMax and rightMin leaves of existing ones.
+	* The leaf already has to be linked with its neighbours.
+	*/
+	void addRepresentative(uint32_t leaf);
+
+	/**
+	* Removes the representative of the given leaf from all levels.
+	* Where the leaf was leftMax or rightMin, its neighbour takes over, if it lies in the same subtree, else that side becomes empty.
+	* Nodes without any leaf below them are erased. The leaf still has to be linked with its neighbours.
+	*/
+	void removeRepresentative(uint32_t leaf);
+
+	/**
+	* Changes the representative of the given leaf. The new value has to lie between the representatives of its neighbours.
+	*/
+	void setRepresentative(uint32_t leaf, Key value);
+
+	/**
+	* Returns a view on the binary search tree of the given leaf.
+	*/
+	BST<Key> bucketOf(uint32_t leaf) const;
+
+	/**
+	* Returns a view on the packed bucket of the given leaf. Only valid if packedBuckets_ is set.
+	*/
+	PackedBucket<Key> packedBucketOf(uint32_t leaf) const;
+
+	/**
+	* Writes the values of the given leaf to out in sorted order and returns their number.
+	*/
+	uint64_t readBucket(uint32_t leaf, Key* out) const;
+
+	/**
+	* Replaces the values of the given leaf by count sorted values.
+	* If they do not fit at the current position, the bucket moves to the end of the bucket array, with room for 2 * depth_ values (packed with the width of the new values).
+	* Once more than half of the bucket array is wasted this way, all buckets are compacted.
+	*/
+	void writeBucket(uint32_t leaf, const Key* sorted, uint64_t count);
+
+	/**
+	* Moves all buckets together, dropping the wasted space between them.
+	*/
+	void compactBuckets();
+
+	/**
+	* Removes the given leaf from the levels and the linked list.
+	* The last leaf of the leaf array moves into the free index, so the returned value is the index of keep afterwards.
+	*/
+	uint32_t removeLeaf(uint32_t leaf, uint32_t keep);
+
+	/**
+	* Returns all values of the trie in sorted order.
+	*/
+	std::vector<Key> collectValues() const;
+
+	/**
+	* Finds the index of the leaf whose binary search tree contains the predecessor of limit.
+	* This is the leaf with previous()->getValue() < limit <= getValue().
+	* This is done by a binary search on the trie levels, looking up the prefix limit >> (depth_ + 1 - level) in the hash table of each probed level.
+	* This way the best fitting node is found without any allocation.
+	* Follow the leftMax, or rightMin and previous pointer to get the best fitting leave.
+	* Requires minimalValue_ <= limit < maximalValue_.
+	*/
+	uint32_t findLeaf(Key limit) const;
+
+	/**
+	* Returns the leaf whose binary search tree limit belongs to, like findLeaf(), but for every limit.
+	* Limits up to minimalValue_ belong to the first leaf, limits from maximalValue_ on to the last one. The trie must not be empty.
+	*/
+	uint32_t findBucket(Key limit) const;
+
+	/**
+	* Searches the predecessor of limit in the binary search tree of the given leaf.
+	* The representant of the previous leaf is used as fallback, in case all values of this leaf are larger.
+	*/
+	Key searchLeaf(uint32_t leaf, Key limit) const;
+
+	/**
+	* Prefetches the hash table slot of the first level probe for limit, so a later query for it does not wait on memory.
+	*/
+	void prefetch(Key limit) const;
+
+	YTrie() {}
 
 public:
 	/**
-	* Constructs and prepares the Y-Trie initialized with the given values.
+	* Constructs and prepares the Y-Trie initialized with the given sorted values. The values may be empty.
+	* The values are only read during construction, so the caller's buffer is never copied.
+	* With packedBuckets, the buckets are stored as PackedBuckets instead of binary search trees.
+	*/
+	YTrie(const Key* values, uint64_t size, bool packedBuckets = false);
+
+	/**
+	* Constructs the Y-Trie from the sorted values of the vector, see above.
 	*/
-	YTrie(std::vector<uint64_t> values);
+	YTrie(const std::vector<Key>& values, bool packedBuckets = false);
 
 	/**
 	* Performs the predecessor query.
-	* This is done by transforming the input into a bitset and the bitset into a string.
-	* We can then perform a binary search on the lookup_ HashMap to find the best fitting node.
-	* Follow the leftMax, or rightMin and previous pointer to get the best fitting leave.
+	* The query only reads the trie, so it can be called from multiple threads at the same time.
+	* The leaf is found by a binary search on the trie levels (see findLeaf).
 	* Trie leaves have a binary search tree, which can then be used to search for the predecessors in all values (not just representants).
 	* 
 	* @param limit The number we want to find the predeccesor of.
+	* @return The predecessor, or NOT_FOUND if all values are larger than limit.
+	*/
+	Key getPredecessor(Key limit) const;
+
+	/**
+	* Inserts the value into its bucket and splits the bucket, if it gets larger than 2 * depth_.
+	* A value needing more than depth_ + 1 bits rebuilds the trie with a larger depth. This happens at most once per key bit.
+	* Inserting and erasing must not happen at the same time as any other call on the trie.
+	*
+	* @param value The value to insert.
+	* @return false, if the value was already present.
+	*/
+	bool insert(Key value);
+
+	/**
+	* Erases the value from its bucket and merges the bucket with a neighbour, if it gets smaller than depth_ / 2.
+	* If both buckets together are too large, their values are distributed evenly instead.
+	*
+	* @param value The value to erase.
+	* @return false, if the value was not present.
+	*/
+	bool erase(Key value);
+
+	/**
+	* Returns the number of values in the trie.
+	*/
+	uint64_t getSize() const;
+
+	/**
+	* Performs the predecessor query for all n queries and writes the answers into out.
+	* For sorted, or almost sorted queries, the leaf of a query is often the leaf of the last query or one of its neighbours.
+	* These leaves are checked first (finger search) by walking the linked list of leaves, before the trie levels are searched again.
+	* The hash table slots for upcoming queries are prefetched, so their memory latency overlaps with the current query.
+	* Queries and answers are 64 bit for every key width, so parsed input can be passed directly.
+	* Queries above the largest key are answered like the largest key, missing predecessors are ULLONG_MAX.
+	*
+	* @param queries The numbers we want to find the predecessors of.
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	*/
+	void getPredecessors(const uint64_t* queries, size_t n, uint64_t* out) const;
+
+	/**
+	* Performs the successor query, which finds the smallest value >= limit.
+	* Like getPredecessor(), it can be called from multiple threads at the same time.
+	*
+	* @param limit The number we want to find the successor of.
+	* @return The successor, or NOT_FOUND if all values are smaller than limit.
+	*/
+	Key getSuccessor(Key limit) const;
+
+	/**
+	* Returns an iterator over all values in [min, max] in ascending order.
+	* Finding the first value takes one search in O(log log U), every further value amortized O(1).
+	*/
+	RangeIterator getRange(Key min, Key max) const;
+
+	/**
+	* Counts the values in [min, max]. The rank of a value x is countRange(0, x).
+	* Only the two border buckets are scanned, all buckets between are counted by their size while walking the list of leaves.
+	* So this takes O(log log U + log U + k / log U) for k values in the range.
+	*/
+	uint64_t countRange(Key min, Key max) const;
+
+	/**
+	* Saves the trie to a snapshot file (see IO/Snapshot.h). Each key width has its own snapshot kind.
+	* The layout is: depth, size, minimal and maximal value, first and last leaf, wasted bucket space, whether the buckets are packed, leaves, buckets, packed buckets, level hash tables.
+	*
+	* @param path The snapshot file to write.
+	* @return false, if the snapshot could not be written.
+	*/
+	bool save(std::string path) const;
+
+	/**
+	* Loads a trie from a snapshot file written by save().
+	* The file is memory mapped and all arrays are used in place, so the trie answers queries right away and pages are only read when touched.
+	* The first insert or erase copies the arrays it changes into memory.
+	*
+	* @param path The snapshot file to read.
+	* @return The loaded trie, or nullptr if the file is no valid trie snapshot.
 	*/
-	uint64_t getPredecessor(uint64_t limit);
+	static YTrie* load(std::string path);
 };
\ No newline at end of file
@@ -1,110 +1,165 @@
 #include "CartesianGenerator.h"
-#include "CartesianTree.h"
-#include <queue>
-#include <cmath>
+#include "../Util/Parallel.h"
+#include <algorithm>
 #include <climits>
 
 
-
 /**
-* Encodes a cartesian tree using LOUDS, but starting from the LSB instead of MSB and adding a 1 at the very end (MSB).
-* We add a 1 to distinguish between 0s representing the last recorded nodes and 0s of not filled bits.
-* LOUDS uses 2n+1 (2n+2 with modification) bits to encode a tree with n nodes.
-* This means we can support trees with up to 31 nodes, which should enough considering the size of a block (even with the fill step).
+* Fills the table of ballot numbers according to C_{0,0} = 1 and C_{p,q} = C_{p,q-1} + C_{p-1,q} for 0 <= p <= q != 0, else 0.
+* C_{s,s} is the s-th Catalan number, the number of distinct cartesian trees with s nodes.
 */
-uint64_t encodeTree(CartesianTree* tree) {
-	uint64_t encoded = 0x1; // 10 start for LOUDS.
-	uint64_t encodeIndex = 2; // 2, because first two bits are already filled with 10.
-	std::queue<CartesianNode*> queue;
-	queue.push(tree->getRoot());
-	while (!queue.empty()) { // Breadth first search.
-		CartesianNode* node = queue.front();
-		queue.pop();
-		// Add 1s corresponding to number of children
-		for (uint64_t childIndex = 0; childIndex < node->getNumberChildren(); childIndex++) {
-			encoded = encoded + (uint64_t) pow(2, encodeIndex);
-			encodeIndex++;
-		}
-		encodeIndex++;// Add 0.
-		if (node->getLeftChild() != nullptr) { // Push left before right child, because we are traversing left to right.
-			queue.push(node->getLeftChild());
-		}
-		if (node->getRightChild() != nullptr) {
-			queue.push(node->getRightChild());
+void CartesianGenerator::fillBallotNumbers(std::vector<uint64_t>* ballotNumbers, uint64_t size) {
+	uint64_t width = size + 1;
+	ballotNumbers->assign(width * width, 0);
+	for (uint64_t q = 0; q <= size; q++) {
+		for (uint64_t p = 0; p <= q; p++) {
+			if (q == 0) {
+				(*ballotNumbers)[0] = 1;
+				continue;
+			}
+			uint64_t left = (*ballotNumbers)[p * width + q - 1]; // C_{p,q-1} is 0 for p > q-1, since it was never filled.
+			uint64_t lower = p == 0 ? 0 : (*ballotNumbers)[(p - 1) * width + q];
+			(*ballotNumbers)[p * width + q] = left + lower;
 		}
 	}
-	encoded = encoded + (uint64_t) pow(2, encodeIndex - 1); // Add 1 at the end
-	return encoded;
 }
 
-/**
-* Fills the tree corresponding to this root with extra leaves as suggested in en.wikipedia.org/wiki/Range_minimum_query.
-* (Solution using constant time and linear space)
-* This is needed to make child on the left/right side of a nodes distinguishable.
-*/
-void fillCartesianTree(CartesianNode* node) {
-	if (node->getLeftChild() == nullptr) {
-		node->setLeftChild(new CartesianNode(ULLONG_MAX, node));
-	}
-	else {
-		fillCartesianTree(node->getLeftChild());
-	}
-	if (node->getRightChild() == nullptr) {
-		node->setRightChild(new CartesianNode(ULLONG_MAX, node));
+template <typename Value, typename Compare>
+uint64_t CartesianGenerator::signature(const Value* block, uint64_t blockSize, const std::vector<uint64_t>& ballotNumbers, Compare compare) {
+	// The stack holds the right spine of the cartesian tree built so far. A block has at most 32 numbers.
+	Value stack[32];
+	uint64_t stackSize = 0;
+	uint64_t signature = 0;
+	uint64_t q = blockSize;
+	uint64_t width = blockSize + 1;
+	for (uint64_t i = 0; i < blockSize; i++) {
+		Value value = block[i];
+		// Every pop moves us one step in the ballot sequence, which adds the number of sequences we skip over.
+		while (stackSize > 0 && compare(value, stack[stackSize - 1])) {
+			signature += ballotNumbers[(blockSize - 1 - i) * width + q];
+			q--;
+			stackSize--;
+		}
+		stack[stackSize] = value;
+		stackSize++;
 	}
-	else {
-		fillCartesianTree(node->getRightChild());
+	return signature;
+}
+
+template <typename Value, typename Compare>
+void CartesianGenerator::writeAnswerRow(const Value* block, uint64_t blockSize, uint8_t* row, Compare compare) {
+	for (uint64_t i = 0; i < blockSize; i++) {
+		uint64_t min = i;
+		for (uint64_t j = i; j < blockSize; j++) {
+			if (compare(block[j], block[min])) {
+				min = j;
+			}
+			row[i * blockSize + j] = (uint8_t)min;
+		}
 	}
 }
 
-uint64_t CartesianGenerator::rangeMinimumQuery(uint64_t blockNum, uint64_t min, uint64_t max) {
-	return treeMap_->at(blockTrees_->at(blockNum))->rangeMinimumQuery(min, max);
+uint64_t CartesianGenerator::rangeMinimumQuery(uint64_t blockNum, uint64_t min, uint64_t max) const {
+	return inBlockAnswers_[blockRows_[blockNum] * blockSize_ * blockSize_ + min * blockSize_ + max];
 }
 
-uint64_t CartesianGenerator::generateCartesianTree(std::vector<uint64_t>* numbers) {
-	CartesianNode* currentNode = new CartesianNode(numbers->at(0), nullptr);
-	CartesianTree* tree = new CartesianTree(currentNode);
-	for (uint64_t i = 1; i < numbers->size(); i++) {
-		while (true) {
-			if (currentNode->getValue() <= numbers->at(i)) {
-				// Insert as right child and make previous right child the left child of the new node
-				CartesianNode* newNode = new CartesianNode(numbers->at(i), currentNode, currentNode->getRightChild(), nullptr);
-				if (currentNode->getRightChild() != nullptr) {
-					currentNode->getRightChild()->setParent(newNode);
-				}
-				currentNode->setRightChild(newNode);
-				currentNode = newNode;
-				break;
+template <typename Value, typename Compare>
+CartesianGenerator::CartesianGenerator(const Value* numbers, uint64_t numBlocks, uint64_t blockSize, uint64_t threads, Compare compare) :
+	blockSize_(blockSize) {
+	fillBallotNumbers(&ballotNumbers_, blockSize_);
+	std::vector<uint64_t> signatures(numBlocks);
+	// Computing the signatures is independent for every block.
+	parallelFor(numBlocks, threads, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t i = begin; i < end; i++) {
+			signatures[i] = signature(numbers + i * blockSize_, blockSize_, ballotNumbers_, compare);
+		}
+	});
+	// Give every distinct signature a row. Signatures lie in [0, C_s), so if there are less possible signatures than blocks, a plain vector maps them.
+	// Else there are only few blocks, and the rows are found by a binary search in the sorted distinct signatures.
+	// Both are flat arrays, so there is no allocation per tree.
+	uint64_t catalan = ballotNumbers_.back();
+	std::vector<uint32_t> denseRows;
+	std::vector<uint64_t> sparseSignatures;
+	if (catalan <= numBlocks) {
+		denseRows.assign(catalan, UINT_MAX);
+	}
+	else {
+		sparseSignatures = signatures;
+		std::sort(sparseSignatures.begin(), sparseSignatures.end());
+		sparseSignatures.erase(std::unique(sparseSignatures.begin(), sparseSignatures.end()), sparseSignatures.end());
+	}
+	std::vector<uint32_t> blockRows(numBlocks);
+	// firstBlocks[r] is the first block with the tree of row r, its numbers are used to compute the answers of the row.
+	// Dense rows are numbered in the order of their first blocks. Sparse rows are numbered by sorted signature, so they are all known in advance, but found in any order.
+	std::vector<uint64_t> firstBlocks(sparseSignatures.size(), ULLONG_MAX);
+	if (!denseRows.empty()) {
+		firstBlocks.reserve(std::min(catalan, numBlocks));
+	}
+	for (uint64_t i = 0; i < numBlocks; i++) {
+		if (!denseRows.empty()) {
+			uint32_t& row = denseRows[signatures[i]];
+			if (row == UINT_MAX) {
+				row = (uint32_t)firstBlocks.size();
+				firstBlocks.push_back(i);
 			}
-			else if (currentNode == tree->getRoot()) {
-				// Insert as new root
-				CartesianNode* newNode = new CartesianNode(numbers->at(i), nullptr, currentNode, nullptr);
-				currentNode->setParent(newNode);
-				tree->setRoot(newNode);
-				currentNode = newNode;
-				break;
+			blockRows[i] = row;
+		}
+		else {
+			uint64_t row = std::lower_bound(sparseSignatures.begin(), sparseSignatures.end(), signatures[i]) - sparseSignatures.begin();
+			if (firstBlocks[row] == ULLONG_MAX) {
+				firstBlocks[row] = i;
 			}
-			currentNode = currentNode->getParent();
+			blockRows[i] = (uint32_t)row;
 		}
 	}
-	fillCartesianTree(tree->getRoot()); // Fill first
-	uint64_t encodedTree = encodeTree(tree); // Then encode
-	return encodedTree;
+	// Now the number of rows is known, so the table is allocated once and its rows are filled independently.
+	std::vector<uint8_t> inBlockAnswers(firstBlocks.size() * blockSize_ * blockSize_);
+	parallelFor(firstBlocks.size(), threads, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t row = begin; row < end; row++) {
+			writeAnswerRow(numbers + firstBlocks[row] * blockSize_, blockSize_, inBlockAnswers.data() + row * blockSize_ * blockSize_, compare);
+		}
+	});
+	blockRows_ = FlatArray<uint32_t>(std::move(blockRows));
+	inBlockAnswers_ = FlatArray<uint8_t>(std::move(inBlockAnswers));
+	ballotNumbers_.clear();
+	ballotNumbers_.shrink_to_fit();
 }
 
-CartesianGenerator::CartesianGenerator(std::vector<std::vector<uint64_t>*>* blocks) {
-	treeMap_ = new std::unordered_map <uint64_t, NaiveRMQ*>();
-	blockTrees_ = new std::vector<uint64_t>();
-	for (uint64_t i = 0; i < blocks->size(); i++) {
-		uint64_t encodedTree = generateCartesianTree(blocks->at(i));
-		treeMap_->insert({ encodedTree, new NaiveRMQ(*(blocks->at(i))) }); // If already present in map, this does nothing. O(1)
-		blockTrees_->push_back(encodedTree);
-	}
+void CartesianGenerator::save(SnapshotWriter* writer) const {
+	writer->writeArray(blockRows_);
+	writer->writeArray(inBlockAnswers_);
 }
 
-CartesianGenerator::~CartesianGenerator() {
-	for (auto pair : *treeMap_) {
-		delete pair.second;
+CartesianGenerator* CartesianGenerator::load(SnapshotReader* reader, uint64_t numBlocks, uint64_t blockSize) {
+	CartesianGenerator* generator = new CartesianGenerator();
+	generator->blockSize_ = blockSize;
+	generator->blockRows_ = reader->readArray<uint32_t>();
+	generator->inBlockAnswers_ = reader->readArray<uint8_t>();
+	// Only the sizes are checked. Checking every row index would read the whole array, and the snapshot is trusted beyond that.
+	if (!reader->isValid() || generator->blockRows_.size() != numBlocks || generator->inBlockAnswers_.size() % (blockSize * blockSize) != 0) {
+		reader->invalidate();
+		delete generator;
+		return nullptr;
 	}
-	delete treeMap_;
-}
\ No newline at end of file
+	return generator;
+}
+
+
+template CartesianGenerator::CartesianGenerator(const uint32_t*, uint64_t, uint64_t, uint64_t, std::less<uint32_t>);
+template CartesianGenerator::CartesianGenerator(const uint32_t*, uint64_t, uint64_t, uint64_t, std::greater<uint32_t>);
+template CartesianGenerator::CartesianGenerator(const uint64_t*, uint64_t, uint64_t, uint64_t, std::less<uint64_t>);
+template CartesianGenerator::CartesianGenerator(const uint64_t*, uint64_t, uint64_t, uint64_t, std::greater<uint64_t>);
+template CartesianGenerator::CartesianGenerator(const double*, uint64_t, uint64_t, uint64_t, std::less<double>);
+template CartesianGenerator::CartesianGenerator(const double*, uint64_t, uint64_t, uint64_t, std::greater<double>);
+template uint64_t CartesianGenerator::signature(const uint32_t*, uint64_t, const std::vector<uint64_t>&, std::less<uint32_t>);
+template uint64_t CartesianGenerator::signature(const uint32_t*, uint64_t, const std::vector<uint64_t>&, std::greater<uint32_t>);
+template uint64_t CartesianGenerator::signature(const uint64_t*, uint64_t, const std::vector<uint64_t>&, std::less<uint64_t>);
+template uint64_t CartesianGenerator::signature(const uint64_t*, uint64_t, const std::vector<uint64_t>&, std::greater<uint64_t>);
+template uint64_t CartesianGenerator::signature(const double*, uint64_t, const std::vector<uint64_t>&, std::less<double>);
+template uint64_t CartesianGenerator::signature(const double*, uint64_t, const std::vector<uint64_t>&, std::greater<double>);
+template void CartesianGenerator::writeAnswerRow(const uint32_t*, uint64_t, uint8_t*, std::less<uint32_t>);
+template void CartesianGenerator::writeAnswerRow(const uint32_t*, uint64_t, uint8_t*, std::greater<uint32_t>);
+template void CartesianGenerator::writeAnswerRow(const uint64_t*, uint64_t, uint8_t*, std::less<uint64_t>);
+template void CartesianGenerator::writeAnswerRow(const uint64_t*, uint64_t, uint8_t*, std::greater<uint64_t>);
+template void CartesianGenerator::writeAnswerRow(const double*, uint64_t, uint8_t*, std::less<double>);
+template void CartesianGenerator::writeAnswerRow(const double*, uint64_t, uint8_t*, std::greater<double>);
\ No newline at end of file
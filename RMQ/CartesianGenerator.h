@@ -1,48 +1,100 @@
 #pragma once
-#include <unordered_map>
-#include "NaiveRMQ.h"
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include "../Util/FlatArray.h"
+#include "../IO/Snapshot.h"
 
 class CartesianGenerator {
 
 private:
 
-	// The map storing all the possible cartesian trees and a corresponding rmq data structure.
-	std::unordered_map <uint64_t, NaiveRMQ*>* treeMap_;
+	// Size of one block. All blocks have the same size.
+	uint64_t blockSize_;
 
-	// A vector containing the cartesian trees for all blocks. Access is handled with the block index.
-	std::vector<uint64_t>* blockTrees_;
+	// Ballot numbers C_{p,q} for 0 <= p,q <= blockSize_, stored at p * (blockSize_ + 1) + q. Only needed during construction.
+	std::vector<uint64_t> ballotNumbers_;
 
-	/*
-	* Generates the cartesian tree for a given vector of numbers and fills them to give every node exactly 2 children.
-	* The filling is needed to make the trees unique (because left/right child matters for cartesian trees!)
-	* The filling operation are the ones according to en.wikipedia.org/wiki/Range_minimum_query.
-	* (Solution using constant time and linear space)
-	* The encoding is according to LOUDS.
-	*/ 
-	uint64_t generateCartesianTree(std::vector<uint64_t>* numbers);
+	// The row in inBlockAnswers_ for every block. Access is handled with the block index. Blocks with the same cartesian tree share a row.
+	FlatArray<uint32_t> blockRows_;
+
+	/**
+	* All answers for all distinct cartesian trees in one flat table.
+	* A row has blockSize_ * blockSize_ entries, the answer for [min, max] in row r lies at r * blockSize_^2 + min * blockSize_ + max.
+	* The answers are positions relative to the block's beginning.
+	*/
+	FlatArray<uint8_t> inBlockAnswers_;
+
+	CartesianGenerator() {}
 
 public:
 
 	/**
-	* Performs a range minimum query by searching for a fitting cartesian tree and delegating the query to the saved rmq data structure.
+	* Fills the table of ballot numbers C_{p,q} for 0 <= p,q <= size, stored at p * (size + 1) + q, which signature() needs for blocks of the given size.
+	*/
+	static void fillBallotNumbers(std::vector<uint64_t>* ballotNumbers, uint64_t size);
+
+	/**
+	* Computes the signature of the cartesian tree of the given block.
+	* This is the ballot number (Catalan index) of the tree as described by Fischer and Heun, a number in [0, C_s).
+	* The tree is never built, the signature is computed from the pops of the stack based construction.
+	* Two blocks get the same signature, if and only if they have the same cartesian tree.
+	* Equal numbers are not popped from the stack, so the leftmost minimum is the root of its subtree.
+	*
+	* @param block The first number of the block to compute the signature of.
+	* @param blockSize The size of the block.
+	* @param ballotNumbers The ballot numbers for blocks of this size, see fillBallotNumbers().
+	* @param compare The order of the numbers.
+	*/
+	template <typename Value, typename Compare>
+	static uint64_t signature(const Value* block, uint64_t blockSize, const std::vector<uint64_t>& ballotNumbers, Compare compare);
+
+	/**
+	* Writes the row holding the answers for all ranges in the given block.
+	*
+	* @param block The first number of the block for whose cartesian tree the answers are computed.
+	* @param blockSize The size of the block.
+	* @param row The row of the in-block answers to write. Must have space for blockSize * blockSize answers.
+	* @param compare The order of the numbers.
+	*/
+	template <typename Value, typename Compare>
+	static void writeAnswerRow(const Value* block, uint64_t blockSize, uint8_t* row, Compare compare);
+
+	/**
+	* Performs a range minimum query by looking up the answer in the row of the block's cartesian tree.
 	* Since all answers are already saved, this should take O(1) time.
 	*
 	* @param blockNum Index of the block in which the query is performed.
 	* @param min The minimum range for the query.
 	* @param max The maximum range for the query.
 	*/
-	uint64_t rangeMinimumQuery(uint64_t blockNum, uint64_t min, uint64_t max);
+	uint64_t rangeMinimumQuery(uint64_t blockNum, uint64_t min, uint64_t max) const;
+
+	void save(SnapshotWriter* writer) const;
 
 	/**
-	* Construct a CartesianGenerator for the given blocks.
-	* The blocks all have to be the same size!
-	* 
-	* @param blocks The vector of vectors representing all blocks.
+	* Loads a CartesianGenerator written by save(). The arrays stay in the snapshot mapping.
+	*
+	* @param reader The snapshot to read from.
+	* @param numBlocks The number of blocks the generator has to know.
+	* @param blockSize The size of the blocks.
+	* @return The loaded generator, or nullptr if the snapshot does not fit the given sizes.
 	*/
-	CartesianGenerator(std::vector<std::vector<uint64_t>*>* blocks);
+	static CartesianGenerator* load(SnapshotReader* reader, uint64_t numBlocks, uint64_t blockSize);
 
 	/**
-	* Deconstructs the CartesianGenerator to free up all reserved memory.
+	* Construct a CartesianGenerator for the given blocks.
+	* The blocks all have to be the same size and at most 32 numbers long!
+	* The signatures of the blocks are computed on multiple threads, only the assignment of rows is done by one thread.
+	* The answers are positions, so only the construction depends on the type and order of the numbers.
+	* It is instantiated for uint32_t, uint64_t and double, each with std::less and std::greater.
+	* 
+	* @param numbers All numbers, block after block.
+	* @param numBlocks The number of blocks.
+	* @param blockSize The size of every block.
+	* @param threads The number of threads used for construction. 0 uses all hardware threads.
+	* @param compare The order of the numbers.
 	*/
-	~CartesianGenerator();
+	template <typename Value, typename Compare = std::less<Value>>
+	CartesianGenerator(const Value* numbers, uint64_t numBlocks, uint64_t blockSize, uint64_t threads = 1, Compare compare = Compare());
 };
\ No newline at end of file
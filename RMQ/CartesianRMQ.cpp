@@ -1,91 +1,246 @@
 #include "CartesianRMQ.h"
+#include "../Util/Parallel.h"
+#include "../Util/Profile.h"
+#include "../Util/MinimumScan.h"
+#include "../IO/Snapshot.h"
 #include <cmath>
-#include <algorithm>
-#include <climits>
 
-void CartesianRMQ::splitInBlocks(std::vector<uint64_t> numbers) {
+template <typename Value, typename Compare>
+void CartesianRMQ<Value, Compare>::splitInBlocks(uint64_t threads) {
 	uint64_t numBlocks = totalPaddedSize_ / blockSize_;
-	for (uint64_t i = 0; i < numBlocks; i++) {
-		std::vector<uint64_t>* block = new std::vector<uint64_t>(numbers.begin() + (i * blockSize_), numbers.begin() + (i * blockSize_) + blockSize_);
-		blocks_->push_back(block);
-		// Now find min and position of min
-		uint64_t minimum = block->at(0);
-		uint64_t position = 0;
-		for (uint64_t i = 1; i < block->size(); i++) {
-			if (block->at(i) < minimum) {
-				minimum = block->at(i);
-				position = i; // Position is relative to block start and needs to be transformed before use.
-			}
-		}
-		blockMinimum_->push_back(minimum);
-		blockMinimumPos_->push_back(position);
-	}
+	std::vector<Value> blockMinimum(numBlocks);
+	std::vector<uint8_t> blockMinimumPos(numBlocks);
+	const Value* values = values_.data();
+	// Blocks are independent of each other, so every thread can scan its own range of blocks.
+	// The positions are relative to the block start and need to be transformed before use.
+	parallelFor(numBlocks, threads, [&](uint64_t begin, uint64_t end) {
+		blockMinima(values + begin * blockSize_, end - begin, blockSize_, blockMinimum.data() + begin, blockMinimumPos.data() + begin, compare_);
+	});
+	blockMinimum_ = FlatArray<Value>(std::move(blockMinimum));
+	blockMinimumPos_ = FlatArray<uint8_t>(std::move(blockMinimumPos));
+}
+
+template <typename Value, typename Compare>
+uint64_t CartesianRMQ<Value, Compare>::inBlockQuery(uint64_t blockNum, uint64_t min, uint64_t max) const {
+	return treeGenerator_ != nullptr ? treeGenerator_->rangeMinimumQuery(blockNum, min, max) : lazyTreeGenerator_->rangeMinimumQuery(blockNum, min, max);
 }
 
-uint64_t CartesianRMQ::rangeMinimumQuery(uint64_t min, uint64_t max) {
-	uint64_t minBorder = (uint64_t)floor(min / blockSize_);
-	uint64_t maxBorder = (uint64_t)floor(max / blockSize_);
+template <typename Value, typename Compare>
+std::pair<uint64_t, Value> CartesianRMQ<Value, Compare>::blockQuery(const QueryPlan& plan) const {
+	uint64_t min = plan.min;
+	uint64_t max = plan.max;
+	uint64_t minBorder = plan.minBorder;
+	uint64_t maxBorder = plan.maxBorder;
 	bool checkForWholeBlocks = true;
-	uint64_t queryOnePos = ULLONG_MAX, queryTwoPos = ULLONG_MAX, queryThreePos = ULLONG_MAX;
-	uint64_t queryOneVal = ULLONG_MAX, queryTwoVal = ULLONG_MAX, queryThreeVal = ULLONG_MAX;
+	// The subqueries are answered from left to right, and only a strictly smaller value replaces the minimum found so far.
+	// So equal numbers resolve to the leftmost position, just as for the scan.
+	std::pair<uint64_t, Value> minimum;
+	bool found = false;
+	auto consider = [&](uint64_t position, Value value) {
+		if (!found || compare_(value, minimum.second)) {
+			minimum = { position, value };
+			found = true;
+		}
+	};
 	if (minBorder == maxBorder) { // Whole query is only one block
-		return treeGenerator_->rangeMinimumQuery(minBorder, min - blockSize_ * minBorder, max - blockSize_ * minBorder) + (blockSize_ * minBorder);
+		uint64_t position = inBlockQuery(minBorder, min - blockSize_ * minBorder, max - blockSize_ * minBorder) + (blockSize_ * minBorder);
+		return { position, values_[position] };
 	}
-	if (min % blockSize_ != 0) { // We have a left subquery that we have to answer with cartesian trees.
-		queryOnePos = treeGenerator_->rangeMinimumQuery(minBorder, min - blockSize_ * minBorder, blockSize_ - 1) + (blockSize_ * minBorder); // Global position
-		queryOneVal = blocks_->at(minBorder)->at(queryOnePos - (blockSize_ * minBorder)); // Use relative position in block to get value.
-		if (minBorder == blocks_->size()) { // Query is only last block
+	// The right subquery has to be considered last, but it decides whether there are whole blocks left, so it is answered first.
+	uint64_t queryTwoPos = 0;
+	bool hasQueryTwo = false;
+	if (min != minBorder * blockSize_) { // We have a left subquery that we have to answer with cartesian trees.
+		uint64_t queryOnePos = inBlockQuery(minBorder, min - blockSize_ * minBorder, blockSize_ - 1) + (blockSize_ * minBorder); // Global position
+		consider(queryOnePos, values_[queryOnePos]);
+		if (minBorder == blockMinimum_.size()) { // Query is only last block
 			checkForWholeBlocks = false;
 		}
 		minBorder++;
 	}
-	if ((max+1) % blockSize_ != 0) { // We have a right subquery that we have to answer with cartesian trees.
-		queryTwoPos = treeGenerator_->rangeMinimumQuery(maxBorder, 0, max - blockSize_ * maxBorder) + (blockSize_ * maxBorder); // Global position
-		queryTwoVal = blocks_->at(maxBorder)->at(queryTwoPos - (blockSize_ * maxBorder)); // Use relative position in block to get value.
+	if (max + 1 != (maxBorder + 1) * blockSize_) { // We have a right subquery that we have to answer with cartesian trees.
+		queryTwoPos = inBlockQuery(maxBorder, 0, max - blockSize_ * maxBorder) + (blockSize_ * maxBorder); // Global position
+		hasQueryTwo = true;
 		if (maxBorder == 0) { // Query is only first block
 			checkForWholeBlocks = false;
 		}
 		maxBorder--;
 	}
 	if (checkForWholeBlocks && minBorder <= maxBorder) { // We have one or more complete blocks between that are still part of the query. 
-		uint64_t minBlockNum = blockRMQ_->rangeMinimumQuery(minBorder, maxBorder);
-		queryThreePos = blockMinimumPos_->at(minBlockNum) + minBlockNum * blockSize_; // Recieve and transform to global position of minimal number in found minimal block.
-		queryThreeVal = blocks_->at(minBlockNum)->at(queryThreePos - (minBlockNum * blockSize_)); // Use relative position in block to get value.
+		uint64_t minBlockNum = blockRMQ_ != nullptr ? blockRMQ_->rangeMinimumQuery(minBorder, maxBorder) : linearBlockRMQ_->rangeMinimumQuery(minBorder, maxBorder);
+		uint64_t queryThreePos = blockMinimumPos_[minBlockNum] + minBlockNum * blockSize_; // Recieve and transform to global position of minimal number in found minimal block.
+		consider(queryThreePos, blockMinimum_[minBlockNum]);
 	}
-	uint64_t minimumQueryVal = std::min({ queryOneVal, queryTwoVal, queryThreeVal });
-	if (minimumQueryVal == queryOneVal) {
-		return queryOnePos;
+	if (hasQueryTwo) {
+		consider(queryTwoPos, values_[queryTwoPos]);
 	}
-	else if (minimumQueryVal == queryTwoVal) {
-		return queryTwoPos;
+	return minimum;
+}
+
+template <typename Value, typename Compare>
+std::pair<uint64_t, Value> CartesianRMQ<Value, Compare>::rangeMinimum(uint64_t min, uint64_t max) const {
+	if (max - min < scanThreshold_) { // Scanning a short range directly is faster than combining the three subqueries.
+		uint64_t position = min + minimumPosition(values_.data() + min, max - min + 1, compare_);
+		return { position, values_[position] };
 	}
-	else { // minimumQueryVal == queryThreeVal
-		return queryThreePos;
+	return blockQuery({ min, max, min / blockSize_, max / blockSize_ });
+}
+
+template <typename Value, typename Compare>
+uint64_t CartesianRMQ<Value, Compare>::rangeMinimumQuery(uint64_t min, uint64_t max) const {
+	if (max - min < scanThreshold_) {
+		return min + minimumPosition(values_.data() + min, max - min + 1, compare_);
 	}
+	return blockQuery({ min, max, min / blockSize_, max / blockSize_ }).first;
 }
 
-CartesianRMQ::CartesianRMQ(std::vector<uint64_t> numbers) {
-	blocks_ = new std::vector<std::vector<uint64_t>*>();
-	blockMinimum_ = new std::vector<uint64_t>();
-	blockMinimumPos_ = new std::vector<uint64_t>();
+template <typename Value, typename Compare>
+void CartesianRMQ<Value, Compare>::prefetchQuery(const QueryPlan& plan) const {
+	if (plan.max - plan.min < scanThreshold_) {
+		__builtin_prefetch(values_.data() + plan.min);
+		__builtin_prefetch(values_.data() + plan.max);
+	}
+}
+
+template <typename Value, typename Compare>
+void CartesianRMQ<Value, Compare>::rangeMinimumQueries(const std::pair<uint64_t, uint64_t>* queries, size_t n, uint64_t* out) const {
+	// The plans of the prefetched queries, the plan of query i is at i % prefetchDistance_.
+	QueryPlan plans[prefetchDistance_];
+	for (size_t i = 0; i < n + prefetchDistance_; i++) {
+		// The answered query frees its place for query i.
+		if (i >= prefetchDistance_) {
+			const QueryPlan& plan = plans[i % prefetchDistance_];
+			out[i - prefetchDistance_] = plan.max - plan.min < scanThreshold_ ? plan.min + minimumPosition(values_.data() + plan.min, plan.max - plan.min + 1, compare_) : blockQuery(plan).first;
+		}
+		if (i < n) {
+			uint64_t min = queries[i].first;
+			uint64_t max = queries[i].second;
+			plans[i % prefetchDistance_] = { min, max, min / blockSize_, max / blockSize_ };
+			prefetchQuery(plans[i % prefetchDistance_]);
+		}
+	}
+}
+
+template <typename Value, typename Compare>
+CartesianRMQ<Value, Compare>::CartesianRMQ(std::vector<Value> numbers, uint64_t threads, uint64_t blockSize, bool linearBlocks, bool lazyBlocks, Compare compare) :
+	compare_(compare) {
 	totalSize_ = numbers.size();
-	blockSize_ = (uint64_t)std::ceil(std::log2(totalSize_) / 4); // s = ceil(log(n)/4)
-	if (totalSize_ % blockSize_ != 0) { // Check for padding
+	// s = ceil(log(n)/4), the logarithm is only defined for n > 0.
+	blockSize_ = totalSize_ == 0 ? 1 : (uint64_t)std::ceil(std::log2(totalSize_) / 4);
+	if (blockSize != 0) {
+		blockSize_ = blockSize < maxBlockSize_ ? blockSize : maxBlockSize_;
+	}
+	if (blockSize_ == 0) { // Only happens for a single number.
+		blockSize_ = 1;
+	}
+	if (totalSize_ != 0 && totalSize_ % blockSize_ != 0) { // Check for padding, an empty array has nothing to copy.
 		uint64_t toFill = blockSize_ - (totalSize_ % blockSize_); // Tells us how many spaces we must fill
+		numbers.reserve(totalSize_ + toFill); // Exactly the padded size, growing by push_back could double the kept values.
+		Value last = numbers.back();
 		for (uint64_t i = 0; i < toFill; i++) {
-			numbers.push_back(ULLONG_MAX); // Push back the max numbers, so minima queries still work in the last block.
+			numbers.push_back(last); // Copies of the last number never win against it, so minima queries still work in the last block, for any order.
 		}
 	}
 	totalPaddedSize_ = numbers.size();
-	splitInBlocks(numbers);
-	blockRMQ_ = new LogRMQ(*blockMinimum_);
-	treeGenerator_ = new CartesianGenerator(blocks_);
+	values_ = FlatArray<Value>(std::move(numbers));
+	beginPhase("blocks");
+	splitInBlocks(threads);
+	endPhase();
+	beginPhase("block_rmq");
+	if (linearBlocks) {
+		linearBlockRMQ_ = new LinearRMQ<Value, Compare>(blockMinimum_.data(), blockMinimum_.size(), threads, compare_);
+	}
+	else {
+		blockRMQ_ = new LogRMQ<Value, Compare>(blockMinimum_.data(), blockMinimum_.size(), threads, compare_);
+	}
+	endPhase();
+	beginPhase("signatures");
+	if (lazyBlocks) {
+		lazyTreeGenerator_ = new LazyCartesianGenerator<Value, Compare>(values_.data(), blockMinimum_.size(), blockSize_, compare_);
+	}
+	else {
+		treeGenerator_ = new CartesianGenerator(values_.data(), blockMinimum_.size(), blockSize_, threads, compare_);
+	}
+	endPhase();
+}
+
+template <typename Value, typename Compare>
+bool CartesianRMQ<Value, Compare>::save(std::string path) const {
+	SnapshotWriter writer(path, SNAPSHOT_KIND_CARTESIAN_RMQ);
+	writer.writeValue(snapshotValueType<Value>());
+	writer.writeValue(blockSize_);
+	writer.writeValue(totalSize_);
+	writer.writeValue(totalPaddedSize_);
+	writer.writeArray(values_);
+	writer.writeArray(blockMinimum_);
+	writer.writeArray(blockMinimumPos_);
+	if (treeGenerator_ != nullptr) {
+		treeGenerator_->save(&writer);
+	}
+	else {
+		CartesianGenerator(values_.data(), blockMinimum_.size(), blockSize_, 1, compare_).save(&writer);
+	}
+	writer.writeValue(blockRMQ_ != nullptr ? 0 : 1);
+	if (blockRMQ_ != nullptr) {
+		blockRMQ_->save(&writer);
+	}
+	else {
+		linearBlockRMQ_->save(&writer);
+	}
+	return writer.finish();
 }
 
-CartesianRMQ::~CartesianRMQ() {
-	for (uint64_t i = 0; i < blocks_->size(); i++) {
-		delete blocks_->at(i);
+template <typename Value, typename Compare>
+CartesianRMQ<Value, Compare>* CartesianRMQ<Value, Compare>::load(std::string path, Compare compare) {
+	SnapshotReader reader(path, SNAPSHOT_KIND_CARTESIAN_RMQ);
+	CartesianRMQ* rmq = new CartesianRMQ();
+	rmq->compare_ = compare;
+	if (reader.readValue() != snapshotValueType<Value>()) {
+		reader.invalidate();
+	}
+	rmq->blockSize_ = reader.readValue();
+	rmq->totalSize_ = reader.readValue();
+	rmq->totalPaddedSize_ = reader.readValue();
+	rmq->values_ = reader.readArray<Value>();
+	rmq->blockMinimum_ = reader.readArray<Value>();
+	rmq->blockMinimumPos_ = reader.readArray<uint8_t>();
+	if (rmq->blockSize_ == 0 || rmq->blockSize_ > maxBlockSize_ || rmq->values_.size() != rmq->totalPaddedSize_ || rmq->totalPaddedSize_ != rmq->blockMinimum_.size() * rmq->blockSize_
+		|| rmq->blockMinimumPos_.size() != rmq->blockMinimum_.size()) {
+		reader.invalidate();
+	}
+	if (reader.isValid()) {
+		rmq->treeGenerator_ = CartesianGenerator::load(&reader, rmq->blockMinimum_.size(), rmq->blockSize_);
+		if (reader.readValue() == 0) {
+			rmq->blockRMQ_ = LogRMQ<Value, Compare>::load(&reader, rmq->blockMinimum_.data(), rmq->blockMinimum_.size(), compare);
+		}
+		else {
+			rmq->linearBlockRMQ_ = LinearRMQ<Value, Compare>::load(&reader, rmq->blockMinimum_.data(), rmq->blockMinimum_.size(), compare);
+		}
+	}
+	if (!reader.isValid()) {
+		delete rmq;
+		return nullptr;
 	}
-	delete blocks_;
+	rmq->mapping_ = reader.getMapping();
+	return rmq;
+}
+
+template <typename Value, typename Compare>
+void CartesianRMQ<Value, Compare>::setScanThreshold(uint64_t threshold) {
+	scanThreshold_ = threshold;
+}
+
+template <typename Value, typename Compare>
+CartesianRMQ<Value, Compare>::~CartesianRMQ() {
 	delete treeGenerator_;
-}
\ No newline at end of file
+	delete lazyTreeGenerator_;
+	delete blockRMQ_;
+	delete linearBlockRMQ_;
+}
+
+
+template class CartesianRMQ<uint32_t>;
+template class CartesianRMQ<uint32_t, std::greater<uint32_t>>;
+template class CartesianRMQ<uint64_t>;
+template class CartesianRMQ<uint64_t, std::greater<uint64_t>>;
+template class CartesianRMQ<double>;
+template class CartesianRMQ<double, std::greater<double>>;
\ No newline at end of file
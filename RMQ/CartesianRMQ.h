@@ -1,70 +1,199 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <functional>
 #include "CartesianGenerator.h"
+#include "LazyCartesianGenerator.h"
 #include "LogRMQ.h"
+#include "LinearRMQ.h"
+#include "../Util/FlatArray.h"
+#include "../IO/MappedFile.h"
 
 /**
 Class for processing rmq queries in O(1) with O(n) space usage.
 This is achieved by utilising cartesian trees and their properties towards rmq queries.
-We save cartesian trees as a string of variable size instead of a number of fixed size to support queries for arbitrary sizes.
-This costs more memory in general, but the memory requirement in the O() notation stays the same.
+Every block gets the ballot number of its cartesian tree as signature, and blocks with the same signature share one table of in-block answers.
 n is the size of the vector, on which the queries are performed.
+All parts are flat arrays without any pointers, so a CartesianRMQ can be saved to a snapshot and used directly from a memory mapping of it.
+Value is the type of the numbers and Compare their order, the minimum is the number no other number compares less than. std::greater<Value> answers range maximum queries.
+Value and Compare are instantiated for uint32_t, uint64_t and double, each with std::less and std::greater.
 */
+template <typename Value, typename Compare = std::less<Value>>
 class CartesianRMQ {
 
 private:
 
-	// A vector of all blocks in vector format. The last block gets padded with highest the possible number.
-	std::vector<std::vector<uint64_t>*>* blocks_;
+	// All numbers, block after block. The last block gets padded with copies of the last number, which never win against it, since equal numbers resolve to the leftmost position.
+	FlatArray<Value> values_;
 
-	// A vector containing the minimal number for every block. It has the same length as blocks_.
-	std::vector<uint64_t>* blockMinimum_;
+	// The order of the numbers. It is not part of snapshots.
+	Compare compare_;
 
-	// A vector containing the position of the minimal number for every block. The position is realtive to the block's beginning! It has the same length as blocks_.
-	std::vector<uint64_t>* blockMinimumPos_;
+	// A vector containing the minimal number for every block. It has one entry per block.
+	FlatArray<Value> blockMinimum_;
 
-	// Size of one block log_2(totalSize_))/4.
+	// A vector containing the position of the minimal number for every block. The position is realtive to the block's beginning! It has one entry per block.
+	FlatArray<uint8_t> blockMinimumPos_;
+
+	// Size of one block, ceil(log_2(totalSize_) / 4), unless another size was given.
 	uint64_t blockSize_;
 
+	// Largest possible block size. The signature of a block has to fit 64 bits, and the construction keeps at most 32 numbers on its stack.
+	static const uint64_t maxBlockSize_ = 32;
+
 	// Total size of all original elements that have been divided into blocks WITHOUT the added padding.
 	uint64_t totalSize_;
 
 	// Total size of all elements that have been divided into blocks with the added padding.
 	uint64_t totalPaddedSize_;
 
-	// The cartesian tree generator used to generate and store all possible cartesian trees for  blocksize_ length.
-	CartesianGenerator* treeGenerator_;
+	// The cartesian tree generator used to compute the signatures of all blocks and store the in-block answers for every distinct signature.
+	// Either this one or lazyTreeGenerator_ is used, the other one stays nullptr.
+	CartesianGenerator* treeGenerator_ = nullptr;
+
+	// The alternative to treeGenerator_, which materializes the blocks the first time a query touches them. It is chosen at construction.
+	LazyCartesianGenerator<Value, Compare>* lazyTreeGenerator_ = nullptr;
+
+	// A log rmq data structure to manage queries over multiple entire blocks. Either this one or linearBlockRMQ_ is used, the other one stays nullptr.
+	LogRMQ<Value, Compare>* blockRMQ_ = nullptr;
+
+	// The linear space alternative to blockRMQ_, which is chosen at construction.
+	LinearRMQ<Value, Compare>* linearBlockRMQ_ = nullptr;
+
+	// Default for scanThreshold_, measured with random queries. Up to this length, the scan beats the cache misses of the subqueries.
+	static const uint64_t defaultScanThreshold_ = 32;
+
+	// Queries over at most this many numbers scan the values directly. It is not part of snapshots.
+	uint64_t scanThreshold_ = defaultScanThreshold_;
+
+	// How many queries ahead rangeMinimumQueries() prefetches.
+	static const size_t prefetchDistance_ = 8;
+
+	/**
+	* A query with the blocks of both ends, so the divisions are only done once for prefetching and answering.
+	*/
+	struct QueryPlan {
+		uint64_t min;
+		uint64_t max;
+		uint64_t minBorder;
+		uint64_t maxBorder;
+	};
 
-	// A log rmq data structure to manage queries over multiple entire blocks.
-	LogRMQ* blockRMQ_;
+	// The snapshot the arrays point into, if the data structure was loaded. Empty for built ones.
+	std::shared_ptr<MappedFile> mapping_;
 
 	/**
-	* Splits the input array into blocks and saves them in the blocks_ field.
-	* Also saves the minimum per block in the blockMinimum_ field.
+	* Splits the padded values_ into blocks.
+	* Saves the minimum per block in the blockMinimum_ field and its position in the blockMinimumPos_ field.
 	*
-	* @param numbers The vector of numbers to be split into blocks.
+	* @param threads The number of threads splitting the blocks.
 	*/
-	void splitInBlocks(std::vector<uint64_t> numbers);
+	void splitInBlocks(uint64_t threads);
+
+	/**
+	* Answers a query within one block from the in-block answers of the tree generator in use. Returns the position relative to the block's beginning.
+	*/
+	uint64_t inBlockQuery(uint64_t blockNum, uint64_t min, uint64_t max) const;
+
+	/**
+	* Answers a query, which is too long for the scan, with the subqueries on the partial blocks at both ends and the whole blocks in between.
+	* Returns the position and the value of the minimum.
+	*/
+	std::pair<uint64_t, Value> blockQuery(const QueryPlan& plan) const;
+
+	/**
+	* Prefetches the values of a query that gets scanned.
+	* Longer queries aren't prefetched: their misses are independent of each other and already overlap in the out of order window,
+	* so prefetching the block rows, in-block answers or sparse table entries only added work in measurements.
+	*/
+	void prefetchQuery(const QueryPlan& plan) const;
+
+	CartesianRMQ() {}
 
 public:
 
 	/**
 	* Performs a range minimum query.
 	* Since all answers are already saved, this should take O(1) time.
+	* The query only reads the data structure, so it can be called from multiple threads at the same time.
+	*
+	* @param min The minimum range for the query.
+	* @param max The maximum range for the query.
+	*/
+	uint64_t rangeMinimumQuery(uint64_t min, uint64_t max) const;
+
+	/**
+	* Performs a range minimum query and returns the position together with the minimum itself.
+	* The subqueries compare the values anyway, so this is as fast as rangeMinimumQuery() and saves the caller another cache miss on the numbers.
 	*
 	* @param min The minimum range for the query.
 	* @param max The maximum range for the query.
+	* @return The position of the leftmost minimum and the minimum.
+	*/
+	std::pair<uint64_t, Value> rangeMinimum(uint64_t min, uint64_t max) const;
+
+	/**
+	* Performs the range minimum query for all n queries and writes the answers into out.
+	* A short query is a scan, which waits on the cache misses of its values before anything else can happen.
+	* So while a query is answered, the values of the query prefetchDistance_ ahead are prefetched, and the misses of multiple queries overlap.
+	* The queries only read the data structure, so multiple threads can answer batches at the same time.
+	*
+	* @param queries The ranges, each given as (min, max).
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	*/
+	void rangeMinimumQueries(const std::pair<uint64_t, uint64_t>* queries, size_t n, uint64_t* out) const;
+
+	/**
+	* Sets the length up to which queries scan the values directly instead of using the blocks. 0 never scans.
 	*/
-	uint64_t rangeMinimumQuery(uint64_t min, uint64_t max);
+	void setScanThreshold(uint64_t threshold);
 
 	/**
 	* Constructs a CartesianRMQ to answer rmq queries in O(1) with O(n) space usage.
 	* It adds padding to the numbers if needed and provides the padded vector as input for the generator.
+	* All construction phases work on independent blocks, or independent entries of a layer, and are split over the given number of threads.
 	* 
+	* The numbers are taken over as the values of the structure, so moving them in avoids any copy.
+	*
+	* Larger blocks shrink the LogRMQ over the block minima, which has about 4 * log_2(n / s) bytes per block, and the queries over whole blocks.
+	* But the number of distinct cartesian trees grows with the Catalan number C_s, and each tree takes s^2 bytes of in-block answers.
+	* Beyond about 12 numbers per block, nearly every block gets its own answers, so they cost s bytes per number.
+	* A LinearRMQ over the block minima instead takes about 8.3 bytes per block regardless of n, but its queries over whole blocks read a few more words.
+	* With lazyBlocks, only the block minima and the structure over them are built, and every block gets its in-block answers when a query first needs them.
+	*
 	* @param numbers The vector of numbers to perform later queries on.
+	* @param threads The number of threads used for construction. 0 uses all hardware threads.
+	* @param blockSize The numbers per block. 0 uses ceil(log_2(n) / 4), larger sizes than 32 are reduced to 32.
+	* @param linearBlocks Uses a LinearRMQ instead of the LogRMQ for the queries over whole blocks.
+	* @param lazyBlocks Uses a LazyCartesianGenerator instead of the CartesianGenerator for the queries within blocks.
+	* @param compare The order of the numbers.
+	*/
+	CartesianRMQ(std::vector<Value> numbers, uint64_t threads = 1, uint64_t blockSize = 0, bool linearBlocks = false, bool lazyBlocks = false, Compare compare = Compare());
+
+	/**
+	* Saves the data structure to a snapshot file (see IO/Snapshot.h).
+	* The layout is: the value type, sizes, values, block minima and their positions, the CartesianGenerator, whether the LinearRMQ is used and the LogRMQ or LinearRMQ.
+	* The order is not saved, so the snapshot has to be loaded with the Compare it was built with.
+	* A lazy data structure writes the in-block answers of all blocks, so it is loaded like an eagerly built one.
+	*
+	* @param path The snapshot file to write.
+	* @return false, if the snapshot could not be written.
+	*/
+	bool save(std::string path) const;
+
+	/**
+	* Loads a CartesianRMQ from a snapshot file written by save().
+	* The file is memory mapped and all arrays are used in place, so queries can be answered right away and pages are only read when touched.
+	*
+	* @param path The snapshot file to read.
+	* @param compare The order the data structure was built with.
+	* @return The loaded data structure, or nullptr if the file is no valid snapshot of a CartesianRMQ with this value type.
 	*/
-	CartesianRMQ(std::vector<uint64_t> numbers);
+	static CartesianRMQ* load(std::string path, Compare compare = Compare());
 
 	/**
 	* Deconstructs the CartesianRMQ to free all reserved memory.
@@ -0,0 +1,200 @@
+#include "HierarchicalRMQ.h"
+#include "../Util/Parallel.h"
+#include "../Util/Profile.h"
+#include "../IO/Snapshot.h"
+
+template <typename Value, typename Compare>
+void HierarchicalRMQ<Value, Compare>::buildMacroBlocks(uint64_t threads) {
+	uint64_t numMicro = micro_.numBlocks();
+	uint64_t numMacro = (numMicro + microPerMacro_ - 1) / microPerMacro_;
+	std::vector<uint8_t> microTables(numMacro * microLayers_ * microPerMacro_);
+	std::vector<Value> macroMinimum(numMacro);
+	std::vector<uint16_t> macroMinimumPos(numMacro);
+	const Value* minima = micro_.minima();
+	parallelFor(numMacro, threads, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t macro = begin; macro < end; macro++) {
+			uint64_t base = macro * microPerMacro_;
+			uint64_t count = numMicro - base < microPerMacro_ ? numMicro - base : microPerMacro_;
+			// Same construction as in LogRMQ. Entries reaching over the last micro block are clipped to it, so every entry is a valid micro block.
+			for (uint64_t l = 1; l <= microLayers_; l++) {
+				uint8_t* layer = microTables.data() + (macro * microLayers_ + l - 1) * microPerMacro_;
+				const uint8_t* previous = l == 1 ? nullptr : layer - microPerMacro_;
+				uint64_t half = 1ULL << (l - 1);
+				for (uint64_t x = 0; x < microPerMacro_; x++) {
+					uint64_t p1 = l == 1 ? (x < count ? x : count - 1) : previous[x];
+					uint64_t p2 = l == 1 ? (x + 1 < count ? x + 1 : count - 1) : (x + half < microPerMacro_ ? previous[x + half] : p1);
+					layer[x] = (uint8_t)(compare_(minima[base + p2], minima[base + p1]) ? p2 : p1);
+				}
+			}
+			uint64_t best = 0;
+			for (uint64_t k = 1; k < count; k++) {
+				if (compare_(minima[base + k], minima[base + best])) {
+					best = k;
+				}
+			}
+			macroMinimum[macro] = minima[base + best];
+			macroMinimumPos[macro] = (uint16_t)(micro_.minimumPosition(base + best) - macro * macroSize_);
+		}
+	});
+	microTables_ = FlatArray<uint8_t>(std::move(microTables));
+	macroMinimum_ = FlatArray<Value>(std::move(macroMinimum));
+	macroMinimumPos_ = FlatArray<uint16_t>(std::move(macroMinimumPos));
+}
+
+template <typename Value, typename Compare>
+uint64_t HierarchicalRMQ<Value, Compare>::macroQuery(uint64_t macro, uint64_t first, uint64_t last) const {
+	uint64_t l = floorLog2(last - first + 1);
+	if (l == 0) {
+		return first;
+	}
+	const uint8_t* layer = microTables_.data() + (macro * microLayers_ + l - 1) * microPerMacro_;
+	uint64_t p1 = layer[first];
+	uint64_t p2 = layer[last - (1ULL << l) + 1];
+	const Value* minima = micro_.minima() + macro * microPerMacro_;
+	return compare_(minima[p2], minima[p1]) ? p2 : p1;
+}
+
+template <typename Value, typename Compare>
+std::pair<uint64_t, Value> HierarchicalRMQ<Value, Compare>::rangeMinimum(uint64_t min, uint64_t max) const {
+	uint64_t microMin = min / microSize_;
+	uint64_t microMax = max / microSize_;
+	if (microMin == microMax) { // Whole query is only one micro block
+		uint64_t position = micro_.query(min, max);
+		return { position, values_[position] };
+	}
+	// The subqueries are answered from left to right, and only a strictly smaller value replaces the minimum found so far.
+	// So equal numbers resolve to the leftmost position.
+	uint64_t leftPos = micro_.query(min, microMin * microSize_ + microSize_ - 1);
+	std::pair<uint64_t, Value> minimum = { leftPos, values_[leftPos] };
+	auto consider = [&](uint64_t position, Value value) {
+		if (compare_(value, minimum.second)) {
+			minimum = { position, value };
+		}
+	};
+	auto considerMicro = [&](uint64_t micro) {
+		consider(micro_.minimumPosition(micro), micro_.minimum(micro));
+	};
+	if (microMin + 1 < microMax) { // We have one or more complete micro blocks between.
+		uint64_t first = microMin + 1;
+		uint64_t last = microMax - 1;
+		uint64_t macroFirst = first / microPerMacro_;
+		uint64_t macroLast = last / microPerMacro_;
+		if (macroFirst == macroLast) {
+			considerMicro(macroFirst * microPerMacro_ + macroQuery(macroFirst, first - macroFirst * microPerMacro_, last - macroFirst * microPerMacro_));
+		}
+		else {
+			considerMicro(macroFirst * microPerMacro_ + macroQuery(macroFirst, first - macroFirst * microPerMacro_, microPerMacro_ - 1));
+			if (macroFirst + 1 < macroLast) { // We have one or more complete macro blocks between.
+				uint64_t macro = macroRMQ_->rangeMinimumQuery(macroFirst + 1, macroLast - 1);
+				consider(macro * macroSize_ + macroMinimumPos_[macro], macroMinimum_[macro]);
+			}
+			considerMicro(macroLast * microPerMacro_ + macroQuery(macroLast, 0, last - macroLast * microPerMacro_));
+		}
+	}
+	uint64_t rightPos = micro_.query(microMax * microSize_, max);
+	consider(rightPos, values_[rightPos]);
+	return minimum;
+}
+
+template <typename Value, typename Compare>
+uint64_t HierarchicalRMQ<Value, Compare>::rangeMinimumQuery(uint64_t min, uint64_t max) const {
+	return rangeMinimum(min, max).first;
+}
+
+template <typename Value, typename Compare>
+void HierarchicalRMQ<Value, Compare>::rangeMinimumQueries(const std::pair<uint64_t, uint64_t>* queries, size_t n, uint64_t* out) const {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = rangeMinimum(queries[i].first, queries[i].second).first;
+	}
+}
+
+template <typename Value, typename Compare>
+HierarchicalRMQ<Value, Compare>::HierarchicalRMQ(std::vector<Value> numbers, uint64_t threads, uint64_t macroSize, Compare compare) :
+	compare_(compare) {
+	size_ = numbers.size();
+	if (macroSize == 0) {
+		macroSize = defaultMacroSize_;
+	}
+	if (macroSize > 256 * microSize_) { // The micro blocks of a macro block have to fit into a byte.
+		macroSize = 256 * microSize_;
+	}
+	macroSize_ = (macroSize + microSize_ - 1) / microSize_ * microSize_;
+	microPerMacro_ = macroSize_ / microSize_;
+	microLayers_ = floorLog2(microPerMacro_);
+	values_ = FlatArray<Value>(std::move(numbers));
+	beginPhase("micro_blocks");
+	micro_ = StackMaskBlocks<Value, Compare>(values_.data(), size_, threads, compare_);
+	endPhase();
+	beginPhase("macro_blocks");
+	buildMacroBlocks(threads);
+	endPhase();
+	beginPhase("macro_rmq");
+	macroRMQ_ = new LogRMQ<Value, Compare>(macroMinimum_.data(), macroMinimum_.size(), threads, compare_);
+	endPhase();
+}
+
+template <typename Value, typename Compare>
+bool HierarchicalRMQ<Value, Compare>::save(std::string path) const {
+	SnapshotWriter writer(path, SNAPSHOT_KIND_HIERARCHICAL_RMQ);
+	writer.writeValue(snapshotValueType<Value>());
+	writer.writeValue(size_);
+	writer.writeValue(macroSize_);
+	writer.writeArray(values_);
+	micro_.save(&writer);
+	writer.writeArray(microTables_);
+	writer.writeArray(macroMinimum_);
+	writer.writeArray(macroMinimumPos_);
+	macroRMQ_->save(&writer);
+	return writer.finish();
+}
+
+template <typename Value, typename Compare>
+HierarchicalRMQ<Value, Compare>* HierarchicalRMQ<Value, Compare>::load(std::string path, Compare compare) {
+	SnapshotReader reader(path, SNAPSHOT_KIND_HIERARCHICAL_RMQ);
+	HierarchicalRMQ* rmq = new HierarchicalRMQ();
+	rmq->compare_ = compare;
+	if (reader.readValue() != snapshotValueType<Value>()) {
+		reader.invalidate();
+	}
+	rmq->size_ = reader.readValue();
+	rmq->macroSize_ = reader.readValue();
+	if (rmq->macroSize_ == 0 || rmq->macroSize_ % microSize_ != 0 || rmq->macroSize_ > 256 * microSize_) {
+		reader.invalidate();
+		rmq->macroSize_ = microSize_; // Keeps the sizes below computable.
+	}
+	rmq->microPerMacro_ = rmq->macroSize_ / microSize_;
+	rmq->microLayers_ = floorLog2(rmq->microPerMacro_);
+	rmq->values_ = reader.readArray<Value>();
+	rmq->micro_.load(&reader, rmq->size_);
+	rmq->microTables_ = reader.readArray<uint8_t>();
+	rmq->macroMinimum_ = reader.readArray<Value>();
+	rmq->macroMinimumPos_ = reader.readArray<uint16_t>();
+	uint64_t numMicro = (rmq->size_ + microSize_ - 1) / microSize_;
+	uint64_t numMacro = (numMicro + rmq->microPerMacro_ - 1) / rmq->microPerMacro_;
+	if (rmq->values_.size() != rmq->size_ || rmq->microTables_.size() != numMacro * rmq->microLayers_ * rmq->microPerMacro_
+		|| rmq->macroMinimum_.size() != numMacro || rmq->macroMinimumPos_.size() != numMacro) {
+		reader.invalidate();
+	}
+	if (reader.isValid()) {
+		rmq->macroRMQ_ = LogRMQ<Value, Compare>::load(&reader, rmq->macroMinimum_.data(), rmq->macroMinimum_.size(), compare);
+	}
+	if (!reader.isValid()) {
+		delete rmq;
+		return nullptr;
+	}
+	rmq->mapping_ = reader.getMapping();
+	return rmq;
+}
+
+template <typename Value, typename Compare>
+HierarchicalRMQ<Value, Compare>::~HierarchicalRMQ() {
+	delete macroRMQ_;
+}
+
+
+template class HierarchicalRMQ<uint32_t>;
+template class HierarchicalRMQ<uint32_t, std::greater<uint32_t>>;
+template class HierarchicalRMQ<uint64_t>;
+template class HierarchicalRMQ<uint64_t, std::greater<uint64_t>>;
+template class HierarchicalRMQ<double>;
+template class HierarchicalRMQ<double, std::greater<double>>;
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <functional>
+#include "LogRMQ.h"
+#include "StackMaskBlocks.h"
+#include "../Util/FlatArray.h"
+#include "../IO/MappedFile.h"
+
+/**
+Class for processing rmq queries in O(1) with three levels of blocks instead of the two of CartesianRMQ.
+Micro blocks are the blocks of 64 numbers of StackMaskBlocks, where a word per position answers every query within a micro block.
+Macro blocks group the micro blocks, and a small sparse table over the minima of the micro blocks of every macro block answers queries over whole micro blocks.
+A LogRMQ over the minima of the macro blocks answers queries over whole macro blocks.
+So the LogRMQ has n / macroSize_ entries per layer, and in-block lookups are a single word, which trades 8 bytes per number for the tables of CartesianRMQ.
+With equal numbers, the leftmost position is returned, just as for CartesianRMQ.
+n is the size of the vector, on which the queries are performed.
+Value and Compare are instantiated for uint32_t, uint64_t and double, each with std::less and std::greater.
+*/
+template <typename Value, typename Compare = std::less<Value>>
+class HierarchicalRMQ {
+
+private:
+
+	// All numbers.
+	FlatArray<Value> values_;
+
+	// The order of the numbers. It is not part of snapshots.
+	Compare compare_;
+
+	// Number of numbers.
+	uint64_t size_ = 0;
+
+	// Number of numbers in a macro block. Always a multiple of the micro block size.
+	uint64_t macroSize_ = 0;
+
+	// Number of micro blocks in a macro block, at most 256, so they can be indexed with a byte.
+	uint64_t microPerMacro_ = 0;
+
+	// The stack masks of all positions and the minima of the micro blocks.
+	StackMaskBlocks<Value, Compare> micro_;
+
+	/**
+	* The sparse tables over the micro blocks of every macro block, storing the micro block of the minimum relative to the macro block.
+	* A macro block has microLayers_ layers of microPerMacro_ entries, layer 0 is not stored, since its entries are just x.
+	* Entry x of layer l of the table of macro block b is at (b * microLayers_ + l - 1) * microPerMacro_ + x.
+	* Entries reaching over the end of the last macro block are never read.
+	*/
+	FlatArray<uint8_t> microTables_;
+
+	// floor(log_2(microPerMacro_)), the number of stored layers per macro block.
+	uint64_t microLayers_ = 0;
+
+	// The minimum of every macro block.
+	FlatArray<Value> macroMinimum_;
+
+	// The position of the minimum of every macro block, relative to the block's beginning.
+	FlatArray<uint16_t> macroMinimumPos_;
+
+	// A log rmq data structure to manage queries over multiple entire macro blocks.
+	LogRMQ<Value, Compare>* macroRMQ_ = nullptr;
+
+	// The snapshot the arrays point into, if the data structure was loaded. Empty for built ones.
+	std::shared_ptr<MappedFile> mapping_;
+
+	// Number of numbers in a micro block.
+	static const uint64_t microSize_ = StackMaskBlocks<Value, Compare>::BLOCK_SIZE;
+
+	// Default for macroSize_. Smaller macro blocks make the LogRMQ larger, larger ones make the sparse tables per macro block larger.
+	static const uint64_t defaultMacroSize_ = 1024;
+
+	/**
+	* Computes the sparse table, and the minimum and its position of every macro block from the micro block minima.
+	* Macro blocks are independent of each other, so they are split over the given number of threads.
+	*/
+	void buildMacroBlocks(uint64_t threads);
+
+	/**
+	* Returns the micro block with the minimum among the micro blocks [first, last] of the given macro block, relative to the macro block.
+	*/
+	uint64_t macroQuery(uint64_t macro, uint64_t first, uint64_t last) const;
+
+	HierarchicalRMQ() {}
+
+public:
+
+	/**
+	* Performs a range minimum query and returns the position together with the minimum itself.
+	* It combines up to five subqueries: the micro blocks at both ends, the whole micro blocks in the macro blocks at both ends and the whole macro blocks in between.
+	* The query only reads the data structure, so it can be called from multiple threads at the same time.
+	*
+	* @param min The minimum range for the query.
+	* @param max The maximum range for the query.
+	* @return The position of the leftmost minimum and the minimum.
+	*/
+	std::pair<uint64_t, Value> rangeMinimum(uint64_t min, uint64_t max) const;
+
+	/**
+	* Performs a range minimum query.
+	*
+	* @param min The minimum range for the query.
+	* @param max The maximum range for the query.
+	*/
+	uint64_t rangeMinimumQuery(uint64_t min, uint64_t max) const;
+
+	/**
+	* Performs the range minimum query for all n queries and writes the answers into out.
+	*
+	* @param queries The ranges, each given as (min, max).
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	*/
+	void rangeMinimumQueries(const std::pair<uint64_t, uint64_t>* queries, size_t n, uint64_t* out) const;
+
+	/**
+	* Constructs all three levels. The micro and macro blocks are built independently on the given number of threads, just as the layers of the LogRMQ.
+	* The numbers are taken over as the values of the structure, so moving them in avoids any copy.
+	*
+	* @param numbers The vector of numbers to perform later queries on.
+	* @param threads The number of threads used for construction. 0 uses all hardware threads.
+	* @param macroSize The numbers per macro block. 0 uses 1024. It is rounded up to a multiple of 64 and kept between 64 and 16384.
+	* @param compare The order of the numbers.
+	*/
+	HierarchicalRMQ(std::vector<Value> numbers, uint64_t threads = 1, uint64_t macroSize = 0, Compare compare = Compare());
+
+	/**
+	* Saves the data structure to a snapshot file (see IO/Snapshot.h).
+	* The layout is: the value type, sizes, values, stack masks, micro block minima and their positions, the sparse tables, macro block minima and their positions and the LogRMQ.
+	* The order is not saved, so the snapshot has to be loaded with the Compare it was built with.
+	*
+	* @param path The snapshot file to write.
+	* @return false, if the snapshot could not be written.
+	*/
+	bool save(std::string path) const;
+
+	/**
+	* Loads a HierarchicalRMQ from a snapshot file written by save(). The arrays stay in the memory mapping of the snapshot.
+	*
+	* @param path The snapshot file to read.
+	* @param compare The order the data structure was built with.
+	* @return The loaded data structure, or nullptr if the file is no valid snapshot of a HierarchicalRMQ with this value type.
+	*/
+	static HierarchicalRMQ* load(std::string path, Compare compare = Compare());
+
+	/**
+	* Deconstructs the HierarchicalRMQ to free all reserved memory.
+	*/
+	~HierarchicalRMQ();
+
+};
\ No newline at end of file
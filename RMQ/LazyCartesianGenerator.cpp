@@ -0,0 +1,71 @@
+#include "LazyCartesianGenerator.h"
+#include "CartesianGenerator.h"
+
+
+template <typename Value, typename Compare>
+uint32_t LazyCartesianGenerator<Value, Compare>::materialize(uint64_t blockNum) {
+	const Value* block = numbers_ + blockNum * blockSize_;
+	// The signature only reads the numbers, so it is computed before taking the lock.
+	uint64_t signature = CartesianGenerator::signature(block, blockSize_, ballotNumbers_, compare_);
+	std::lock_guard<std::mutex> lock(mutex_);
+	uint32_t row;
+	auto known = rows_.find(signature);
+	if (known != rows_.end()) {
+		row = known->second;
+	}
+	else {
+		row = (uint32_t)rows_.size();
+		std::unique_ptr<uint8_t[]>& chunk = chunks_[row / rowsPerChunk_];
+		if (!chunk) {
+			chunk.reset(new uint8_t[rowsPerChunk_ * blockSize_ * blockSize_]);
+		}
+		CartesianGenerator::writeAnswerRow(block, blockSize_, chunk.get() + (row % rowsPerChunk_) * blockSize_ * blockSize_, compare_);
+		rows_[signature] = row;
+	}
+	// The row was written under the lock before, so a query reading this row index with acquire also sees the row.
+	blockRows_[blockNum].store(row, std::memory_order_release);
+	return row;
+}
+
+
+template <typename Value, typename Compare>
+uint64_t LazyCartesianGenerator<Value, Compare>::rangeMinimumQuery(uint64_t blockNum, uint64_t min, uint64_t max) {
+	uint32_t row = blockRows_[blockNum].load(std::memory_order_acquire);
+	if (row == unknownRow_) {
+		row = materialize(blockNum);
+	}
+	return chunks_[row / rowsPerChunk_][(row % rowsPerChunk_) * blockSize_ * blockSize_ + min * blockSize_ + max];
+}
+
+
+template <typename Value, typename Compare>
+uint64_t LazyCartesianGenerator<Value, Compare>::getMaterializedBlocks() const {
+	uint64_t count = 0;
+	for (uint64_t i = 0; i < numBlocks_; i++) {
+		count += blockRows_[i].load(std::memory_order_relaxed) != unknownRow_;
+	}
+	return count;
+}
+
+
+template <typename Value, typename Compare>
+LazyCartesianGenerator<Value, Compare>::LazyCartesianGenerator(const Value* numbers, uint64_t numBlocks, uint64_t blockSize, Compare compare) :
+	numbers_(numbers),
+	compare_(compare),
+	blockSize_(blockSize),
+	numBlocks_(numBlocks),
+	blockRows_(new std::atomic<uint32_t>[numBlocks]),
+	chunks_((numBlocks + rowsPerChunk_ - 1) / rowsPerChunk_) {
+	CartesianGenerator::fillBallotNumbers(&ballotNumbers_, blockSize_);
+	for (uint64_t i = 0; i < numBlocks; i++) {
+		blockRows_[i].store(unknownRow_, std::memory_order_relaxed);
+	}
+}
+
+
+template class LazyCartesianGenerator<uint32_t>;
+template class LazyCartesianGenerator<uint32_t, std::greater<uint32_t>>;
+template class LazyCartesianGenerator<uint64_t>;
+template class LazyCartesianGenerator<uint64_t, std::greater<uint64_t>>;
+template class LazyCartesianGenerator<double>;
+template class LazyCartesianGenerator<double, std::greater<double>>;
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+* Lazy alternative to the CartesianGenerator, which computes the signature and the in-block answers of a block the first time a query touches it.
+* Construction only allocates one row index per block, so it takes O(n / s) time, and blocks that are never queried cost nothing else.
+* Like in the CartesianGenerator, blocks with the same cartesian tree share one row of blockSize_ * blockSize_ in-block answers.
+* Queries can come from multiple threads at the same time: the row of a block is published with an atomic store, after the row was written under a lock.
+* Queries on blocks that are already materialized never take the lock.
+* The numbers are not owned and have to outlive the generator.
+* Value is the type of the numbers and Compare their order, instantiated like the CartesianRMQ.
+*/
+template <typename Value, typename Compare = std::less<Value>>
+class LazyCartesianGenerator {
+
+private:
+	// The numbers, block after block.
+	const Value* numbers_;
+
+	Compare compare_;
+
+	// Size of one block. All blocks have the same size.
+	uint64_t blockSize_;
+
+	// Number of blocks.
+	uint64_t numBlocks_;
+
+	// Ballot numbers for blocks of blockSize_ numbers, see CartesianGenerator::fillBallotNumbers(). Kept for the signatures of blocks touched later.
+	std::vector<uint64_t> ballotNumbers_;
+
+	// Row marking a block that was never touched.
+	static const uint32_t unknownRow_ = UINT32_MAX;
+
+	// The row of every block, or unknownRow_.
+	std::unique_ptr<std::atomic<uint32_t>[]> blockRows_;
+
+	// Number of rows per chunk of answers. A chunk never moves, so published rows stay valid while others are added.
+	static const uint64_t rowsPerChunk_ = 64;
+
+	// The chunks of rows, allocated when their first row is needed. There are enough slots for every block to get its own row, so this vector never grows.
+	std::vector<std::unique_ptr<uint8_t[]>> chunks_;
+
+	// The row of every signature that was materialized so far.
+	std::unordered_map<uint64_t, uint32_t> rows_;
+
+	// Guards rows_ and the allocation and writing of rows.
+	std::mutex mutex_;
+
+	/**
+	* Computes the signature of the block, assigns it a row and writes the row, if the signature is new, and publishes the row of the block.
+	* Returns the row.
+	*/
+	uint32_t materialize(uint64_t blockNum);
+
+public:
+	/**
+	* Performs a range minimum query in the given block, materializing the block first if no query touched it before.
+	* Materialization changes the internal state, so this is not const, but it can be called from multiple threads at the same time.
+	*
+	* @param blockNum Index of the block in which the query is performed.
+	* @param min The minimum range for the query.
+	* @param max The maximum range for the query.
+	* @return The position of the minimum, relative to the block's beginning.
+	*/
+	uint64_t rangeMinimumQuery(uint64_t blockNum, uint64_t min, uint64_t max);
+
+	/**
+	* Returns the number of blocks which were touched by queries so far.
+	*/
+	uint64_t getMaterializedBlocks() const;
+
+	/**
+	* Constructs a lazy generator for the given blocks. Nothing is computed for the blocks yet.
+	*
+	* @param numbers All numbers, block after block.
+	* @param numBlocks The number of blocks.
+	* @param blockSize The size of every block, at most 32 numbers.
+	* @param compare The order of the numbers.
+	*/
+	LazyCartesianGenerator(const Value* numbers, uint64_t numBlocks, uint64_t blockSize, Compare compare = Compare());
+};
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "LinearRMQ.h"
+
+template <typename Value, typename Compare>
+uint64_t LinearRMQ<Value, Compare>::upperQuery(uint64_t first, uint64_t last) const {
+	return upper_ != nullptr ? upper_->rangeMinimumQuery(first, last) : top_->rangeMinimumQuery(first, last);
+}
+
+template <typename Value, typename Compare>
+uint64_t LinearRMQ<Value, Compare>::rangeMinimumQuery(uint64_t min, uint64_t max) const {
+	uint64_t blockMin = min / blockSize_;
+	uint64_t blockMax = max / blockSize_;
+	if (blockMin == blockMax) { // Whole query is only one block
+		return blocks_.query(min, max);
+	}
+	// The subqueries are answered from left to right, and only a strictly smaller number replaces the minimum found so far.
+	// So equal numbers resolve to the leftmost position.
+	uint64_t minimum = blocks_.query(min, blockMin * blockSize_ + blockSize_ - 1);
+	if (blockMin + 1 < blockMax) { // We have one or more complete blocks between.
+		uint64_t block = upperQuery(blockMin + 1, blockMax - 1);
+		if (compare_(blocks_.minimum(block), numbers_[minimum])) {
+			minimum = blocks_.minimumPosition(block);
+		}
+	}
+	uint64_t right = blocks_.query(blockMax * blockSize_, max);
+	return compare_(numbers_[right], numbers_[minimum]) ? right : minimum;
+}
+
+template <typename Value, typename Compare>
+void LinearRMQ<Value, Compare>::save(SnapshotWriter* writer) const {
+	writer->writeValue(size_);
+	blocks_.save(writer);
+	if (upper_ != nullptr) {
+		upper_->save(writer);
+	}
+	else {
+		top_->save(writer);
+	}
+}
+
+template <typename Value, typename Compare>
+LinearRMQ<Value, Compare>* LinearRMQ<Value, Compare>::load(SnapshotReader* reader, const Value* numbers, uint64_t size, Compare compare) {
+	LinearRMQ* rmq = new LinearRMQ();
+	rmq->numbers_ = numbers;
+	rmq->compare_ = compare;
+	rmq->size_ = size;
+	uint64_t numBlocks = (size + blockSize_ - 1) / blockSize_;
+	if (reader->readValue() != size) {
+		reader->invalidate();
+	}
+	rmq->blocks_.load(reader, size);
+	if (reader->isValid()) {
+		if (numBlocks > topSize_) {
+			rmq->upper_ = load(reader, rmq->blocks_.minima(), numBlocks, compare);
+		}
+		else {
+			rmq->top_ = LogRMQ<Value, Compare>::load(reader, rmq->blocks_.minima(), numBlocks, compare);
+		}
+	}
+	if (!reader->isValid() || (rmq->upper_ == nullptr && rmq->top_ == nullptr)) {
+		delete rmq;
+		return nullptr;
+	}
+	return rmq;
+}
+
+template <typename Value, typename Compare>
+LinearRMQ<Value, Compare>::LinearRMQ(const Value* numbers, uint64_t size, uint64_t threads, Compare compare) :
+	numbers_(numbers),
+	compare_(compare),
+	size_(size),
+	blocks_(numbers, size, threads, compare) {
+	if (blocks_.numBlocks() > topSize_) {
+		upper_ = new LinearRMQ(blocks_.minima(), blocks_.numBlocks(), threads, compare_);
+	}
+	else {
+		top_ = new LogRMQ<Value, Compare>(blocks_.minima(), blocks_.numBlocks(), threads, compare_);
+	}
+}
+
+template <typename Value, typename Compare>
+LinearRMQ<Value, Compare>::~LinearRMQ() {
+	delete upper_;
+	delete top_;
+}
+
+
+template class LinearRMQ<uint32_t>;
+template class LinearRMQ<uint32_t, std::greater<uint32_t>>;
+template class LinearRMQ<uint64_t>;
+template class LinearRMQ<uint64_t, std::greater<uint64_t>>;
+template class LinearRMQ<double>;
+template class LinearRMQ<double, std::greater<double>>;
\ No newline at end of file
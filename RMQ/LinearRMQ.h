@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include "LogRMQ.h"
+#include "StackMaskBlocks.h"
+#include "../Util/FlatArray.h"
+#include "../IO/Snapshot.h"
+
+/**
+Class for processing RMQ queries with O(n) space usage, as an alternative to the O(n log(n)) entries of LogRMQ.
+The numbers are split into the blocks of 64 of StackMaskBlocks, the same as the micro blocks of HierarchicalRMQ, so a query within a block is a single word. The minima of the blocks get another LinearRMQ, until at most topSize_ blocks are left, which get a LogRMQ.
+So there are about 8.3 bytes per number, and a query over many blocks takes two words per level and the LogRMQ at the top, with only a couple of levels in practice.
+With equal numbers, the leftmost position is returned, just as for LogRMQ.
+Value is the type of the numbers and Compare their order.
+Value and Compare are instantiated for uint32_t, uint64_t and double, each with std::less and std::greater.
+*/
+template <typename Value, typename Compare = std::less<Value>>
+class LinearRMQ {
+
+private:
+
+	// The numbers the queries are performed on. They are not owned and have to outlive this object.
+	const Value* numbers_;
+
+	// The order of the numbers.
+	Compare compare_;
+
+	// Number of numbers.
+	uint64_t size_ = 0;
+
+	// The stack masks of all positions and the minima of the blocks, which are the numbers of the next level.
+	StackMaskBlocks<Value, Compare> blocks_;
+
+	// The next level over the block minima, if there are more than topSize_ blocks. Otherwise top_ is used.
+	LinearRMQ* upper_ = nullptr;
+
+	// The sparse table over the block minima, if there are at most topSize_ blocks.
+	LogRMQ<Value, Compare>* top_ = nullptr;
+
+	// Number of numbers in a block.
+	static const uint64_t blockSize_ = StackMaskBlocks<Value, Compare>::BLOCK_SIZE;
+
+	// Up to this many blocks, the minima get a LogRMQ. It has at most 12 layers then, which is small against the stack masks below.
+	static const uint64_t topSize_ = 4096;
+
+	/**
+	* Returns the block with the minimum among the whole blocks [first, last].
+	*/
+	uint64_t upperQuery(uint64_t first, uint64_t last) const;
+
+	LinearRMQ() {}
+
+public:
+
+	uint64_t rangeMinimumQuery(uint64_t min, uint64_t max) const;
+
+	/**
+	* Writes the size and all arrays, followed by the next level or the LogRMQ. Which one follows is given by the size.
+	*/
+	void save(SnapshotWriter* writer) const;
+
+	/**
+	* Loads a LinearRMQ written by save(). The arrays stay in the snapshot mapping.
+	*
+	* @param reader The snapshot to read from.
+	* @param numbers The numbers the structure was built on. Only a pointer is kept, so they have to outlive this object.
+	* @param size The number of numbers.
+	* @param compare The order the structure was built with.
+	* @return The loaded structure, or nullptr if the snapshot does not fit the given size.
+	*/
+	static LinearRMQ* load(SnapshotReader* reader, const Value* numbers, uint64_t size, Compare compare = Compare());
+
+	/**
+	* Constructs all levels. The blocks of a level are independent of each other, so they are split over the given number of threads.
+	*
+	* @param numbers The numbers to perform later queries on. Only a pointer is kept, so they have to outlive this object.
+	* @param size The number of numbers.
+	* @param threads The number of threads used for construction. 0 uses all hardware threads.
+	* @param compare The order of the numbers.
+	*/
+	LinearRMQ(const Value* numbers, uint64_t size, uint64_t threads = 1, Compare compare = Compare());
+
+	/**
+	* Deconstructs the LinearRMQ and all levels above it.
+	*/
+	~LinearRMQ();
+};
\ No newline at end of file
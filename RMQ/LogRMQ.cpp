@@ -1,66 +1,128 @@
 #include "LogRMQ.h"
-#include <cmath>
+#include "../Util/Parallel.h"
 
 
-/**
-* Calculates l, which determines how many elements the longest vector in the solution vectors has.
-* 
-* @param length The length of the input vector.
-*/
-uint64_t calculateLayers(uint64_t length) {
-	return ((uint64_t)std::floor(std::log2(length))) + 1;
+uint64_t floorLog2(uint64_t length) {
+	return 63 - __builtin_clzll(length);
 }
 
-std::pair<uint64_t, uint64_t> LogRMQ::accessLayerData(uint64_t min, uint64_t max) {
-	return savedAnswers->at(min)->at((uint64_t)std::log2(max - min + 1));
+template <typename Value, typename Compare>
+template <typename Index>
+void LogRMQ<Value, Compare>::build(std::vector<FlatArray<Index>>* layers, uint64_t threads) {
+	const Value* numbers = numbers_;
+	uint64_t n = size_;
+	uint64_t layerCount = n == 0 ? 0 : floorLog2(n);
+	layers->resize(layerCount);
+	// l and x are defined as in the lecture. Layer 0 is implicit, so layer 1 compares the numbers directly.
+	for (uint64_t l = 1; l <= layerCount; l++) {
+		std::vector<Index>& layer = (*layers)[l - 1].edit();
+		const Index* previous = l == 1 ? nullptr : (*layers)[l - 2].data();
+		uint64_t half = 1ULL << (l - 1);
+		layer.resize(n - (1ULL << l) + 1);
+		parallelFor(layer.size(), threads, [&](uint64_t begin, uint64_t end) {
+			for (uint64_t x = begin; x < end; x++) {
+				// Construction formula from the lecture. On equal values the left position wins.
+				uint64_t p1 = l == 1 ? x : previous[x];
+				uint64_t p2 = l == 1 ? x + 1 : previous[x + half];
+				layer[x] = (Index)(compare_(numbers[p2], numbers[p1]) ? p2 : p1);
+			}
+		});
+	}
 }
 
-uint64_t LogRMQ::rangeMinimumQuery(uint64_t min, uint64_t max) {
+template <typename Value, typename Compare>
+template <typename Index>
+uint64_t LogRMQ<Value, Compare>::query(const std::vector<FlatArray<Index>>& layers, uint64_t min, uint64_t max) const {
 	// All three query formulas as defined in the lecture.
-	uint64_t l = (uint64_t)std::floor(std::log2(max - min + 1));
-	uint64_t splitMax = (uint64_t)(min + pow(2, l) - 1);
-	uint64_t splitMin = (uint64_t)(max - pow(2, l) + 1);
-	std::pair<uint64_t, uint64_t> p1 = accessLayerData(min, splitMax);
-	std::pair<uint64_t, uint64_t> p2 = accessLayerData(splitMin, max);
-	if (p1.first <= p2.first) {
-		return p1.second; 
+	uint64_t l = floorLog2(max - min + 1);
+	if (l == 0) {
+		return min;
+	}
+	uint64_t splitMin = max - (1ULL << l) + 1;
+	uint64_t p1 = layers[l - 1][min];
+	uint64_t p2 = layers[l - 1][splitMin];
+	if (compare_(numbers_[p2], numbers_[p1])) {
+		return p2;
 	}
 	else {
-		return p2.second;
+		return p1;
 	}
 }
 
+template <typename Value, typename Compare>
+uint64_t LogRMQ<Value, Compare>::rangeMinimumQuery(uint64_t min, uint64_t max) const {
+	if (wideLayers_.empty()) {
+		return query(narrowLayers_, min, max);
+	}
+	return query(wideLayers_, min, max);
+}
 
-LogRMQ::LogRMQ(std::vector<uint64_t> numbers) {
-	savedAnswers = new std::vector<std::vector<std::pair<uint64_t, uint64_t>>*>();
-	uint64_t layer = calculateLayers(numbers.size());
-	// Initialize and fill in the first (trivial) values.
-	for (uint64_t i = 0; i < numbers.size(); i++) {
-		savedAnswers->push_back(new std::vector<std::pair<uint64_t, uint64_t>>());
-		savedAnswers->at(i)->push_back({numbers[i], i});
+template <typename Value, typename Compare>
+void LogRMQ<Value, Compare>::save(SnapshotWriter* writer) const {
+	writer->writeValue(wideLayers_.empty() ? 0 : 1);
+	writer->writeValue(wideLayers_.empty() ? narrowLayers_.size() : wideLayers_.size());
+	for (uint64_t l = 0; l < narrowLayers_.size(); l++) {
+		writer->writeArray(narrowLayers_[l]);
 	}
-	// Now fill in the rest. l and x are defined as in the lecture. We start with l = 1 because we already filled the trivial values.
-	for (uint64_t l = 1; l <= layer; l++) {
-		for (uint64_t x = 0; x < numbers.size(); x++) {
-			uint64_t upperBound = (uint64_t)(pow(2, l) - 1 + x); // -1 because position x in inclusive.
-			if (upperBound < numbers.size()) {
-				std::pair<uint64_t, uint64_t> p1 = savedAnswers->at(x)->at(l-1);
-				std::pair<uint64_t, uint64_t> p2 = savedAnswers->at((uint64_t)(x + pow(2, l-1)))->at(l-1); // Construction formula from the lecture
-				if (p1.first <= p2.first) { // p1 is smaller or same size
-					savedAnswers->at(x)->push_back(p1);
-				}
-				else { // p2 is smaller 
-					savedAnswers->at(x)->push_back(p2);
-				}
-			}
+	for (uint64_t l = 0; l < wideLayers_.size(); l++) {
+		writer->writeArray(wideLayers_[l]);
+	}
+}
+
+template <typename Value, typename Compare>
+template <typename Index>
+void LogRMQ<Value, Compare>::loadLayers(SnapshotReader* reader, std::vector<FlatArray<Index>>* layers) {
+	uint64_t layerCount = reader->readValue();
+	if (layerCount != (size_ == 0 ? 0 : floorLog2(size_))) {
+		reader->invalidate();
+		return;
+	}
+	for (uint64_t l = 1; l <= layerCount; l++) {
+		layers->push_back(reader->readArray<Index>());
+		if (layers->back().size() != size_ - (1ULL << l) + 1) {
+			reader->invalidate();
+			return;
 		}
 	}
 }
 
+template <typename Value, typename Compare>
+LogRMQ<Value, Compare>* LogRMQ<Value, Compare>::load(SnapshotReader* reader, const Value* numbers, uint64_t size, Compare compare) {
+	LogRMQ* rmq = new LogRMQ();
+	rmq->numbers_ = numbers;
+	rmq->compare_ = compare;
+	rmq->size_ = size;
+	if (reader->readValue() == 0) {
+		rmq->loadLayers(reader, &rmq->narrowLayers_);
+	}
+	else {
+		rmq->loadLayers(reader, &rmq->wideLayers_);
+	}
+	if (!reader->isValid()) {
+		delete rmq;
+		return nullptr;
+	}
+	return rmq;
+}
+
 
-LogRMQ::~LogRMQ() {
-	for (uint64_t i = 0; i < savedAnswers->size(); i++) {
-		delete(savedAnswers->at(i));
+template <typename Value, typename Compare>
+LogRMQ<Value, Compare>::LogRMQ(const Value* numbers, uint64_t size, uint64_t threads, Compare compare) :
+	numbers_(numbers),
+	compare_(compare),
+	size_(size) {
+	if (size <= (1ULL << 32)) {
+		build(&narrowLayers_, threads);
 	}
-	delete savedAnswers;
-}
\ No newline at end of file
+	else {
+		build(&wideLayers_, threads);
+	}
+}
+
+
+template class LogRMQ<uint32_t>;
+template class LogRMQ<uint32_t, std::greater<uint32_t>>;
+template class LogRMQ<uint64_t>;
+template class LogRMQ<uint64_t, std::greater<uint64_t>>;
+template class LogRMQ<double>;
+template class LogRMQ<double, std::greater<double>>;
\ No newline at end of file
@@ -1,34 +1,89 @@
 #pragma once
 #include <cstdint>
 #include <vector>
-#include <unordered_map>
-#include <utility>
+#include <functional>
+#include "../Util/FlatArray.h"
+#include "../IO/Snapshot.h"
+
+/**
+* Calculates floor(log_2(length)) for length > 0, which is the highest layer of a sparse table fitting into a range of this length.
+*/
+uint64_t floorLog2(uint64_t length);
 
 /**
 Class for storing RMQ answers and processing the queries in O(1) with O(n log(n)) space usage.
 n is the size of the vector, on which the queries are performed.
+Value is the type of the numbers and Compare their order, the minimum is the number no other number compares less than. std::greater<Value> answers range maximum queries.
+Value and Compare are instantiated for uint32_t, uint64_t and double, each with std::less and std::greater.
 */
+template <typename Value, typename Compare = std::less<Value>>
 class LogRMQ {
 
 private:
 
-	/** 
-	* A vector of a vector storing pairs of the min value and their position for queries. Has to save both for construction via dynamic programming.
-	* The first dimension represents the beginning value and the second dimension represents layer value l.
-	* This means getting the minimal value between [x_1,x_2] can be achieved by using savedAnswers->at(x_1)->at(log_2(x_2 - x_1 + 1)).
+	// The numbers the queries are performed on. They are not owned and have to outlive this object.
+	const Value* numbers_;
+
+	// The order of the numbers.
+	Compare compare_;
+
+	// Number of numbers.
+	uint64_t size_;
+
+	/**
+	* The sparse table, storing only the position of the minimum. The value is looked up in numbers_ when needed.
+	* Layer l is one contiguous array with n - 2^l + 1 entries, where entry x is the position of the minimum in [x, x + 2^l - 1].
+	* Layer 0 is not stored, since its entries are just x.
+	* If all positions fit into 32 bits, narrowLayers_ is used and wideLayers_ stays empty, else the other way round.
+	* layers[l - 1] holds layer l.
+	*/
+	std::vector<FlatArray<uint32_t>> narrowLayers_;
+	std::vector<FlatArray<uint64_t>> wideLayers_;
+
+	/**
+	* Fills all layers of the given table. Every layer only depends on the previous one, so the entries of a layer are computed on multiple threads.
 	*/
-	std::vector<std::vector<std::pair<uint64_t, uint64_t>>*>* savedAnswers;
+	template <typename Index>
+	void build(std::vector<FlatArray<Index>>* layers, uint64_t threads);
 
 	/**
-	* Automatically does the transformation of the second dimension to allow for access via borders.
+	* Answers the query using the two overlapping entries of layer floor(log_2(max - min + 1)).
 	*/
-	std::pair<uint64_t, uint64_t> accessLayerData(uint64_t min, uint64_t max);
+	template <typename Index>
+	uint64_t query(const std::vector<FlatArray<Index>>& layers, uint64_t min, uint64_t max) const;
+
+	/**
+	* Reads the layers written by save() and checks their sizes.
+	*/
+	template <typename Index>
+	void loadLayers(SnapshotReader* reader, std::vector<FlatArray<Index>>* layers);
+
+	LogRMQ() {}
 
 public:
 
-	uint64_t rangeMinimumQuery(uint64_t min, uint64_t max);
+	uint64_t rangeMinimumQuery(uint64_t min, uint64_t max) const;
 
-	LogRMQ(std::vector<uint64_t> numbers);
+	void save(SnapshotWriter* writer) const;
 
-	~LogRMQ();
+	/**
+	* Loads a LogRMQ written by save(). The layers stay in the snapshot mapping.
+	*
+	* @param reader The snapshot to read from.
+	* @param numbers The numbers the table was built on. Only a pointer is kept, so they have to outlive this object.
+	* @param size The number of numbers.
+	* @param compare The order the table was built with.
+	* @return The loaded table, or nullptr if the snapshot does not fit the given size.
+	*/
+	static LogRMQ* load(SnapshotReader* reader, const Value* numbers, uint64_t size, Compare compare = Compare());
+
+	/**
+	* Constructs the table layer by layer.
+	*
+	* @param numbers The numbers to perform later queries on. Only a pointer is kept, so they have to outlive this object.
+	* @param size The number of numbers.
+	* @param threads The number of threads used for construction. 0 uses all hardware threads.
+	* @param compare The order of the numbers.
+	*/
+	LogRMQ(const Value* numbers, uint64_t size, uint64_t threads = 1, Compare compare = Compare());
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "StackMaskBlocks.h"
+#include <vector>
+#include "../Util/Parallel.h"
+
+template <typename Value, typename Compare>
+void StackMaskBlocks<Value, Compare>::save(SnapshotWriter* writer) const {
+	writer->writeArray(stackMasks_);
+	writer->writeArray(minimum_);
+	writer->writeArray(minimumPos_);
+}
+
+template <typename Value, typename Compare>
+void StackMaskBlocks<Value, Compare>::load(SnapshotReader* reader, uint64_t size) {
+	uint64_t numBlocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	stackMasks_ = reader->readArray<uint64_t>();
+	minimum_ = reader->readArray<Value>();
+	minimumPos_ = reader->readArray<uint8_t>();
+	if (stackMasks_.size() != size || minimum_.size() != numBlocks || minimumPos_.size() != numBlocks) {
+		reader->invalidate();
+	}
+}
+
+template <typename Value, typename Compare>
+StackMaskBlocks<Value, Compare>::StackMaskBlocks(const Value* numbers, uint64_t size, uint64_t threads, Compare compare) {
+	uint64_t numBlocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	std::vector<uint64_t> stackMasks(size);
+	std::vector<Value> minimum(numBlocks);
+	std::vector<uint8_t> minimumPos(numBlocks);
+	parallelFor(numBlocks, threads, [&](uint64_t begin, uint64_t end) {
+		for (uint64_t block = begin; block < end; block++) {
+			uint64_t start = block * BLOCK_SIZE;
+			uint64_t length = size - start < BLOCK_SIZE ? size - start : BLOCK_SIZE;
+			// The stack of minima candidates as bits, the top is the highest set bit. Equal numbers are not popped, so the leftmost one stays a candidate.
+			uint64_t stack = 0;
+			for (uint64_t k = 0; k < length; k++) {
+				while (stack != 0 && compare(numbers[start + k], numbers[start + 63 - __builtin_clzll(stack)])) {
+					stack &= ~(1ULL << (63 - __builtin_clzll(stack)));
+				}
+				stack |= 1ULL << k;
+				stackMasks[start + k] = stack;
+			}
+			// The lowest candidate left after the whole block is its minimum.
+			uint64_t position = __builtin_ctzll(stack);
+			minimum[block] = numbers[start + position];
+			minimumPos[block] = (uint8_t)position;
+		}
+	});
+	stackMasks_ = FlatArray<uint64_t>(std::move(stackMasks));
+	minimum_ = FlatArray<Value>(std::move(minimum));
+	minimumPos_ = FlatArray<uint8_t>(std::move(minimumPos));
+}
+
+
+template class StackMaskBlocks<uint32_t>;
+template class StackMaskBlocks<uint32_t, std::greater<uint32_t>>;
+template class StackMaskBlocks<uint64_t>;
+template class StackMaskBlocks<uint64_t, std::greater<uint64_t>>;
+template class StackMaskBlocks<double>;
+template class StackMaskBlocks<double, std::greater<double>>;
\ No newline at end of file
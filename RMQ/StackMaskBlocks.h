@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "../Util/FlatArray.h"
+#include "../IO/Snapshot.h"
+
+/**
+The word sized blocks of LinearRMQ and the micro blocks of HierarchicalRMQ.
+The numbers are split into blocks of 64, one per bit of a word. For every position, a word marks the positions of its block on the stack of minima candidates,
+when the position has been pushed. The minimum of [min, max] within a block is the lowest marked position at or after min in the word of max.
+The minimum of every block and its position are kept as well, they are the numbers of the level above.
+With equal numbers, the leftmost position is returned.
+Value and Compare are instantiated for uint32_t, uint64_t and double, each with std::less and std::greater.
+*/
+template <typename Value, typename Compare = std::less<Value>>
+class StackMaskBlocks {
+
+public:
+	// Number of numbers in a block.
+	static const uint64_t BLOCK_SIZE = 64;
+
+private:
+
+	// For every position p, bit k is set if position k of the block of p is a minima candidate after pushing p. The bit of p itself is always set.
+	FlatArray<uint64_t> stackMasks_;
+
+	// The minimum of every block.
+	FlatArray<Value> minimum_;
+
+	// The position of the minimum of every block, relative to the block's beginning.
+	FlatArray<uint8_t> minimumPos_;
+
+public:
+
+	/**
+	* Answers a query within one block from the stack mask of max. It is defined here, so it is inlined into the queries of the levels above.
+	*/
+	uint64_t query(uint64_t min, uint64_t max) const {
+		// The candidates left of min are masked out. The bit of max is always set, so the mask is never empty.
+		uint64_t candidates = stackMasks_[max] & (~0ULL << (min % BLOCK_SIZE));
+		return max - max % BLOCK_SIZE + __builtin_ctzll(candidates);
+	}
+
+	uint64_t numBlocks() const {
+		return minimum_.size();
+	}
+
+	// The minima of all blocks.
+	const Value* minima() const {
+		return minimum_.data();
+	}
+
+	Value minimum(uint64_t block) const {
+		return minimum_[block];
+	}
+
+	// The position of the minimum of the block among all numbers.
+	uint64_t minimumPosition(uint64_t block) const {
+		return block * BLOCK_SIZE + minimumPos_[block];
+	}
+
+	/**
+	* Writes the stack masks, the block minima and their positions.
+	*/
+	void save(SnapshotWriter* writer) const;
+
+	/**
+	* Reads the arrays written by save(). They stay in the snapshot mapping. Marks the reader as invalid, if they do not fit the given size.
+	*
+	* @param reader The snapshot to read from.
+	* @param size The number of numbers the blocks were built on.
+	*/
+	void load(SnapshotReader* reader, uint64_t size);
+
+	StackMaskBlocks() {}
+
+	/**
+	* Computes the stack masks of all positions, and the minimum and its position of every block.
+	* Blocks are independent of each other, so they are split over the given number of threads.
+	*
+	* @param numbers The numbers. They are only read during construction.
+	* @param size The number of numbers.
+	* @param threads The number of threads used for construction. 0 uses all hardware threads.
+	* @param compare The order of the numbers.
+	*/
+	StackMaskBlocks(const Value* numbers, uint64_t size, uint64_t threads, Compare compare);
+};
\ No newline at end of file
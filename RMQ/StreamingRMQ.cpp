@@ -0,0 +1,212 @@
+#include "StreamingRMQ.h"
+#include "CartesianGenerator.h"
+#include "LogRMQ.h"
+#include "../Util/MinimumScan.h"
+
+template <typename Value, typename Compare>
+void StreamingRMQ<Value, Compare>::finalizeBlock(uint64_t blockNum) {
+	const Value* block = values_.data() + blockNum * blockSize_;
+	uint64_t position = minimumPosition(block, blockSize_, compare_);
+	blockMinimum_.edit().push_back(block[position]);
+	blockMinimumPos_.edit().push_back((uint8_t)position);
+	if (rows_.size() != rowSignatures_.size()) { // Loaded from a snapshot, the map is not part of it.
+		for (uint64_t r = 0; r < rowSignatures_.size(); r++) {
+			rows_[rowSignatures_[r]] = (uint32_t)r;
+		}
+	}
+	uint64_t signature = CartesianGenerator::signature(block, blockSize_, ballotNumbers_, compare_);
+	uint32_t row;
+	auto known = rows_.find(signature);
+	if (known != rows_.end()) {
+		row = known->second;
+	}
+	else {
+		row = (uint32_t)rowSignatures_.size();
+		rowSignatures_.edit().push_back(signature);
+		std::vector<uint8_t>& answers = inBlockAnswers_.edit();
+		answers.resize(answers.size() + blockSize_ * blockSize_);
+		CartesianGenerator::writeAnswerRow(block, blockSize_, answers.data() + row * blockSize_ * blockSize_, compare_);
+		rows_[signature] = row;
+	}
+	blockRows_.edit().push_back(row);
+	// The new block ends one more range of 2^l blocks on every layer that fits, which starts at blocks - 2^l.
+	// Its minimum combines the two halves from the layer below, which both exist already.
+	uint64_t blocks = blockNum + 1;
+	for (uint64_t l = 1; (1ULL << l) <= blocks; l++) {
+		if (layers_.size() < l) {
+			layers_.push_back(FlatArray<uint32_t>());
+		}
+		uint64_t start = blocks - (1ULL << l);
+		uint64_t half = 1ULL << (l - 1);
+		uint64_t p1 = l == 1 ? start : layers_[l - 2][start];
+		uint64_t p2 = l == 1 ? start + half : layers_[l - 2][start + half];
+		layers_[l - 1].edit().push_back((uint32_t)(compare_(blockMinimum_[p2], blockMinimum_[p1]) ? p2 : p1));
+	}
+}
+
+template <typename Value, typename Compare>
+uint64_t StreamingRMQ<Value, Compare>::blockRangeQuery(uint64_t min, uint64_t max) const {
+	uint64_t l = floorLog2(max - min + 1);
+	if (l == 0) {
+		return min;
+	}
+	uint64_t p1 = layers_[l - 1][min];
+	uint64_t p2 = layers_[l - 1][max - (1ULL << l) + 1];
+	return compare_(blockMinimum_[p2], blockMinimum_[p1]) ? p2 : p1;
+}
+
+template <typename Value, typename Compare>
+uint64_t StreamingRMQ<Value, Compare>::inBlockQuery(uint64_t blockNum, uint64_t min, uint64_t max) const {
+	return inBlockAnswers_[blockRows_[blockNum] * blockSize_ * blockSize_ + min * blockSize_ + max];
+}
+
+template <typename Value, typename Compare>
+void StreamingRMQ<Value, Compare>::append(Value value) {
+	values_.edit().push_back(value);
+	if (values_.size() % blockSize_ == 0) {
+		finalizeBlock(values_.size() / blockSize_ - 1);
+	}
+}
+
+template <typename Value, typename Compare>
+void StreamingRMQ<Value, Compare>::appendBatch(const Value* values, uint64_t count) {
+	std::vector<Value>& all = values_.edit();
+	all.insert(all.end(), values, values + count);
+	for (uint64_t b = blockMinimum_.size(); b < values_.size() / blockSize_; b++) {
+		finalizeBlock(b);
+	}
+}
+
+template <typename Value, typename Compare>
+uint64_t StreamingRMQ<Value, Compare>::rangeMinimumQuery(uint64_t min, uint64_t max) const {
+	const Value* values = values_.data();
+	uint64_t minBorder = min / blockSize_;
+	uint64_t maxBorder = max / blockSize_;
+	uint64_t blocks = blockMinimum_.size();
+	if (max - min < scanThreshold_ || (minBorder == maxBorder && minBorder == blocks)) { // Short, or only in the numbers after the last full block.
+		return min + minimumPosition(values + min, max - min + 1, compare_);
+	}
+	if (minBorder == maxBorder) {
+		return inBlockQuery(minBorder, min - blockSize_ * minBorder, max - blockSize_ * minBorder) + blockSize_ * minBorder;
+	}
+	// The subqueries are considered from left to right, and only a strictly smaller value replaces the minimum found so far, as in the CartesianRMQ.
+	uint64_t minimum = 0;
+	bool found = false;
+	auto consider = [&](uint64_t position) {
+		if (!found || compare_(values[position], values[minimum])) {
+			minimum = position;
+			found = true;
+		}
+	};
+	if (min != minBorder * blockSize_) {
+		consider(inBlockQuery(minBorder, min - blockSize_ * minBorder, blockSize_ - 1) + blockSize_ * minBorder);
+		minBorder++;
+	}
+	// maxBorder > minBorder before, so it can't underflow here.
+	uint64_t rightPos = 0;
+	bool hasRight = false;
+	if (maxBorder == blocks) { // The numbers after the last full block are scanned.
+		rightPos = blockSize_ * maxBorder + minimumPosition(values + blockSize_ * maxBorder, max - blockSize_ * maxBorder + 1, compare_);
+		hasRight = true;
+		maxBorder--;
+	}
+	else if (max + 1 != (maxBorder + 1) * blockSize_) {
+		rightPos = inBlockQuery(maxBorder, 0, max - blockSize_ * maxBorder) + blockSize_ * maxBorder;
+		hasRight = true;
+		maxBorder--;
+	}
+	if (minBorder <= maxBorder) {
+		uint64_t block = blockRangeQuery(minBorder, maxBorder);
+		consider(blockMinimumPos_[block] + block * blockSize_);
+	}
+	if (hasRight) {
+		consider(rightPos);
+	}
+	return minimum;
+}
+
+template <typename Value, typename Compare>
+void StreamingRMQ<Value, Compare>::rangeMinimumQueries(const std::pair<uint64_t, uint64_t>* queries, size_t n, uint64_t* out) const {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = rangeMinimumQuery(queries[i].first, queries[i].second);
+	}
+}
+
+template <typename Value, typename Compare>
+uint64_t StreamingRMQ<Value, Compare>::getSize() const {
+	return values_.size();
+}
+
+template <typename Value, typename Compare>
+void StreamingRMQ<Value, Compare>::setScanThreshold(uint64_t threshold) {
+	scanThreshold_ = threshold;
+}
+
+template <typename Value, typename Compare>
+StreamingRMQ<Value, Compare>::StreamingRMQ(uint64_t blockSize, Compare compare) :
+	compare_(compare),
+	blockSize_(blockSize == 0 ? defaultBlockSize_ : blockSize < maxBlockSize_ ? blockSize : maxBlockSize_) {
+	CartesianGenerator::fillBallotNumbers(&ballotNumbers_, blockSize_);
+}
+
+template <typename Value, typename Compare>
+bool StreamingRMQ<Value, Compare>::save(std::string path) const {
+	SnapshotWriter writer(path, SNAPSHOT_KIND_STREAMING_RMQ);
+	writer.writeValue(snapshotValueType<Value>());
+	writer.writeValue(blockSize_);
+	writer.writeArray(values_);
+	writer.writeArray(blockMinimum_);
+	writer.writeArray(blockMinimumPos_);
+	writer.writeArray(blockRows_);
+	writer.writeArray(rowSignatures_);
+	writer.writeArray(inBlockAnswers_);
+	writer.writeValue(layers_.size());
+	for (uint64_t l = 0; l < layers_.size(); l++) {
+		writer.writeArray(layers_[l]);
+	}
+	return writer.finish();
+}
+
+template <typename Value, typename Compare>
+StreamingRMQ<Value, Compare>* StreamingRMQ<Value, Compare>::load(std::string path, Compare compare) {
+	SnapshotReader reader(path, SNAPSHOT_KIND_STREAMING_RMQ);
+	if (reader.readValue() != snapshotValueType<Value>()) {
+		reader.invalidate();
+	}
+	uint64_t blockSize = reader.readValue();
+	if (blockSize == 0 || blockSize > maxBlockSize_) {
+		return nullptr;
+	}
+	StreamingRMQ* rmq = new StreamingRMQ(blockSize, compare);
+	rmq->values_ = reader.readArray<Value>();
+	rmq->blockMinimum_ = reader.readArray<Value>();
+	rmq->blockMinimumPos_ = reader.readArray<uint8_t>();
+	rmq->blockRows_ = reader.readArray<uint32_t>();
+	rmq->rowSignatures_ = reader.readArray<uint64_t>();
+	rmq->inBlockAnswers_ = reader.readArray<uint8_t>();
+	uint64_t blocks = rmq->blockMinimum_.size();
+	if (rmq->values_.size() / blockSize != blocks || rmq->blockMinimumPos_.size() != blocks || rmq->blockRows_.size() != blocks
+		|| rmq->inBlockAnswers_.size() != rmq->rowSignatures_.size() * blockSize * blockSize || reader.readValue() != (blocks == 0 ? 0 : floorLog2(blocks))) {
+		reader.invalidate();
+	}
+	for (uint64_t l = 1; reader.isValid() && (1ULL << l) <= blocks; l++) {
+		rmq->layers_.push_back(reader.readArray<uint32_t>());
+		if (rmq->layers_.back().size() != blocks - (1ULL << l) + 1) {
+			reader.invalidate();
+		}
+	}
+	if (!reader.isValid()) {
+		delete rmq;
+		return nullptr;
+	}
+	rmq->mapping_ = reader.getMapping();
+	return rmq;
+}
+
+
+template class StreamingRMQ<uint32_t>;
+template class StreamingRMQ<uint32_t, std::greater<uint32_t>>;
+template class StreamingRMQ<uint64_t>;
+template class StreamingRMQ<uint64_t, std::greater<uint64_t>>;
+template class StreamingRMQ<double>;
+template class StreamingRMQ<double, std::greater<double>>;
\ No newline at end of file
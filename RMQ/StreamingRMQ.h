@@ -0,0 +1,169 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <functional>
+#include "../Util/FlatArray.h"
+#include "../IO/MappedFile.h"
+#include "../IO/Snapshot.h"
+
+/**
+* Range minimum queries on an array that only grows at its end, without ever rebuilding what was built before.
+* The numbers are split into blocks of blockSize_ like in the CartesianRMQ. A block is finalized as soon as its last number arrives:
+* its minimum is stored, its cartesian tree signature is computed and blocks with the same signature share one row of in-block answers.
+* The block minima are covered by a sparse table, which is stored like the one of the LogRMQ, layer l holding the minimum of the 2^l blocks starting at every block.
+* A new block only adds the one entry per layer that ends with it, so the table grows without touching older entries.
+* Finalizing a block takes O(s^2) for a new signature and O(s + log(n / s)) else, so an append costs amortized O(1 + log(n / s) / s).
+* Queries ending in the numbers after the last full block scan these numbers, of which there are less than blockSize_.
+* Queries can be answered between any two appends, but appending must not happen at the same time as a query.
+* Value is the type of the numbers and Compare their order, instantiated like the CartesianRMQ.
+*/
+template <typename Value, typename Compare = std::less<Value>>
+class StreamingRMQ {
+
+private:
+
+	// All numbers appended so far, including the ones after the last full block.
+	FlatArray<Value> values_;
+
+	// The order of the numbers. It is not part of snapshots.
+	Compare compare_;
+
+	// Size of one block. It is fixed at construction, since the final number of values is unknown.
+	uint64_t blockSize_;
+
+	// Block size used if none is given. The Catalan number C_8 = 1430 bounds the rows to 90 KiB, while the sparse table costs at most 4 bytes per number.
+	static const uint64_t defaultBlockSize_ = 8;
+
+	// Largest possible block size, the same as for the CartesianRMQ.
+	static const uint64_t maxBlockSize_ = 32;
+
+	// The minimum of every full block.
+	FlatArray<Value> blockMinimum_;
+
+	// The position of the minimum of every full block, relative to the block's beginning.
+	FlatArray<uint8_t> blockMinimumPos_;
+
+	// The row in inBlockAnswers_ for every full block.
+	FlatArray<uint32_t> blockRows_;
+
+	// The signature of every row, so the rows of a loaded data structure are known again when appending.
+	FlatArray<uint64_t> rowSignatures_;
+
+	// The in-block answers of all rows, laid out like in the CartesianGenerator.
+	FlatArray<uint8_t> inBlockAnswers_;
+
+	// The row of every signature. Rebuilt from rowSignatures_ by the first append after loading.
+	std::unordered_map<uint64_t, uint32_t> rows_;
+
+	// Ballot numbers for blocks of blockSize_ numbers, see CartesianGenerator::fillBallotNumbers().
+	std::vector<uint64_t> ballotNumbers_;
+
+	/**
+	* The sparse table over the block minima, storing the block of the minimum.
+	* layers_[l - 1] holds layer l, where entry x is the block of the minimum of blocks [x, x + 2^l - 1]. Layer 0 is not stored, since its entries are just x.
+	*/
+	std::vector<FlatArray<uint32_t>> layers_;
+
+	// Default for scanThreshold_, the same as for the CartesianRMQ.
+	static const uint64_t defaultScanThreshold_ = 32;
+
+	// Queries over at most this many numbers scan the values directly. It is not part of snapshots.
+	uint64_t scanThreshold_ = defaultScanThreshold_;
+
+	// The snapshot the arrays point into, if the data structure was loaded. Empty for built ones.
+	std::shared_ptr<MappedFile> mapping_;
+
+	/**
+	* Finalizes the given block, whose numbers are all in values_ already: stores its minimum, assigns it a row and extends the sparse table by it.
+	*/
+	void finalizeBlock(uint64_t blockNum);
+
+	/**
+	* Returns the block of the minimum of the blocks [min, max], the left one on ties.
+	*/
+	uint64_t blockRangeQuery(uint64_t min, uint64_t max) const;
+
+	/**
+	* Answers a query within one full block. Returns the position relative to the block's beginning.
+	*/
+	uint64_t inBlockQuery(uint64_t blockNum, uint64_t min, uint64_t max) const;
+
+public:
+
+	/**
+	* Appends one number at the end.
+	*
+	* @param value The number to append.
+	*/
+	void append(Value value);
+
+	/**
+	* Appends count numbers at the end, in their order. All blocks getting full by them are finalized one after another.
+	*
+	* @param values The numbers to append.
+	* @param count The number of numbers to append.
+	*/
+	void appendBatch(const Value* values, uint64_t count);
+
+	/**
+	* Performs a range minimum query on the numbers appended so far in O(1).
+	* The query only reads the data structure, so it can be called from multiple threads at the same time, as long as nothing is appended.
+	*
+	* @param min The minimum range for the query.
+	* @param max The maximum range for the query. Has to be less than getSize().
+	* @return The position of the leftmost minimum.
+	*/
+	uint64_t rangeMinimumQuery(uint64_t min, uint64_t max) const;
+
+	/**
+	* Performs the range minimum query for all n queries and writes the answers into out.
+	*
+	* @param queries The ranges, each given as (min, max).
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	*/
+	void rangeMinimumQueries(const std::pair<uint64_t, uint64_t>* queries, size_t n, uint64_t* out) const;
+
+	/**
+	* Returns the number of numbers appended so far.
+	*/
+	uint64_t getSize() const;
+
+	/**
+	* Sets the length up to which queries scan the values directly instead of using the blocks. 0 never scans.
+	*/
+	void setScanThreshold(uint64_t threshold);
+
+	/**
+	* Constructs an empty data structure, which gets its numbers by append() and appendBatch().
+	*
+	* @param blockSize The numbers per block. 0 uses 8, larger sizes than 32 are reduced to 32.
+	* @param compare The order of the numbers.
+	*/
+	StreamingRMQ(uint64_t blockSize = 0, Compare compare = Compare());
+
+	/**
+	* Saves the data structure to a snapshot file (see IO/Snapshot.h).
+	* The layout is: the value type, block size, values, block minima and their positions, block rows, row signatures, in-block answers, number of layers and the layers.
+	* The order is not saved, so the snapshot has to be loaded with the Compare it was built with.
+	*
+	* @param path The snapshot file to write.
+	* @return false, if the snapshot could not be written.
+	*/
+	bool save(std::string path) const;
+
+	/**
+	* Loads a StreamingRMQ from a snapshot file written by save(). The arrays are used in place from the memory mapping.
+	* Appending to a loaded data structure works as well, but the first append copies the arrays out of the mapping.
+	*
+	* @param path The snapshot file to read.
+	* @param compare The order the data structure was built with.
+	* @return The loaded data structure, or nullptr if the file is no valid snapshot of a StreamingRMQ with this value type.
+	*/
+	static StreamingRMQ* load(std::string path, Compare compare = Compare());
+
+};
\ No newline at end of file
@@ -0,0 +1,404 @@
+#include "SuccinctRMQ.h"
+#include "../Util/Profile.h"
+#include <vector>
+#include <algorithm>
+#include <climits>
+
+// Sizes of the directories. A superblock has 8 words, a block 8 superblocks.
+const uint64_t SUPERBLOCK_WORDS = 8;
+const uint64_t BLOCK_SUPERBLOCKS = 8;
+const uint64_t SELECT_SAMPLE_RATE = 4096;
+
+/**
+* The excess changes of all 256 bytes, so 8 parentheses are handled at once.
+*/
+struct ByteExcess {
+	// Excess after all 8 bits.
+	int8_t total[256];
+
+	// Minimal excess after any of the 8 bits.
+	int8_t minimum[256];
+
+	// The last bit with the minimal excess.
+	uint8_t minimumPos[256];
+
+	// The bit of the (k+1)th set bit, for every k below the number of set bits.
+	uint8_t select[256][8];
+};
+
+ByteExcess buildByteExcess() {
+	ByteExcess table;
+	for (uint64_t byte = 0; byte < 256; byte++) {
+		int8_t excess = 0;
+		uint8_t ones = 0;
+		table.minimum[byte] = 8;
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			if ((byte >> bit) & 1) {
+				table.select[byte][ones] = bit;
+				ones++;
+			}
+			excess += (byte >> bit) & 1 ? 1 : -1;
+			if (excess <= table.minimum[byte]) {
+				table.minimum[byte] = excess;
+				table.minimumPos[byte] = bit;
+			}
+		}
+		table.total[byte] = excess;
+	}
+	return table;
+}
+
+const ByteExcess byteExcess = buildByteExcess();
+
+/**
+* Number of set bits of a word. Without the popcnt instruction, __builtin_popcountll is a library call, so the bits are counted in parallel instead.
+*/
+inline uint64_t countOnes(uint64_t word) {
+#ifdef __POPCNT__
+	return __builtin_popcountll(word);
+#else
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (word * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+/**
+* Excess change of a whole word.
+*/
+inline int64_t wordExcess(uint64_t word) {
+	return 2 * (int64_t)countOnes(word) - 64;
+}
+
+
+void SuccinctRMQ::buildDirectories(uint64_t threads) {
+	const uint64_t* bits = bits_.data();
+	uint64_t words = bits_.size();
+	std::vector<uint64_t> rankSamples((words + SUPERBLOCK_WORDS - 1) / SUPERBLOCK_WORDS);
+	std::vector<uint64_t> selectSamples;
+	selectSamples.reserve((size_ + SELECT_SAMPLE_RATE - 1) / SELECT_SAMPLE_RATE);
+	std::vector<int8_t> wordMinima(words);
+	std::vector<int16_t> superblockMinima(rankSamples.size(), SHRT_MAX);
+	std::vector<uint64_t> blockMinima((rankSamples.size() + BLOCK_SUPERBLOCKS - 1) / BLOCK_SUPERBLOCKS, ULLONG_MAX);
+	uint64_t ones = 0;
+	int64_t excess = 0;
+	for (uint64_t w = 0; w < words; w++) {
+		if (w % SUPERBLOCK_WORDS == 0) {
+			rankSamples[w / SUPERBLOCK_WORDS] = ones;
+		}
+		uint64_t count = countOnes(bits[w]);
+		while (selectSamples.size() * SELECT_SAMPLE_RATE < ones + count) {
+			selectSamples.push_back(w / SUPERBLOCK_WORDS);
+		}
+		ones += count;
+		int64_t inWord = 0;
+		int64_t minimum = 64;
+		for (uint64_t bit = 0; bit < 64; bit += 8) {
+			uint8_t byte = (uint8_t)(bits[w] >> bit);
+			minimum = std::min<int64_t>(minimum, inWord + byteExcess.minimum[byte]);
+			inWord += byteExcess.total[byte];
+		}
+		wordMinima[w] = (int8_t)minimum;
+		uint64_t superblock = w / SUPERBLOCK_WORDS;
+		int64_t inSuperblock = excess - (2 * (int64_t)rankSamples[superblock] - (int64_t)(superblock * SUPERBLOCK_WORDS * 64));
+		superblockMinima[superblock] = (int16_t)std::min<int64_t>(superblockMinima[superblock], inSuperblock + minimum);
+		// The excess never gets negative, since every closed parenthesis was opened before.
+		uint64_t block = superblock / BLOCK_SUPERBLOCKS;
+		blockMinima[block] = std::min(blockMinima[block], (uint64_t)(excess + minimum));
+		excess += inWord;
+	}
+	rankSamples_ = FlatArray<uint64_t>(std::move(rankSamples));
+	selectSamples_ = FlatArray<uint64_t>(std::move(selectSamples));
+	wordMinima_ = FlatArray<int8_t>(std::move(wordMinima));
+	superblockMinima_ = FlatArray<int16_t>(std::move(superblockMinima));
+	reversedBlockMinima_ = FlatArray<uint64_t>(std::vector<uint64_t>(blockMinima.rbegin(), blockMinima.rend()));
+	blockRMQ_ = new LogRMQ<uint64_t>(reversedBlockMinima_.data(), reversedBlockMinima_.size(), threads);
+}
+
+uint64_t SuccinctRMQ::rank(uint64_t position) const {
+	uint64_t word = position / 64;
+	uint64_t ones = rankSamples_[word / SUPERBLOCK_WORDS];
+	for (uint64_t w = word - word % SUPERBLOCK_WORDS; w < word; w++) {
+		ones += countOnes(bits_[w]);
+	}
+	uint64_t bit = position % 64;
+	uint64_t mask = bit == 63 ? ULLONG_MAX : (1ULL << (bit + 1)) - 1;
+	return ones + countOnes(bits_[word] & mask);
+}
+
+uint64_t SuccinctRMQ::select(uint64_t k) const {
+	// Binary search for the last superblock with at most k open parentheses in front of it, between the two samples around k.
+	uint64_t sample = k / SELECT_SAMPLE_RATE;
+	uint64_t low = selectSamples_[sample];
+	uint64_t high = sample + 1 < selectSamples_.size() ? selectSamples_[sample + 1] : rankSamples_.size() - 1;
+	while (low < high) {
+		uint64_t middle = low + (high - low + 1) / 2;
+		if (rankSamples_[middle] <= k) {
+			low = middle;
+		}
+		else {
+			high = middle - 1;
+		}
+	}
+	uint64_t remaining = k - rankSamples_[low];
+	uint64_t w = low * SUPERBLOCK_WORDS;
+	while (remaining >= (uint64_t)countOnes(bits_[w])) {
+		remaining -= countOnes(bits_[w]);
+		w++;
+	}
+	uint64_t word = bits_[w];
+	uint64_t bit = 0;
+	while (remaining >= (uint64_t)(byteExcess.total[(uint8_t)(word >> bit)] + 8) / 2) {
+		remaining -= (byteExcess.total[(uint8_t)(word >> bit)] + 8) / 2;
+		bit += 8;
+	}
+	return w * 64 + bit + byteExcess.select[(uint8_t)(word >> bit)][remaining];
+}
+
+int64_t SuccinctRMQ::excess(uint64_t position) const {
+	return 2 * (int64_t)rank(position) - (int64_t)(position + 1);
+}
+
+int64_t SuccinctRMQ::superblockExcess(uint64_t superblock) const {
+	return 2 * (int64_t)rankSamples_[superblock] - (int64_t)(superblock * SUPERBLOCK_WORDS * 64);
+}
+
+bool SuccinctRMQ::scanBits(uint64_t from, uint64_t to, int64_t* currentExcess, int64_t* best, uint64_t* position) const {
+	uint64_t word = bits_[from / 64];
+	uint64_t start = from - from % 64;
+	uint64_t last = to % 64;
+	// Local copies, so the loop does not go through memory in every step.
+	int64_t current = *currentExcess;
+	int64_t minimum = *best;
+	uint64_t minimumPos = *position;
+	bool found = false;
+	uint64_t bit = from % 64;
+	// The comparisons are written as selects, since their outcome is random for random numbers.
+	for (; bit <= last && bit % 8 != 0; bit++) {
+		current += 2 * (int64_t)((word >> bit) & 1) - 1;
+		bool better = current <= minimum;
+		minimum = better ? current : minimum;
+		minimumPos = better ? start + bit : minimumPos;
+		found |= better;
+	}
+	for (; bit + 7 <= last; bit += 8) {
+		uint8_t byte = (uint8_t)(word >> bit);
+		int64_t candidate = current + byteExcess.minimum[byte];
+		bool better = candidate <= minimum;
+		minimum = better ? candidate : minimum;
+		minimumPos = better ? start + bit + byteExcess.minimumPos[byte] : minimumPos;
+		found |= better;
+		current += byteExcess.total[byte];
+	}
+	for (; bit <= last; bit++) {
+		current += 2 * (int64_t)((word >> bit) & 1) - 1;
+		bool better = current <= minimum;
+		minimum = better ? current : minimum;
+		minimumPos = better ? start + bit : minimumPos;
+		found |= better;
+	}
+	*currentExcess = current;
+	*best = minimum;
+	*position = minimumPos;
+	return found;
+}
+
+uint64_t SuccinctRMQ::lastMinimum(uint64_t from, uint64_t to, int64_t excessBefore, int64_t* minimum) const {
+	const uint64_t NONE = ULLONG_MAX;
+	int64_t current = excessBefore;
+	int64_t best = LLONG_MAX;
+	uint64_t position = from;
+	uint64_t fromWord = from / 64;
+	uint64_t toWord = to / 64;
+	if (fromWord == toWord) {
+		scanBits(from, to, &current, &best, &position);
+		*minimum = best;
+		return position;
+	}
+	scanBits(from, fromWord * 64 + 63, &current, &best, &position);
+	// The word, superblock or block holding the best excess, if it is not resolved to a position yet. At most one of them is set.
+	uint64_t bestWord = NONE;
+	int64_t bestWordExcess = 0;
+	uint64_t bestSuperblock = NONE;
+	uint64_t bestBlock = NONE;
+	auto scanWords = [&](uint64_t first, uint64_t end) {
+		for (uint64_t w = first; w < end; w++) {
+			if (current + wordMinima_[w] <= best) {
+				best = current + wordMinima_[w];
+				bestWord = w;
+				bestWordExcess = current;
+				bestSuperblock = NONE;
+				bestBlock = NONE;
+			}
+			current += wordExcess(bits_[w]);
+		}
+	};
+	auto scanSuperblocks = [&](uint64_t first, uint64_t end) {
+		for (uint64_t superblock = first; superblock < end; superblock++) {
+			if (superblockExcess(superblock) + superblockMinima_[superblock] <= best) {
+				best = superblockExcess(superblock) + superblockMinima_[superblock];
+				bestSuperblock = superblock;
+				bestWord = NONE;
+				bestBlock = NONE;
+			}
+		}
+	};
+	// Whole words up to the next superblock, whole superblocks up to the next block, whole blocks, and the same way down again in front of toWord.
+	uint64_t wordsEnd = std::min(toWord, (fromWord + SUPERBLOCK_WORDS) / SUPERBLOCK_WORDS * SUPERBLOCK_WORDS);
+	scanWords(fromWord + 1, wordsEnd);
+	if (wordsEnd < toWord) {
+		uint64_t firstSuperblock = wordsEnd / SUPERBLOCK_WORDS;
+		uint64_t endSuperblock = toWord / SUPERBLOCK_WORDS;
+		uint64_t superblocksEnd = std::min(endSuperblock, (firstSuperblock + BLOCK_SUPERBLOCKS - 1) / BLOCK_SUPERBLOCKS * BLOCK_SUPERBLOCKS);
+		scanSuperblocks(firstSuperblock, superblocksEnd);
+		if (superblocksEnd < endSuperblock) {
+			uint64_t firstBlock = superblocksEnd / BLOCK_SUPERBLOCKS;
+			uint64_t endBlock = endSuperblock / BLOCK_SUPERBLOCKS;
+			if (firstBlock < endBlock) {
+				uint64_t blockCount = reversedBlockMinima_.size();
+				uint64_t reversed = blockRMQ_->rangeMinimumQuery(blockCount - endBlock, blockCount - 1 - firstBlock);
+				if ((int64_t)reversedBlockMinima_[reversed] <= best) {
+					best = (int64_t)reversedBlockMinima_[reversed];
+					bestBlock = blockCount - 1 - reversed;
+					bestWord = NONE;
+					bestSuperblock = NONE;
+				}
+			}
+			scanSuperblocks(endBlock * BLOCK_SUPERBLOCKS, endSuperblock);
+		}
+		current = superblockExcess(endSuperblock);
+		scanWords(endSuperblock * SUPERBLOCK_WORDS, toWord);
+	}
+	if (scanBits(toWord * 64, to, &current, &best, &position)) {
+		bestWord = NONE;
+		bestSuperblock = NONE;
+		bestBlock = NONE;
+	}
+	// Resolve the best block to its last superblock reaching the minimum, then the superblock to its last word and the word to its last bit.
+	if (bestBlock != NONE) {
+		for (uint64_t superblock = bestBlock * BLOCK_SUPERBLOCKS; superblock < (bestBlock + 1) * BLOCK_SUPERBLOCKS; superblock++) {
+			if (superblockExcess(superblock) + superblockMinima_[superblock] == best) {
+				bestSuperblock = superblock;
+			}
+		}
+	}
+	if (bestSuperblock != NONE) {
+		int64_t wordStart = superblockExcess(bestSuperblock);
+		for (uint64_t w = bestSuperblock * SUPERBLOCK_WORDS; w < (bestSuperblock + 1) * SUPERBLOCK_WORDS; w++) {
+			if (wordStart + wordMinima_[w] == best) {
+				bestWord = w;
+				bestWordExcess = wordStart;
+			}
+			wordStart += wordExcess(bits_[w]);
+		}
+	}
+	if (bestWord != NONE) {
+		scanBits(bestWord * 64, bestWord * 64 + 63, &bestWordExcess, &best, &position);
+	}
+	*minimum = best;
+	return position;
+}
+
+uint64_t SuccinctRMQ::rangeMinimumQuery(uint64_t min, uint64_t max) const {
+	if (min >= max) {
+		return min;
+	}
+	uint64_t open = select(min);
+	// In front of the open parenthesis are min open parentheses, the others are closed ones.
+	int64_t excessBefore = 2 * (int64_t)min - (int64_t)open;
+	int64_t minimum;
+	uint64_t position = lastMinimum(open, select(max), excessBefore, &minimum);
+	if (minimum == excessBefore + 1) {
+		return min;
+	}
+	// position is directly in front of the open parenthesis of the minimum, so the number of open parentheses up to it is the index of the minimum.
+	return rank(position);
+}
+
+void SuccinctRMQ::rangeMinimumQueries(const std::pair<uint64_t, uint64_t>* queries, size_t n, uint64_t* out) const {
+	for (size_t i = 0; i < n; i++) {
+		if (i + prefetchDistance_ < n) {
+			__builtin_prefetch(selectSamples_.data() + queries[i + prefetchDistance_].first / SELECT_SAMPLE_RATE);
+			__builtin_prefetch(selectSamples_.data() + queries[i + prefetchDistance_].second / SELECT_SAMPLE_RATE);
+		}
+		out[i] = rangeMinimumQuery(queries[i].first, queries[i].second);
+	}
+}
+
+bool SuccinctRMQ::save(std::string path) const {
+	SnapshotWriter writer(path, SNAPSHOT_KIND_SUCCINCT_RMQ);
+	writer.writeValue(size_);
+	writer.writeValue(bitCount_);
+	writer.writeArray(bits_);
+	writer.writeArray(rankSamples_);
+	writer.writeArray(selectSamples_);
+	writer.writeArray(wordMinima_);
+	writer.writeArray(superblockMinima_);
+	writer.writeArray(reversedBlockMinima_);
+	blockRMQ_->save(&writer);
+	return writer.finish();
+}
+
+SuccinctRMQ* SuccinctRMQ::load(std::string path) {
+	SnapshotReader reader(path, SNAPSHOT_KIND_SUCCINCT_RMQ);
+	SuccinctRMQ* rmq = new SuccinctRMQ();
+	rmq->size_ = reader.readValue();
+	rmq->bitCount_ = reader.readValue();
+	rmq->bits_ = reader.readArray<uint64_t>();
+	rmq->rankSamples_ = reader.readArray<uint64_t>();
+	rmq->selectSamples_ = reader.readArray<uint64_t>();
+	rmq->wordMinima_ = reader.readArray<int8_t>();
+	rmq->superblockMinima_ = reader.readArray<int16_t>();
+	rmq->reversedBlockMinima_ = reader.readArray<uint64_t>();
+	uint64_t words = rmq->bits_.size();
+	if (rmq->bitCount_ < rmq->size_ || rmq->bitCount_ / 2 > rmq->size_ || words != (rmq->bitCount_ + 63) / 64
+		|| rmq->rankSamples_.size() != (words + SUPERBLOCK_WORDS - 1) / SUPERBLOCK_WORDS || rmq->selectSamples_.size() != (rmq->size_ + SELECT_SAMPLE_RATE - 1) / SELECT_SAMPLE_RATE
+		|| rmq->wordMinima_.size() != words || rmq->superblockMinima_.size() != rmq->rankSamples_.size()
+		|| rmq->reversedBlockMinima_.size() != (rmq->rankSamples_.size() + BLOCK_SUPERBLOCKS - 1) / BLOCK_SUPERBLOCKS) {
+		reader.invalidate();
+	}
+	if (reader.isValid()) {
+		rmq->blockRMQ_ = LogRMQ<uint64_t>::load(&reader, rmq->reversedBlockMinima_.data(), rmq->reversedBlockMinima_.size());
+	}
+	if (!reader.isValid()) {
+		delete rmq;
+		return nullptr;
+	}
+	rmq->mapping_ = reader.getMapping();
+	return rmq;
+}
+
+SuccinctRMQ::SuccinctRMQ(const uint64_t* numbers, uint64_t size, uint64_t threads) :
+	size_(size) {
+	beginPhase("parentheses");
+	// Every number opens one parenthesis and closes at most one, when it is removed from the stack.
+	std::vector<uint64_t> bits((2 * size + 63) / 64, 0);
+	std::vector<uint64_t> stack;
+	uint64_t position = 0;
+	for (uint64_t i = 0; i < size; i++) {
+		// Equal numbers stay on the stack, so the leftmost of them is found.
+		while (!stack.empty() && numbers[stack.back()] > numbers[i]) {
+			stack.pop_back();
+			position++;
+		}
+		bits[position / 64] |= 1ULL << (position % 64);
+		position++;
+		stack.push_back(i);
+	}
+	bitCount_ = position;
+	bits.resize((bitCount_ + 63) / 64);
+	bits.shrink_to_fit();
+	if (bitCount_ % 64 != 0) {
+		bits.back() |= ULLONG_MAX << (bitCount_ % 64);
+	}
+	bits_ = FlatArray<uint64_t>(std::move(bits));
+	endPhase();
+	beginPhase("directories");
+	buildDirectories(threads);
+	endPhase();
+}
+
+SuccinctRMQ::~SuccinctRMQ() {
+	delete blockRMQ_;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include "LogRMQ.h"
+#include "../Util/FlatArray.h"
+#include "../IO/MappedFile.h"
+
+/**
+Class for processing rmq queries with 2n + o(n) bits, without keeping the numbers.
+The numbers are encoded as balanced parentheses: going from left to right, every number first closes one parenthesis for every larger number it removes from a stack of minima candidates,
+then it opens its own parenthesis and is pushed onto the stack. The excess of a position is its number of opened minus closed parentheses, so it is the size of the stack.
+The minimum of [min, max] is the lowest stack entry above all entries left of min, when max has been pushed. Let c be the number of these entries left of min.
+If the minimum is min itself, the excess between the open parentheses of min and max never falls below c + 1.
+Else the excess between them falls to c, and the open parenthesis of the minimum directly follows the rightmost position with excess c.
+So a query needs select on the open parentheses, the rightmost minimal excess in a range and rank, which all use small directories on top of the parentheses.
+With equal numbers, the leftmost position is returned, just as for CartesianRMQ.
+n is the number of numbers.
+*/
+class SuccinctRMQ {
+
+private:
+
+	// The parentheses, 64 in a word starting with the lowest bit. An open parenthesis is a 1. The bits after the last parenthesis are set, so they never lower a minimum.
+	FlatArray<uint64_t> bits_;
+
+	// Number of numbers.
+	uint64_t size_ = 0;
+
+	// Number of parentheses. The closing parentheses of the numbers left on the stack at the end are never needed, so they are not stored.
+	uint64_t bitCount_ = 0;
+
+	// Number of open parentheses in front of every superblock of 8 words.
+	FlatArray<uint64_t> rankSamples_;
+
+	// The superblock of every 4096th open parenthesis. select() only has to search the superblocks between two samples.
+	FlatArray<uint64_t> selectSamples_;
+
+	// The minimal excess after any bit of a word, relative to the excess in front of the word.
+	FlatArray<int8_t> wordMinima_;
+
+	// The minimal excess after any bit of a superblock, relative to the excess in front of the superblock.
+	FlatArray<int16_t> superblockMinima_;
+
+	// The minimal excess after any bit of a block of 8 superblocks, last block first. LogRMQ prefers the left one of equal minima, so reversing the blocks finds the rightmost one.
+	FlatArray<uint64_t> reversedBlockMinima_;
+
+	// A log rmq data structure to find the rightmost minimal block of multiple entire blocks.
+	LogRMQ<uint64_t>* blockRMQ_ = nullptr;
+
+	// How many queries ahead rangeMinimumQueries() prefetches the select samples.
+	static const size_t prefetchDistance_ = 8;
+
+	// The snapshot the arrays point into, if the data structure was loaded. Empty for built ones.
+	std::shared_ptr<MappedFile> mapping_;
+
+	/**
+	* Fills the rank and select samples, the word minima and the block minima for the parentheses in bits_.
+	*/
+	void buildDirectories(uint64_t threads);
+
+	/**
+	* Returns the number of open parentheses in [0, position].
+	*/
+	uint64_t rank(uint64_t position) const;
+
+	/**
+	* Returns the position of the open parenthesis of number k, which is the (k+1)th open parenthesis.
+	*/
+	uint64_t select(uint64_t k) const;
+
+	/**
+	* Returns the excess after the given position.
+	*/
+	int64_t excess(uint64_t position) const;
+
+	/**
+	* Returns the excess in front of the given superblock, which only needs its rank sample.
+	*/
+	int64_t superblockExcess(uint64_t superblock) const;
+
+	/**
+	* Goes through the bits [from, to] of a single word and updates the excess after every bit.
+	* If an excess is at most *best, it becomes the new best and its position is saved.
+	* Whole bytes are handled with one table lookup.
+	* Returns true, if a new best was found.
+	*/
+	bool scanBits(uint64_t from, uint64_t to, int64_t* currentExcess, int64_t* best, uint64_t* position) const;
+
+	/**
+	* Returns the rightmost position in [from, to] with the minimal excess and saves that excess in minimum. excessBefore is the excess in front of from.
+	* The range is split into bits at both ends, then whole words, whole superblocks and whole blocks towards the middle, so at most 7 words and 7 superblocks are scanned at each end.
+	* Words, superblocks and blocks are only resolved to a position, if they hold the final minimum.
+	*/
+	uint64_t lastMinimum(uint64_t from, uint64_t to, int64_t excessBefore, int64_t* minimum) const;
+
+	SuccinctRMQ() {}
+
+public:
+
+	/**
+	* Performs a range minimum query.
+	* The query only reads the data structure, so it can be called from multiple threads at the same time.
+	*
+	* @param min The minimum range for the query.
+	* @param max The maximum range for the query.
+	*/
+	uint64_t rangeMinimumQuery(uint64_t min, uint64_t max) const;
+
+	/**
+	* Performs the range minimum query for all n queries and writes the answers into out.
+	* The select samples of upcoming queries are prefetched, the rest of a query mostly stays within a few cache lines of the parentheses.
+	*
+	* @param queries The ranges, each given as (min, max).
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	*/
+	void rangeMinimumQueries(const std::pair<uint64_t, uint64_t>* queries, size_t n, uint64_t* out) const;
+
+	/**
+	* Saves the data structure to a snapshot file (see IO/Snapshot.h).
+	* The layout is: sizes, parentheses, rank and select samples, word, superblock and block minima and the LogRMQ.
+	*
+	* @param path The snapshot file to write.
+	* @return True, if the whole snapshot was written.
+	*/
+	bool save(std::string path) const;
+
+	/**
+	* Loads a data structure written by save(). The arrays stay in the memory mapping of the snapshot.
+	*
+	* @param path The snapshot file to read.
+	* @return The loaded data structure, or nullptr if the file is missing, of another kind or its sizes do not fit together.
+	*/
+	static SuccinctRMQ* load(std::string path);
+
+	/**
+	* Constructs the parentheses of the numbers and their directories.
+	* The numbers are only read during construction.
+	*
+	* @param numbers The numbers to perform later queries on.
+	* @param size The number of numbers.
+	* @param threads The number of threads used for the block rmq. 0 uses all hardware threads. The parentheses are built in one pass.
+	*/
+	SuccinctRMQ(const uint64_t* numbers, uint64_t size, uint64_t threads = 1);
+
+	/**
+	* Deconstructor for the SuccinctRMQ class.
+	* Needed because the class allocates heap space.
+	*/
+	~SuccinctRMQ();
+};
\ No newline at end of file
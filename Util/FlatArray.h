@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+* Contiguous array, which either owns its elements in a vector, or is a read only view on memory owned by someone else.
+* Views are used for data structures loaded from a memory mapped snapshot, so loading never copies the elements.
+* Copying a view only copies the pointer, so the viewed memory has to outlive all copies.
+*/
+template <typename T>
+class FlatArray {
+
+private:
+	// The elements, if this array owns them.
+	std::vector<T> owned_;
+
+	// The viewed elements, or nullptr if this array owns its elements.
+	const T* view_ = nullptr;
+
+	// Number of viewed elements. Unused for owning arrays.
+	uint64_t viewSize_ = 0;
+
+public:
+	const T* data() const {
+		return view_ != nullptr ? view_ : owned_.data();
+	}
+
+	uint64_t size() const {
+		return view_ != nullptr ? viewSize_ : owned_.size();
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	const T& operator[](uint64_t index) const {
+		return data()[index];
+	}
+
+	/**
+	* Returns the owned vector for modification. A view gets copied into an owned vector first.
+	*/
+	std::vector<T>& edit() {
+		if (view_ != nullptr) {
+			owned_.assign(view_, view_ + viewSize_);
+			view_ = nullptr;
+			viewSize_ = 0;
+		}
+		return owned_;
+	}
+
+	FlatArray() {}
+
+	/**
+	* Takes over the elements of the given vector.
+	*/
+	FlatArray(std::vector<T>&& values) :
+		owned_(std::move(values)) {}
+
+	/**
+	* Creates a view on size elements at data.
+	*/
+	FlatArray(const T* data, uint64_t size) :
+		view_(size > 0 ? data : nullptr),
+		viewSize_(size) {}
+};
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "MinimumScan.h"
+#if defined(__x86_64__) || defined(__i386__)
+#define MINIMUM_SCAN_AVX2
+#include <immintrin.h>
+#endif
+
+
+template <typename Value, typename Compare>
+uint64_t scalarMinimumPosition(const Value* numbers, uint64_t length, Compare compare) {
+	uint64_t position = 0;
+	for (uint64_t i = 1; i < length; i++) {
+		if (compare(numbers[i], numbers[position])) {
+			position = i;
+		}
+	}
+	return position;
+}
+
+
+template <typename Value, typename Compare>
+void scalarBlockMinima(const Value* numbers, uint64_t blocks, uint64_t blockSize, Value* minima, uint8_t* positions, Compare compare) {
+	for (uint64_t i = 0; i < blocks; i++) {
+		uint64_t position = scalarMinimumPosition(numbers + i * blockSize, blockSize, compare);
+		minima[i] = numbers[i * blockSize + position];
+		positions[i] = (uint8_t)position;
+	}
+}
+
+/**
+* AVX2 only compares signed 64 bit numbers. Flipping the highest bit maps the unsigned order onto the signed one,
+* flipping all other bits maps the reversed order of std::greater onto it. Flipping twice gives back the number.
+*/
+const uint64_t LESS_FLIP = 1ULL << 63;
+const uint64_t GREATER_FLIP = ~(1ULL << 63);
+
+#ifdef MINIMUM_SCAN_AVX2
+
+__attribute__((target("avx2")))
+inline __m256i toSigned(__m256i numbers, __m256i flip) {
+	return _mm256_xor_si256(numbers, flip);
+}
+
+
+/**
+* Finds the minimum with 4 lanes first, then the first position holding it.
+* Both passes load the last 4 numbers once more instead of handling a remainder, which is fine, since a minimum stays a minimum.
+*/
+template <typename Compare>
+__attribute__((target("avx2")))
+uint64_t avx2MinimumPosition(const uint64_t* numbers, uint64_t length, Compare compare, uint64_t flipBits) {
+	if (length < 4) {
+		return scalarMinimumPosition(numbers, length, compare);
+	}
+	__m256i flip = _mm256_set1_epi64x((long long)flipBits);
+	// Four independent minima, so the compares of consecutive loads do not wait on each other.
+	__m256i minima[4];
+	for (uint64_t k = 0; k < 4; k++) {
+		minima[k] = toSigned(_mm256_loadu_si256((const __m256i*)numbers), flip);
+	}
+	uint64_t i = 4;
+	for (; i + 16 <= length; i += 16) {
+		for (uint64_t k = 0; k < 4; k++) {
+			__m256i current = toSigned(_mm256_loadu_si256((const __m256i*)(numbers + i + 4 * k)), flip);
+			minima[k] = _mm256_blendv_epi8(minima[k], current, _mm256_cmpgt_epi64(minima[k], current));
+		}
+	}
+	for (; i < length; i += 4) {
+		uint64_t start = i + 4 <= length ? i : length - 4;
+		__m256i current = toSigned(_mm256_loadu_si256((const __m256i*)(numbers + start)), flip);
+		minima[0] = _mm256_blendv_epi8(minima[0], current, _mm256_cmpgt_epi64(minima[0], current));
+	}
+	for (uint64_t k = 1; k < 4; k++) {
+		minima[0] = _mm256_blendv_epi8(minima[0], minima[k], _mm256_cmpgt_epi64(minima[0], minima[k]));
+	}
+	// Reduce the 4 lanes in the register: swap the halves first, then the lanes within the halves.
+	__m256i minimum = minima[0];
+	__m256i swapped = _mm256_permute4x64_epi64(minimum, 0x4E);
+	minimum = _mm256_blendv_epi8(minimum, swapped, _mm256_cmpgt_epi64(minimum, swapped));
+	swapped = _mm256_shuffle_epi32(minimum, 0x4E);
+	minimum = _mm256_blendv_epi8(minimum, swapped, _mm256_cmpgt_epi64(minimum, swapped));
+	// The equal positions of 64 numbers are collected in one mask, so there is only one unpredictable branch per 64 numbers.
+	__m256i searched = toSigned(minimum, flip);
+	for (uint64_t base = 0;; base += 64) {
+		uint64_t end = base + 64 < length ? base + 64 : length;
+		uint64_t mask = 0;
+		for (uint64_t i = base; i < end; i += 4) {
+			uint64_t start = i + 4 <= length ? i : length - 4;
+			__m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(numbers + start)), searched);
+			uint64_t bits = (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(equal));
+			mask |= start >= base ? bits << (start - base) : bits >> (base - start);
+		}
+		if (mask != 0) {
+			return base + __builtin_ctzll(mask);
+		}
+	}
+}
+
+
+/**
+* Scans 4 blocks at once, lane k holds block i + k. The j-th number of all 4 blocks is gathered with the block size as stride.
+*/
+template <typename Compare>
+__attribute__((target("avx2")))
+void avx2BlockMinima(const uint64_t* numbers, uint64_t blocks, uint64_t blockSize, uint64_t* minima, uint8_t* positions, Compare compare, uint64_t flipBits) {
+	__m256i flip = _mm256_set1_epi64x((long long)flipBits);
+	__m256i strides = _mm256_set_epi64x(3 * (long long)blockSize, 2 * (long long)blockSize, (long long)blockSize, 0);
+	uint64_t i = 0;
+	for (; i + 4 <= blocks; i += 4) {
+		const long long* block = (const long long*)(numbers + i * blockSize);
+		__m256i minimum = toSigned(_mm256_i64gather_epi64(block, strides, 8), flip);
+		__m256i position = _mm256_setzero_si256();
+		for (uint64_t j = 1; j < blockSize; j++) {
+			__m256i current = toSigned(_mm256_i64gather_epi64(block + j, strides, 8), flip);
+			__m256i less = _mm256_cmpgt_epi64(minimum, current); // Only strictly smaller numbers replace the minimum, so the leftmost one stays.
+			minimum = _mm256_blendv_epi8(minimum, current, less);
+			position = _mm256_blendv_epi8(position, _mm256_set1_epi64x((long long)j), less);
+		}
+		alignas(32) uint64_t lanes[4];
+		alignas(32) uint64_t lanePositions[4];
+		_mm256_store_si256((__m256i*)lanes, toSigned(minimum, flip));
+		_mm256_store_si256((__m256i*)lanePositions, position);
+		for (uint64_t lane = 0; lane < 4; lane++) {
+			minima[i + lane] = lanes[lane];
+			positions[i + lane] = (uint8_t)lanePositions[lane];
+		}
+	}
+	scalarBlockMinima(numbers + i * blockSize, blocks - i, blockSize, minima + i, positions + i, compare);
+}
+
+
+bool hasAvx2() {
+	__builtin_cpu_init(); // Needed, since this runs during static initialization.
+	return __builtin_cpu_supports("avx2");
+}
+
+const bool useAvx2 = hasAvx2();
+
+#endif
+
+
+/**
+* The scans for all orders without a vectorized version.
+*/
+template <typename Value, typename Compare>
+uint64_t dispatchMinimumPosition(const Value* numbers, uint64_t length, Compare compare) {
+	return scalarMinimumPosition(numbers, length, compare);
+}
+
+template <typename Value, typename Compare>
+void dispatchBlockMinima(const Value* numbers, uint64_t blocks, uint64_t blockSize, Value* minima, uint8_t* positions, Compare compare) {
+	scalarBlockMinima(numbers, blocks, blockSize, minima, positions, compare);
+}
+
+
+/**
+* The scans for 64 bit unsigned numbers. Overload resolution prefers these to the templates above.
+*/
+template <typename Compare>
+uint64_t vectorMinimumPosition(const uint64_t* numbers, uint64_t length, Compare compare, uint64_t flipBits) {
+#ifdef MINIMUM_SCAN_AVX2
+	if (useAvx2) {
+		return avx2MinimumPosition(numbers, length, compare, flipBits);
+	}
+#else
+	(void)flipBits;
+#endif
+	return scalarMinimumPosition(numbers, length, compare);
+}
+
+template <typename Compare>
+void vectorBlockMinima(const uint64_t* numbers, uint64_t blocks, uint64_t blockSize, uint64_t* minima, uint8_t* positions, Compare compare, uint64_t flipBits) {
+#ifdef MINIMUM_SCAN_AVX2
+	if (useAvx2) {
+		avx2BlockMinima(numbers, blocks, blockSize, minima, positions, compare, flipBits);
+		return;
+	}
+#else
+	(void)flipBits;
+#endif
+	scalarBlockMinima(numbers, blocks, blockSize, minima, positions, compare);
+}
+
+uint64_t dispatchMinimumPosition(const uint64_t* numbers, uint64_t length, std::less<uint64_t> compare) {
+	return vectorMinimumPosition(numbers, length, compare, LESS_FLIP);
+}
+
+uint64_t dispatchMinimumPosition(const uint64_t* numbers, uint64_t length, std::greater<uint64_t> compare) {
+	return vectorMinimumPosition(numbers, length, compare, GREATER_FLIP);
+}
+
+void dispatchBlockMinima(const uint64_t* numbers, uint64_t blocks, uint64_t blockSize, uint64_t* minima, uint8_t* positions, std::less<uint64_t> compare) {
+	vectorBlockMinima(numbers, blocks, blockSize, minima, positions, compare, LESS_FLIP);
+}
+
+void dispatchBlockMinima(const uint64_t* numbers, uint64_t blocks, uint64_t blockSize, uint64_t* minima, uint8_t* positions, std::greater<uint64_t> compare) {
+	vectorBlockMinima(numbers, blocks, blockSize, minima, positions, compare, GREATER_FLIP);
+}
+
+
+template <typename Value, typename Compare>
+uint64_t minimumPosition(const Value* numbers, uint64_t length, Compare compare) {
+	return dispatchMinimumPosition(numbers, length, compare);
+}
+
+
+template <typename Value, typename Compare>
+void blockMinima(const Value* numbers, uint64_t blocks, uint64_t blockSize, Value* minima, uint8_t* positions, Compare compare) {
+	dispatchBlockMinima(numbers, blocks, blockSize, minima, positions, compare);
+}
+
+
+template uint64_t minimumPosition(const uint32_t*, uint64_t, std::less<uint32_t>);
+template uint64_t minimumPosition(const uint32_t*, uint64_t, std::greater<uint32_t>);
+template uint64_t minimumPosition(const uint64_t*, uint64_t, std::less<uint64_t>);
+template uint64_t minimumPosition(const uint64_t*, uint64_t, std::greater<uint64_t>);
+template uint64_t minimumPosition(const double*, uint64_t, std::less<double>);
+template uint64_t minimumPosition(const double*, uint64_t, std::greater<double>);
+template void blockMinima(const uint32_t*, uint64_t, uint64_t, uint32_t*, uint8_t*, std::less<uint32_t>);
+template void blockMinima(const uint32_t*, uint64_t, uint64_t, uint32_t*, uint8_t*, std::greater<uint32_t>);
+template void blockMinima(const uint64_t*, uint64_t, uint64_t, uint64_t*, uint8_t*, std::less<uint64_t>);
+template void blockMinima(const uint64_t*, uint64_t, uint64_t, uint64_t*, uint8_t*, std::greater<uint64_t>);
+template void blockMinima(const double*, uint64_t, uint64_t, double*, uint8_t*, std::less<double>);
+template void blockMinima(const double*, uint64_t, uint64_t, double*, uint8_t*, std::greater<double>);
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+/**
+* Linear scans for minima over raw numbers, ordered by Compare.
+* For 64 bit unsigned numbers ordered by std::less or std::greater, 4 numbers are compared at once on x86 processors with AVX2.
+* The instruction set is detected when the program starts, so the program still runs on older processors.
+* Equal numbers always resolve to the leftmost position.
+* Value and Compare are instantiated for uint32_t, uint64_t and double, each with std::less and std::greater.
+*/
+
+/**
+* Returns the position of the leftmost minimum of the given numbers, relative to numbers.
+*
+* @param numbers The first number to scan.
+* @param length The number of numbers to scan. Has to be at least 1.
+* @param compare The order of the numbers. The minimum is the number no other number compares less than.
+*/
+template <typename Value, typename Compare = std::less<Value>>
+uint64_t minimumPosition(const Value* numbers, uint64_t length, Compare compare = Compare());
+
+/**
+* Finds the minimum and its leftmost position for each of the given blocks, which follow each other in numbers.
+* With AVX2, 4 blocks are scanned at once, so short blocks work as well as long ones.
+*
+* @param numbers The first number of the first block.
+* @param blocks The number of blocks.
+* @param blockSize The number of numbers per block. Has to be between 1 and 256, so the positions fit into a byte.
+* @param minima Gets the minimum of every block.
+* @param positions Gets the position of the minimum of every block, relative to the block start.
+* @param compare The order of the numbers.
+*/
+template <typename Value, typename Compare = std::less<Value>>
+void blockMinima(const Value* numbers, uint64_t blocks, uint64_t blockSize, Value* minima, uint8_t* positions, Compare compare = Compare());
\ No newline at end of file
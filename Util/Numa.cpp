@@ -0,0 +1,85 @@
+#include "Numa.h"
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+
+/**
+* Parses a cpu list like "0-3,8,10-11".
+*/
+std::vector<int> parseCpuList(const std::string& list) {
+	std::vector<int> cpus;
+	size_t position = 0;
+	while (position < list.size()) {
+		size_t end = list.find(',', position);
+		if (end == std::string::npos) {
+			end = list.size();
+		}
+		std::string range = list.substr(position, end - position);
+		size_t dash = range.find('-');
+		int first = std::atoi(range.c_str());
+		int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+		for (int cpu = first; cpu <= last; cpu++) {
+			cpus.push_back(cpu);
+		}
+		position = end + 1;
+	}
+	return cpus;
+}
+
+
+std::vector<std::vector<int>> numaNodes() {
+	std::vector<std::vector<int>> nodes;
+	// Node numbers are dense on all machines we know of, so the first missing one ends the list.
+	for (int node = 0; ; node++) {
+		std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+		std::string list;
+		if (!std::getline(file, list)) {
+			break;
+		}
+		nodes.push_back(parseCpuList(list));
+	}
+	if (nodes.empty()) {
+		nodes.push_back(std::vector<int>());
+	}
+	return nodes;
+}
+
+
+std::vector<int> threadCpus() {
+	std::vector<int> cpus;
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &set)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+#endif
+	return cpus;
+}
+
+
+bool pinThread(const std::vector<int>& cpus) {
+	if (cpus.empty()) {
+		return false;
+	}
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : cpus) {
+		if (cpu >= 0 && cpu < CPU_SETSIZE) {
+			CPU_SET(cpu, &set);
+		}
+	}
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+
+/**
+* Returns the cpus of every NUMA node of the machine, read from /sys/devices/system/node on Linux.
+* If the nodes can not be read, there is a single node with no cpus, on which pinning does nothing.
+*/
+std::vector<std::vector<int>> numaNodes();
+
+/**
+* Returns the cpus the calling thread may run on, so they can be restored after pinning it. Empty if they can not be read.
+*/
+std::vector<int> threadCpus();
+
+/**
+* Restricts the calling thread to the given cpus. Memory the thread touches first is then allocated on their node.
+* Returns false, if the cpus are empty or the thread could not be pinned.
+*/
+bool pinThread(const std::vector<int>& cpus);
\ No newline at end of file
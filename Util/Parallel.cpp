@@ -0,0 +1,39 @@
+#include "Parallel.h"
+#include <thread>
+#include <vector>
+
+
+uint64_t resolveThreads(uint64_t threads) {
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+	return threads == 0 ? 1 : threads; // hardware_concurrency() may return 0 if it can't tell.
+}
+
+
+void parallelFor(uint64_t n, uint64_t threads, const std::function<void(uint64_t begin, uint64_t end)>& work) {
+	threads = resolveThreads(threads);
+	if (threads > n) {
+		threads = n;
+	}
+	if (threads <= 1) {
+		if (n > 0) {
+			work(0, n);
+		}
+		return;
+	}
+	// The first n % threads chunks get one element more, so all chunks differ in size by at most one.
+	uint64_t chunkSize = n / threads;
+	uint64_t remainder = n % threads;
+	std::vector<std::thread> workers;
+	uint64_t begin = chunkSize + (remainder > 0 ? 1 : 0); // The first chunk is done by the calling thread.
+	for (uint64_t t = 1; t < threads; t++) {
+		uint64_t end = begin + chunkSize + (t < remainder ? 1 : 0);
+		workers.push_back(std::thread(work, begin, end));
+		begin = end;
+	}
+	work(0, chunkSize + (remainder > 0 ? 1 : 0));
+	for (uint64_t t = 0; t < workers.size(); t++) {
+		workers[t].join();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+/**
+* Resolves the number of worker threads to use.
+* 0 means one thread per hardware thread of the machine.
+*/
+uint64_t resolveThreads(uint64_t threads);
+
+/**
+* Splits the range [0, n) into one contiguous chunk per thread and runs work(begin, end) for every chunk on its own thread.
+* The calling thread works on the first chunk itself and returns after all chunks are done.
+* Since every chunk is contiguous, work that writes to position i of an output array keeps the input order.
+*
+* @param n The number of elements to process.
+* @param threads The number of threads to use. Uses less threads, if there are less elements than threads.
+* @param work The function processing the elements in [begin, end).
+*/
+void parallelFor(uint64_t n, uint64_t threads, const std::function<void(uint64_t begin, uint64_t end)>& work);
\ No newline at end of file
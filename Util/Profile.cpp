@@ -0,0 +1,116 @@
+#include "Profile.h"
+#include "../malloc_count/malloc_count.h"
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <atomic>
+#include <thread>
+
+struct PhaseRecord {
+	std::string name;
+	double milliseconds = 0;
+	size_t startBytes = 0;
+	size_t peakBytes = 0;
+	size_t endBytes = 0;
+	std::chrono::steady_clock::time_point start;
+};
+
+// Whether enableProfile() was called.
+static bool profileEnabled = false;
+
+// The thread that called enableProfile(). Phases of other threads are ignored, the phase list is not synchronized.
+static std::thread::id profileThread;
+
+// All phases in the order they began.
+static std::vector<PhaseRecord> phases;
+
+// The indices into phases of all running phases, the innermost last.
+static std::vector<size_t> runningPhases;
+
+
+void enableProfile() {
+	profileEnabled = true;
+	profileThread = std::this_thread::get_id();
+}
+
+
+void beginPhase(const std::string& name) {
+	if (!profileEnabled || std::this_thread::get_id() != profileThread) {
+		return;
+	}
+	PhaseRecord record;
+	record.name = name;
+	if (!runningPhases.empty()) {
+		// The peak is reset for the child, so the parent keeps the peak it reached so far.
+		PhaseRecord& parent = phases[runningPhases.back()];
+		record.name = parent.name + "/" + name;
+		if (malloc_count_peak() > parent.peakBytes) {
+			parent.peakBytes = malloc_count_peak();
+		}
+	}
+	malloc_count_reset_peak();
+	record.startBytes = malloc_count_current();
+	record.peakBytes = record.startBytes;
+	runningPhases.push_back(phases.size());
+	phases.push_back(record);
+	phases.back().start = std::chrono::steady_clock::now();
+}
+
+
+void endPhase() {
+	if (!profileEnabled || std::this_thread::get_id() != profileThread || runningPhases.empty()) {
+		return;
+	}
+	PhaseRecord& record = phases[runningPhases.back()];
+	record.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - record.start).count();
+	record.endBytes = malloc_count_current();
+	if (malloc_count_peak() > record.peakBytes) {
+		record.peakBytes = malloc_count_peak();
+	}
+	runningPhases.pop_back();
+	if (!runningPhases.empty() && record.peakBytes > phases[runningPhases.back()].peakBytes) {
+		phases[runningPhases.back()].peakBytes = record.peakBytes;
+	}
+	malloc_count_reset_peak();
+}
+
+
+#ifdef ADS_QUERY_STATS
+// The counters of all threads that exited.
+static std::atomic<uint64_t> totalHashProbes(0);
+static std::atomic<uint64_t> totalTreeSteps(0);
+static std::atomic<uint64_t> totalCacheHits(0);
+static std::atomic<uint64_t> totalCacheMisses(0);
+
+thread_local QueryCounters localQueryCounters;
+
+QueryCounters::~QueryCounters() {
+	totalHashProbes += hashProbes;
+	totalTreeSteps += treeSteps;
+	totalCacheHits += cacheHits;
+	totalCacheMisses += cacheMisses;
+}
+#endif
+
+
+bool writeProfile(std::string path, std::string algo, uint64_t queries) {
+	std::ofstream out(path);
+	out << "{\"algo\": \"" << algo << "\", \"queries\": " << queries << ", \"phases\": [";
+	for (size_t i = 0; i < phases.size(); i++) {
+		const PhaseRecord& record = phases[i];
+		out << (i == 0 ? "" : ", ") << "{\"name\": \"" << record.name << "\", \"ms\": " << record.milliseconds << ", \"start_bytes\": " << record.startBytes
+			<< ", \"peak_bytes\": " << record.peakBytes << ", \"end_bytes\": " << record.endBytes << "}";
+	}
+	out << "], \"query_stats\": ";
+#ifdef ADS_QUERY_STATS
+	// The calling thread is still running, so its counters are not part of the totals yet.
+	double divisor = queries == 0 ? 1 : (double)queries;
+	out << "{\"hash_probes_per_query\": " << (totalHashProbes + localQueryCounters.hashProbes) / divisor
+		<< ", \"tree_steps_per_query\": " << (totalTreeSteps + localQueryCounters.treeSteps) / divisor
+		<< ", \"cache_hits\": " << totalCacheHits + localQueryCounters.cacheHits << ", \"cache_misses\": " << totalCacheMisses + localQueryCounters.cacheMisses << "}";
+#else
+	out << "null";
+#endif
+	out << "}" << std::endl;
+	return (bool)out;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+* Records the phases of a program run with their time and heap memory, measured by malloc_count.
+* Phases nest: a phase begun while another one is running becomes its child and is named "parent/child".
+* For every phase, the heap size at its beginning and end, and the highest heap size in between are recorded, including the peaks within its children.
+* Nothing is recorded until enableProfile() is called, so the data structures can begin phases unconditionally.
+* Phases are begun and ended on the thread that enabled profiling, the work inside of them may run on any number of threads. Calls from other threads are ignored, so data structures built on worker threads report no sub-phases.
+*/
+
+/**
+* Starts recording phases.
+*/
+void enableProfile();
+
+/**
+* Begins a phase, which is nested into the currently running one.
+*
+* @param name The name of the phase, without the names of its parents.
+*/
+void beginPhase(const std::string& name);
+
+/**
+* Ends the phase begun last.
+*/
+void endPhase();
+
+/**
+* Writes all recorded phases as JSON object to the given path:
+* {"algo": ..., "queries": ..., "phases": [{"name": ..., "ms": ..., "start_bytes": ..., "peak_bytes": ..., "end_bytes": ...}, ...], "query_stats": ...}
+* The phases are listed in the order they began, so every parent comes before its children.
+* query_stats holds the hash probes and tree steps per query and the total cache hits and misses, if the program is compiled with ADS_QUERY_STATS, and is null otherwise.
+*
+* @param path The file to write.
+* @param algo The kind of queries answered.
+* @param queries The number of queries answered, by which the query counters are divided.
+* @return false, if the file could not be written.
+*/
+bool writeProfile(std::string path, std::string algo, uint64_t queries);
+
+/**
+* Counters of the work done inside the queries, telling where their time goes.
+* They are only counted, if the program is compiled with -DADS_QUERY_STATS, otherwise counting compiles to nothing and the queries are not slowed down.
+* Every thread counts into its own counters, which are added to the totals when the thread exits.
+*/
+#ifdef ADS_QUERY_STATS
+struct QueryCounters {
+	// Slots of the prefix hash tables inspected.
+	uint64_t hashProbes = 0;
+	// Levels of the binary search trees of the buckets descended.
+	uint64_t treeSteps = 0;
+	// Lookups in a QueryCache which found the answer, and which did not.
+	uint64_t cacheHits = 0;
+	uint64_t cacheMisses = 0;
+
+	~QueryCounters();
+};
+
+extern thread_local QueryCounters localQueryCounters;
+
+inline void countHashProbes(uint64_t probes) {
+	localQueryCounters.hashProbes += probes;
+}
+
+inline void countTreeSteps(uint64_t steps) {
+	localQueryCounters.treeSteps += steps;
+}
+
+inline void countCacheHits(uint64_t hits) {
+	localQueryCounters.cacheHits += hits;
+}
+
+inline void countCacheMisses(uint64_t misses) {
+	localQueryCounters.cacheMisses += misses;
+}
+#else
+inline void countHashProbes(uint64_t) {}
+
+inline void countTreeSteps(uint64_t) {}
+
+inline void countCacheHits(uint64_t) {}
+
+inline void countCacheMisses(uint64_t) {}
+#endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "QueryCache.h"
+#include "Profile.h"
+#include <algorithm>
+#include <vector>
+
+// Odd multiplier of the hash, 2^64 divided by the golden ratio.
+const uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+
+void queryWords(uint64_t query, uint64_t* words) {
+	words[0] = query;
+}
+
+void queryWords(const std::pair<uint64_t, uint64_t>& query, uint64_t* words) {
+	words[0] = query.first;
+	words[1] = query.second;
+}
+
+
+template <typename Query>
+typename QueryCache<Query>::Entry& QueryCache<Query>::entryOf(const Query& query) const {
+	uint64_t words[keyWords_];
+	queryWords(query, words);
+	// The top bits of a product depend on all bits of the word, so they pick the entry.
+	uint64_t hash = 0;
+	for (uint64_t w = 0; w < keyWords_; w++) {
+		hash = (hash ^ words[w]) * HASH_MULTIPLIER;
+	}
+	return entries_[hash >> shift_];
+}
+
+
+template <typename Query>
+bool QueryCache<Query>::lookup(const Query& query, uint64_t* answer) const {
+	const Entry& entry = entryOf(query);
+	uint64_t words[keyWords_];
+	queryWords(query, words);
+	uint64_t before = entry.version.load(std::memory_order_acquire);
+	bool match = before != 0 && (before & 1) == 0;
+	for (uint64_t w = 0; w < keyWords_; w++) {
+		match = entry.key[w].load(std::memory_order_relaxed) == words[w] && match;
+	}
+	uint64_t cached = entry.answer.load(std::memory_order_relaxed);
+	// Keeps the reads of the entry before the second read of the version, so a concurrent insert always changes the version in between.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (!match || entry.version.load(std::memory_order_relaxed) != before) {
+		countCacheMisses(1);
+		return false;
+	}
+	countCacheHits(1);
+	*answer = cached;
+	return true;
+}
+
+
+template <typename Query>
+void QueryCache<Query>::insert(const Query& query, uint64_t answer) {
+	Entry& entry = entryOf(query);
+	uint64_t words[keyWords_];
+	queryWords(query, words);
+	uint64_t version = entry.version.load(std::memory_order_relaxed);
+	if ((version & 1) != 0 || !entry.version.compare_exchange_strong(version, version + 1, std::memory_order_relaxed)) { // Another insert writes the entry.
+		return;
+	}
+	// Keeps the odd version before the writes of the entry, so no lookup can see a half written entry with an unchanged version.
+	std::atomic_thread_fence(std::memory_order_release);
+	for (uint64_t w = 0; w < keyWords_; w++) {
+		entry.key[w].store(words[w], std::memory_order_relaxed);
+	}
+	entry.answer.store(answer, std::memory_order_relaxed);
+	entry.version.store(version + 2, std::memory_order_release);
+}
+
+
+template <typename Query>
+void QueryCache<Query>::answerQueries(const Query* queries, size_t n, uint64_t* out, const AnswerFunction& answer) {
+	std::vector<Query> misses;
+	std::vector<size_t> missPositions;
+	std::vector<uint64_t> answers;
+	// The answers of a part are cached before the next part is looked up, so the hot queries of a long batch only miss in its first part.
+	for (size_t begin = 0; begin < n; begin += partSize_) {
+		size_t end = begin + partSize_ < n ? begin + partSize_ : n;
+		misses.clear();
+		missPositions.clear();
+		for (size_t i = begin; i < end; i++) {
+			if (!lookup(queries[i], out + i)) {
+				misses.push_back(queries[i]);
+				missPositions.push_back(i);
+			}
+		}
+		if (misses.empty()) {
+			continue;
+		}
+		answers.resize(misses.size());
+		answer(misses.data(), misses.size(), answers.data());
+		for (size_t k = 0; k < misses.size(); k++) {
+			out[missPositions[k]] = answers[k];
+			insert(misses[k], answers[k]);
+		}
+	}
+}
+
+
+template <typename Query>
+QueryCache<Query>::QueryCache(uint64_t capacity) {
+	uint64_t bits = minCapacityBits_;
+	while ((1ULL << bits) < capacity && bits < 63) {
+		bits++;
+	}
+	shift_ = 64 - bits;
+	entries_.reset(new Entry[1ULL << bits]);
+	for (uint64_t i = 0; i < (1ULL << bits); i++) {
+		entries_[i].version.store(0, std::memory_order_relaxed);
+	}
+}
+
+
+template <typename Query>
+void answerUnique(const Query* queries, size_t n, uint64_t* out, const std::function<void(const Query* queries, size_t n, uint64_t* out)>& answer) {
+	std::vector<size_t> order(n);
+	for (size_t i = 0; i < n; i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [queries](size_t a, size_t b) { return queries[a] < queries[b]; });
+	// The unique queries in sorted order, and for every query the index of its unique query.
+	std::vector<Query> unique;
+	std::vector<size_t> uniqueOf(n);
+	for (size_t i : order) {
+		if (unique.empty() || unique.back() != queries[i]) {
+			unique.push_back(queries[i]);
+		}
+		uniqueOf[i] = unique.size() - 1;
+	}
+	std::vector<uint64_t> answers(unique.size());
+	if (!unique.empty()) {
+		answer(unique.data(), unique.size(), answers.data());
+	}
+	for (size_t i = 0; i < n; i++) {
+		out[i] = answers[uniqueOf[i]];
+	}
+}
+
+
+template class QueryCache<uint64_t>;
+template class QueryCache<std::pair<uint64_t, uint64_t>>;
+template void answerUnique(const uint64_t*, size_t, uint64_t*, const std::function<void(const uint64_t*, size_t, uint64_t*)>&);
+template void answerUnique(const std::pair<uint64_t, uint64_t>*, size_t, uint64_t*, const std::function<void(const std::pair<uint64_t, uint64_t>*, size_t, uint64_t*)>&);
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+
+/**
+* Bounded cache of query answers for skewed workloads, where a few hot queries make up most of the traffic.
+* It is direct mapped: every query has exactly one entry, picked by a multiplicative hash, and a new answer simply replaces whatever was there.
+* So a lookup reads one entry, and the cache never grows beyond its capacity.
+*
+* Any number of threads can look up and insert at the same time without locks.
+* Every entry is guarded by a version, which is odd while the entry is written. Lookups read the version before and after the entry,
+* and only use the answer if the version was even and did not change in between. Inserts which meet another insert on the same entry are dropped.
+* Hits and misses are counted by countCacheHits() and countCacheMisses() (see Util/Profile.h), so they show up in the profile with ADS_QUERY_STATS.
+* Query is the type of one query, uint64_t for predecessor and std::pair<uint64_t, uint64_t> for rmq queries.
+*/
+template <typename Query>
+class QueryCache {
+
+public:
+	// Answers n queries into out.
+	typedef std::function<void(const Query* queries, size_t n, uint64_t* out)> AnswerFunction;
+
+private:
+	// Number of 64 bit words of a query.
+	static const uint64_t keyWords_ = sizeof(Query) / sizeof(uint64_t);
+
+	struct Entry {
+		// 0 for an entry that was never written, odd while it is written.
+		std::atomic<uint64_t> version;
+		std::atomic<uint64_t> key[keyWords_];
+		std::atomic<uint64_t> answer;
+	};
+
+	std::unique_ptr<Entry[]> entries_;
+
+	// The entry of a query is its hash shifted right by this.
+	uint64_t shift_;
+
+	// The cache has at least 2^minCapacityBits_ entries.
+	static const uint64_t minCapacityBits_ = 6;
+
+	// Queries answerQueries() looks up before it answers their misses. Small enough for hot queries to hit early in a batch, large enough for the batch query to prefetch.
+	static const size_t partSize_ = 256;
+
+	/**
+	* Returns the entry of the query.
+	*/
+	Entry& entryOf(const Query& query) const;
+
+public:
+	/**
+	* Looks up the answer of the query. Counts a hit or a miss.
+	*
+	* @param query The query.
+	* @param answer Gets the cached answer, if there is one.
+	* @return Whether the answer was cached.
+	*/
+	bool lookup(const Query& query, uint64_t* answer) const;
+
+	/**
+	* Caches the answer of the query, replacing the query that had its entry before.
+	*/
+	void insert(const Query& query, uint64_t answer);
+
+	/**
+	* Answers the queries from the cache where possible. The queries are looked up in parts of partSize_, the misses of a part are answered by one call of answer,
+	* in their order, and their answers are cached before the next part.
+	*
+	* @param queries The queries.
+	* @param n The number of queries.
+	* @param out The array receiving the answers. Must have space for n answers.
+	* @param answer The function answering the missed queries, usually the batch query of a data structure.
+	*/
+	void answerQueries(const Query* queries, size_t n, uint64_t* out, const AnswerFunction& answer);
+
+	/**
+	* Creates an empty cache.
+	*
+	* @param capacity The number of entries, rounded up to a power of two and at least 64.
+	*/
+	QueryCache(uint64_t capacity);
+};
+
+/**
+* Answers every distinct query of a batch only once: the queries are sorted, the duplicates removed, the unique queries answered by one call of answer
+* in sorted order, and their answers scattered back into out in input order.
+* The sorted order also lets the finger search of the YTrie skip most of the hash table probes.
+*
+* @param queries The queries.
+* @param n The number of queries.
+* @param out The array receiving the answers. Must have space for n answers.
+* @param answer The function answering the unique queries.
+*/
+template <typename Query>
+void answerUnique(const Query* queries, size_t n, uint64_t* out, const std::function<void(const Query* queries, size_t n, uint64_t* out)>& answer);
\ No newline at end of file
@@ -1,2 +1,2 @@
 #! /bin/bash
-g++ -o ads_programm *.cpp Predecessor/*.cpp RMQ/*.cpp malloc_count/*.c
\ No newline at end of file
+g++ -pthread -o ads_programm *.cpp Predecessor/*.cpp RMQ/*.cpp Util/*.cpp IO/*.cpp malloc_count/*.c
\ No newline at end of file
@@ -0,0 +1,2 @@
+#! /bin/bash
+g++ -O2 -pthread -o ads_benchmark Benchmark/*.cpp Predecessor/*.cpp RMQ/*.cpp Util/*.cpp IO/*.cpp malloc_count/*.c
\ No newline at end of file
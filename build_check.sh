@@ -0,0 +1,6 @@
+#! /bin/bash
+# Stops at the first failing command, so the checks only run on a successful build.
+set -e
+# Undefined behaviour found by the sanitizer fails the checks as well.
+g++ -O1 -fsanitize=undefined -fno-sanitize-recover=all -pthread -o ads_check Check/*.cpp Predecessor/*.cpp RMQ/*.cpp Util/*.cpp IO/*.cpp malloc_count/*.c
+./ads_check "$@"
\ No newline at end of file